@@ -1,5 +1,6 @@
 #pragma once
 #include "id_generator.h"
+#include "mesh_manager.h"
 #include "renderer/render_interface.h"
 #include "sapien_material.h"
 #include <PxPhysicsAPI.h>
@@ -171,8 +172,11 @@ public:
                                                   PxVec3 const &inertia);
   std::shared_ptr<ActorBuilder> setScene(SScene *scene);
 
-  SActor *build(bool isKinematic = false, std::string const &name = "") const;
-  SActorStatic *buildStatic(std::string const &name = "") const;
+  /** with reuse, take a deactivated actor of this builder at the current revision when there
+   *  is one; it gets a new id and the properties set here, callbacks and subscriptions added
+   *  to it are dropped */
+  SActor *build(bool isKinematic = false, std::string const &name = "", bool reuse = false) const;
+  SActorStatic *buildStatic(std::string const &name = "", bool reuse = false) const;
 
   SActorStatic *buildGround(PxReal altitude, bool render,
                             std::shared_ptr<SPhysicalMaterial> material,
@@ -181,7 +185,25 @@ public:
 
   virtual ~ActorBuilder() = default;
 
+  /** incremented by every modification, deactivated actors are only reused by build and
+   *  buildStatic when they were built at the current revision */
+  inline uint64_t getRevision() const { return mRevision; }
+
+  /** internal use only, append the mesh files needed by the collision shapes */
+  void collectMeshes(std::vector<std::pair<MeshLoadType, std::string>> &meshes) const;
+
 protected:
+  uint64_t mRevision{0};
+  std::shared_ptr<ActorBuilder> modified() {
+    ++mRevision;
+    return shared_from_this();
+  }
+
+  /** set the name and collision groups of a reused actor as build does */
+  template <class T> void resetReusedActor(T *actor, std::string const &name) const;
+
+  /** import and cook all collision meshes in parallel before building the shapes */
+  void preloadMeshes() const;
   void buildShapes(std::vector<std::unique_ptr<SCollisionShape>> &shapes,
                    std::vector<PxReal> &densities) const;
   void buildVisuals(std::vector<Renderer::IPxrRigidbody *> &renderBodies,
@@ -99,6 +99,7 @@ private:
   bool checkTreeProperties() const;
 
   bool prebuild(std::vector<int> &tosort) const;
+  void preloadMeshes() const;
 };
 
 } // namespace sapien
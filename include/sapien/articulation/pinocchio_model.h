@@ -6,9 +6,19 @@
 #include <pinocchio/algorithm/kinematics.hpp>
 #include <pinocchio/parsers/urdf.hpp>
 
+#include "sapien/job_system.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
 namespace sapien {
 
 class PinocchioModel {
+public:
+  using RowMatrixXd = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+private:
   pinocchio::Model model{};
   pinocchio::Data data{};
 
@@ -22,11 +32,56 @@ class PinocchioModel {
   Eigen::VectorXi NQ;
   Eigen::VectorXi NV;
 
-  Eigen::VectorXd posS2P(const Eigen::VectorXd &qpos);
-  Eigen::VectorXd posP2S(const Eigen::VectorXd &qpos);
+  Eigen::VectorXd posS2P(const Eigen::VectorXd &qpos) const;
+  Eigen::VectorXd posP2S(const Eigen::VectorXd &qpos) const;
 
   std::vector<int> linkIdx2FrameIdx;
 
+  // q indices of single coordinate joints with finite limits
+  std::vector<int> mLimitedQ;
+
+  // preallocated buffers of the CLIK loop
+  struct IKWorkspace {
+    pinocchio::Data::Matrix6x J;
+    Eigen::VectorXd q;
+    Eigen::VectorXd qNext;
+    Eigen::VectorXd v;
+    Eigen::VectorXd bestQ;
+    Eigen::Matrix<double, 6, 1> bestErr;
+  };
+
+  struct BatchContext {
+    explicit BatchContext(pinocchio::Model const &model) : data(model) {}
+    pinocchio::Data data;
+    IKWorkspace ik;
+    // partial derivatives w.r.t. q, v and a (or tau) in Pinocchio order
+    Eigen::MatrixXd dq, dv, da;
+  };
+
+  // batched computation on the process job system, every chunk of rows owns a context
+  uint32_t mBatchThreadCount;
+  std::vector<std::unique_ptr<BatchContext>> mBatchContexts;
+
+  // the compute functions run without the GIL, this guards data, the batch contexts and the
+  // global random generator of pinocchio
+  std::mutex mMutex;
+
+  /** split rows into one chunk per thread and run fn(context, row) for every row */
+  void parallelRows(uint32_t rows, std::function<void(BatchContext &, uint32_t)> const &fn);
+
+  /** mask of active velocity coordinates in Pinocchio order, all active if empty */
+  Eigen::VectorXd getActiveMask(Eigen::VectorXi const &activeQMask) const;
+
+  /** CLIK from ws.q towards oMdes for the parent joint of a link, keeps the configuration with
+   *  the smallest error in ws.bestQ and ws.bestErr; stops early when cancel becomes true
+   *  and returns whether the error dropped below eps */
+  bool runCLIK(pinocchio::Data &d, IKWorkspace &ws, pinocchio::JointIndex jointIdx,
+               pinocchio::SE3 const &oMdes, Eigen::VectorXd const &mask, double eps, int maxIter,
+               double dt, double damp, bool clampLimits,
+               std::atomic<bool> const *cancel = nullptr);
+  /** target of the parent joint from a link pose */
+  pinocchio::SE3 getJointTarget(uint32_t linkIdx, physx::PxTransform const &pose) const;
+
 public:
   static std::unique_ptr<PinocchioModel> fromURDFXML(std::string const &urdf,
                                                      Eigen::Vector3d gravity);
@@ -39,7 +94,7 @@ public:
   inline pinocchio::Data &getInternalData() { return data; }
 
 private:
-  inline PinocchioModel(){};
+  PinocchioModel();
 
 public:
   /** initialize internal permutation matrices by providing joint name*/
@@ -101,6 +156,72 @@ public:
   Eigen::VectorXd computeForwardDynamics(const Eigen::VectorXd &qpos, const Eigen::VectorXd &qvel,
                                          const Eigen::VectorXd &qf);
 
+  /** Analytic derivatives
+   *  all derivatives are taken in SAPIEN joint order, rows are outputs and columns are inputs;
+   *  derivatives w.r.t. qpos are taken on the tangent space, i.e. joint angles for revolute
+   *  joints
+   */
+
+  /** partial derivatives of computeInverseDynamics w.r.t. qpos, qvel and qacc
+   *  the last one is the mass matrix
+   */
+  std::tuple<Eigen::MatrixXd, Eigen::MatrixXd, Eigen::MatrixXd>
+  computeInverseDynamicsDerivatives(const Eigen::VectorXd &qpos, const Eigen::VectorXd &qvel,
+                                    const Eigen::VectorXd &qacc);
+
+  /** partial derivatives of computeForwardDynamics w.r.t. qpos, qvel and qf
+   *  the last one is the inverse mass matrix
+   */
+  std::tuple<Eigen::MatrixXd, Eigen::MatrixXd, Eigen::MatrixXd>
+  computeForwardDynamicsDerivatives(const Eigen::VectorXd &qpos, const Eigen::VectorXd &qvel,
+                                    const Eigen::VectorXd &qf);
+
+  /** partial derivatives of the link velocity w.r.t. qpos and qvel
+   *  the velocity is the spatial twist in world frame, or the body twist if local;
+   *  the derivative w.r.t. qvel is the link Jacobian
+   */
+  std::tuple<Eigen::Matrix<double, 6, Eigen::Dynamic>, Eigen::Matrix<double, 6, Eigen::Dynamic>>
+  computeLinkVelocityDerivatives(const Eigen::VectorXd &qpos, const Eigen::VectorXd &qvel,
+                                 uint32_t index, bool local = false);
+
+  /** time derivative of the link Jacobian at (qpos, qvel), see getLinkJacobian for local */
+  Eigen::Matrix<double, 6, Eigen::Dynamic>
+  computeLinkJacobianTimeVariation(const Eigen::VectorXd &qpos, const Eigen::VectorXd &qvel,
+                                   uint32_t index, bool local = false);
+
+  /** Batched computation
+   *  every row of qpos, qvel and qacc is one configuration, rows are evaluated in parallel
+   *  with one pinocchio::Data per thread; the batched functions do not touch the cached
+   *  results of the single configuration functions
+   */
+
+  /** maximum number of process job system workers used by a batched function besides the
+   *  calling thread, 0 computes on the calling thread */
+  void setBatchThreadCount(uint32_t count);
+  inline uint32_t getBatchThreadCount() const { return mBatchThreadCount; }
+
+  /** link poses of every configuration, [N, links * 7] with rows [x, y, z, qw, qx, qy, qz] */
+  RowMatrixXd computeForwardKinematicsBatch(RowMatrixXd const &qpos);
+
+  /** Jacobian of a link for every configuration, [N * 6, dof]
+   *  see getLinkJacobian for local */
+  RowMatrixXd computeLinkJacobianBatch(RowMatrixXd const &qpos, uint32_t index,
+                                       bool local = false);
+
+  /** computeInverseDynamics for every configuration, [N, dof] */
+  RowMatrixXd computeInverseDynamicsBatch(RowMatrixXd const &qpos, RowMatrixXd const &qvel,
+                                          RowMatrixXd const &qacc);
+
+  /** computeInverseDynamicsDerivatives for every configuration, each result is [N * dof, dof] */
+  std::tuple<RowMatrixXd, RowMatrixXd, RowMatrixXd>
+  computeInverseDynamicsDerivativesBatch(RowMatrixXd const &qpos, RowMatrixXd const &qvel,
+                                         RowMatrixXd const &qacc);
+
+  /** computeForwardDynamicsDerivatives for every configuration, each result is [N * dof, dof] */
+  std::tuple<RowMatrixXd, RowMatrixXd, RowMatrixXd>
+  computeForwardDynamicsDerivativesBatch(RowMatrixXd const &qpos, RowMatrixXd const &qvel,
+                                         RowMatrixXd const &qf);
+
   /** Numerical IK clik algorithm
    *  computes the numerical IK for a given link
    *  https://gepettoweb.laas.fr/doc/stack-of-tasks/pinocchio/master/doxygen-html/md_doc_b-examples_i-inverse-kinematics.html
@@ -111,6 +232,21 @@ public:
                            Eigen::VectorXd const &initialQpos = {},
                            Eigen::VectorXi const &activeJointIndices = {}, double eps = 1e-4,
                            int maxIter = 1000, double dt = 1e-1, double damp = 1e-6);
+
+  /** Multi-start IK for a batch of target poses of one link
+   *
+   *  every target is solved from seedCount seeds in parallel: initialQpos (or the neutral
+   *  configuration) followed by random configurations; the remaining seeds of a target stop as
+   *  soon as one converges. Joints are kept within their limits.
+   *  Returns qpos [targets, dof], success [targets] and the se3 error [targets, 6], the error
+   *  of the best seed is returned for targets without a converged seed
+   */
+  std::tuple<RowMatrixXd, Eigen::Matrix<bool, Eigen::Dynamic, 1>, RowMatrixXd>
+  computeInverseKinematicsMultiSeed(uint32_t linkIdx, std::vector<physx::PxTransform> const &poses,
+                                    uint32_t seedCount = 8, Eigen::VectorXd const &initialQpos = {},
+                                    Eigen::VectorXi const &activeJointIndices = {},
+                                    double eps = 1e-4, int maxIter = 1000, double dt = 1e-1,
+                                    double damp = 1e-6);
 };
 
 }; // namespace sapien
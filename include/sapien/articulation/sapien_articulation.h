@@ -17,6 +17,29 @@ class SScene;
 class SLink;
 class SJoint;
 
+/** bit flags selecting joint state fields, packed in this order by SArticulation::getState */
+namespace ArticulationStateField {
+enum : uint32_t { QPOS = 1 << 0, QVEL = 1 << 1, QACC = 1 << 2, QF = 1 << 3, ALL = 0xf };
+/** number of fields selected by mask */
+inline uint32_t count(uint32_t fields) { return __builtin_popcount(fields & ALL); }
+} // namespace ArticulationStateField
+
+/** drive values of all active joints in external order, null arrays are left unchanged */
+struct SDriveCommand {
+  PxReal const *target{};
+  PxReal const *velocityTarget{};
+  PxReal const *stiffness{};
+  PxReal const *damping{};
+  PxReal const *forceLimit{};
+};
+
+/** Jacobian, mass matrix and passive force of an articulation state, in external order */
+struct SKinematicsBundle {
+  Matrix<PxReal, Dynamic, Dynamic, RowMajor> cartesianJacobian; // [6 * (links - 1), dof]
+  Matrix<PxReal, Dynamic, Dynamic, RowMajor> massMatrix;        // [dof, dof]
+  Matrix<PxReal, Dynamic, 1> passiveForce;                      // gravity + Coriolis, [dof]
+};
+
 class SArticulation : public SArticulationDrivable {
   friend class ArticulationBuilder;
   friend class LinkBuilder;
@@ -37,6 +60,29 @@ class SArticulation : public SArticulationDrivable {
   std::vector<float>
       mDriveMultiplier; // due to physx bug, some drive target needs to be multiplied -1
 
+  // cached kinematics, valid while mKinematicsStep and mKinematicsVersion are current
+  enum KinematicsEntry : uint32_t {
+    CARTESIAN_JACOBIAN = 1 << 0,
+    TWIST_JACOBIAN = 1 << 1,
+    MASS_MATRIX = 1 << 2,
+    GRAVITY_FORCE = 1 << 3,
+    CORIOLIS_FORCE = 1 << 4,
+    PASSIVE_FORCE = 1 << 5,
+    COMMON_INIT = 1 << 6
+  };
+  SKinematicsBundle mKinematics;
+  Matrix<PxReal, Dynamic, Dynamic, RowMajor> mTwistJacobian;
+  Matrix<PxReal, Dynamic, 1> mGravityForce;
+  Matrix<PxReal, Dynamic, 1> mCoriolisForce;
+  uint32_t mKinematicsValid{0};
+  uint64_t mKinematicsStep{0};
+  uint64_t mStateVersion{0};
+  uint64_t mKinematicsVersion{0};
+  /** true if entry is cached for the current state, drops stale entries */
+  bool isKinematicsCached(uint32_t entry);
+  /** prepare PhysX for the dynamics queries once per state */
+  void commonInit();
+
 public:
   std::vector<SLinkBase *> getBaseLinks() override;
   std::vector<SJointBase *> getBaseJoints() override;
@@ -60,6 +106,23 @@ public:
   std::vector<physx::PxReal> getQf() const override;
   void setQf(std::vector<physx::PxReal> const &v) override;
 
+  /** write dof() values in external joint order into out, without allocating */
+  void getQpos(PxReal *out) const;
+  void getQvel(PxReal *out) const;
+  void getQacc(PxReal *out) const;
+  void getQf(PxReal *out) const;
+  /** read dof() values in external joint order from v */
+  void setQpos(PxReal const *v);
+  void setQvel(PxReal const *v);
+  void setQacc(PxReal const *v);
+  void setQf(PxReal const *v);
+
+  /** copy the PhysX cache once and write the selected ArticulationStateField fields to out in
+   *  the order qpos, qvel, qacc, qf; field k starts at out + k * stride, stride 0 means dof() */
+  void getState(uint32_t fields, PxReal *out, uint32_t stride = 0) const;
+  /** inverse of getState, applies all selected fields at once */
+  void setState(uint32_t fields, PxReal const *data, uint32_t stride = 0);
+
   std::vector<std::array<physx::PxReal, 2>> getQlimits() const override;
   void setQlimits(std::vector<std::array<physx::PxReal, 2>> const &v) const override;
 
@@ -69,6 +132,14 @@ public:
   std::vector<physx::PxReal> getDriveVelocityTarget() const;
   void setDriveVelocityTarget(std::vector<physx::PxReal> const &v);
 
+  /** read dof() values in external joint order from v */
+  void setDriveTarget(PxReal const *v);
+  void setDriveVelocityTarget(PxReal const *v);
+
+  /** apply all given drive arrays in a single pass over the active joints and wake up once,
+   *  the drive type of each joint is kept */
+  void applyDriveCommand(SDriveCommand const &command);
+
   void setRootPose(physx::PxTransform const &T) override;
   void setRootVelocity(physx::PxVec3 const &v);
   void setRootAngularVelocity(physx::PxVec3 const &omega);
@@ -81,6 +152,20 @@ public:
 
   void resetCache();
 
+  /* Cached Kinematics
+   * computed on first use after a step or a state change and cached until the next one,
+   * returned references stay valid until then */
+  Matrix<PxReal, Dynamic, Dynamic, RowMajor> const &getWorldCartesianJacobian();
+  Matrix<PxReal, Dynamic, Dynamic, RowMajor> const &getSpatialTwistJacobian();
+  Matrix<PxReal, Dynamic, Dynamic, RowMajor> const &getManipulatorInertiaMatrix();
+  Matrix<PxReal, Dynamic, 1> const &getGravityForce();
+  Matrix<PxReal, Dynamic, 1> const &getCoriolisAndCentrifugalForce();
+  /** Jacobian, mass matrix and passive force from a single cache fill */
+  SKinematicsBundle const &getKinematicsBundle();
+  /** drop cached kinematics, needed after changes the articulation cannot see, such as link
+   *  mass, inertia or geometry changed at runtime through PhysX; changing joint motions calls it */
+  inline void markKinematicsDirty() { ++mStateVersion; }
+
   /* Dynamics Functions */
   std::vector<physx::PxReal> computePassiveForce(bool gravity = true,
                                                  bool coriolisAndCentrifugal = true,
@@ -121,6 +206,20 @@ public:
   std::vector<PxReal> packDrive();
   void unpackDrive(std::vector<PxReal> const &data);
 
+  /** number of values written by packData(PxReal *) */
+  uint32_t getPackedSize() const;
+  void packData(PxReal *data);
+  void unpackData(PxReal const *data);
+
+  /** number of values written by packDrive(PxReal *) */
+  inline uint32_t getPackedDriveSize() const { return dof() * 5; }
+  void packDrive(PxReal *data);
+  void unpackDrive(PxReal const *data);
+
+  /** internal use only, write qpos, qvel and drive targets in external joint order,
+   *  every buffer must hold dof() values */
+  void exportState(PxReal *qpos, PxReal *qvel, PxReal *driveTarget, PxReal *driveVelocityTarget);
+
   bool isBaseFixed() const;
 
 private:
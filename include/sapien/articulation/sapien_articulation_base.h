@@ -18,7 +18,8 @@ enum EArticulationType { DYNAMIC, KINEMATIC };
 
 class SArticulationBase : public SEntity,
                           public EventEmitter<EventArticulationPreDestroy>,
-                          public EventEmitter<EventArticulationStep> {
+                          public EventEmitter<EventArticulationStep>,
+                          public ISubscriberObserver {
   int mDestroyedState{0};
 
   std::shared_ptr<class ArticulationBuilder const> mBuilder{};
@@ -50,8 +51,13 @@ public:
   virtual std::vector<std::array<physx::PxReal, 2>> getQlimits() const = 0;
   virtual void setQlimits(std::vector<std::array<physx::PxReal, 2>> const &v) const = 0;
 
+  /** called by scene before a simulation step for the per-step work of the articulation,
+   *  step events are dispatched by the scene */
   virtual void prestep() = 0;
 
+  /** internal use only, lets the scene track articulations with step subscribers */
+  void onSubscribersChanged() override;
+
   virtual ~SArticulationBase() = default;
 
   std::string exportKinematicsChainAsURDF(bool fixRoot);
@@ -67,7 +73,7 @@ public:
 
   inline std::shared_ptr<ArticulationBuilder const> getBuilder() const { return mBuilder; }
 
-  using SEntity::SEntity;
+  explicit SArticulationBase(SScene *scene);
   std::unique_ptr<PinocchioModel> createPinocchioModel();
 
 private:
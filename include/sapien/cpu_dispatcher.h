@@ -0,0 +1,50 @@
+#pragma once
+#include <PxPhysicsAPI.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "job_system.h"
+
+namespace sapien {
+using namespace physx;
+
+class PxTaskJob;
+
+/** PhysX CPU dispatcher running PhysX tasks on a SAPIEN job system,
+ *  the job system may be owned by a single scene or shared by all scenes of an engine */
+class SapienCpuDispatcher : public PxCpuDispatcher {
+public:
+  explicit SapienCpuDispatcher(std::shared_ptr<JobSystem> jobSystem);
+  SapienCpuDispatcher(SapienCpuDispatcher const &) = delete;
+  SapienCpuDispatcher &operator=(SapienCpuDispatcher const &) = delete;
+  ~SapienCpuDispatcher();
+
+  void submitTask(PxBaseTask &task) override;
+  uint32_t getWorkerCount() const override;
+
+  inline std::shared_ptr<JobSystem> getJobSystem() const { return mJobSystem; }
+
+  /** return a task wrapper to the free list, called from any thread */
+  void releaseJob(PxTaskJob *job);
+
+private:
+  PxTaskJob *acquireJob(PxBaseTask &task);
+  PxTaskJob *getJob(uint32_t index) const;
+
+  static constexpr uint32_t kJobChunkSize = 256;
+  static constexpr uint32_t kMaxJobChunks = 64;
+
+  std::shared_ptr<JobSystem> mJobSystem;
+
+  // task wrappers live in chunks that are never moved or freed before the dispatcher, so a
+  // wrapper stays valid while it sits in the free list; the free list head packs an ABA tag in
+  // the high 32 bits and the index + 1 of the first free wrapper in the low 32 bits
+  std::array<std::atomic<PxTaskJob *>, kMaxJobChunks> mJobChunks{};
+  std::atomic<uint32_t> mJobCount{0};
+  std::atomic<uint64_t> mFreeJobs{0};
+  std::mutex mChunkMutex;
+};
+
+} // namespace sapien
@@ -9,6 +9,13 @@
 namespace sapien {
 template <typename T> class EventEmitter;
 
+/** notified whenever an emitter gains or loses a subscriber */
+class ISubscriberObserver {
+public:
+  virtual void onSubscribersChanged() = 0;
+  virtual ~ISubscriberObserver() = default;
+};
+
 class Subscription {
 public:
   virtual void unsubscribe() = 0;
@@ -44,8 +51,22 @@ public:
 template <typename T> class EventEmitter {
   std::vector<std::shared_ptr<ListenerSubscription<T>>> mListenerSubscriptions;
   std::vector<std::shared_ptr<CallbackSubscription<T>>> mCallbackSubscriptions;
+  ISubscriberObserver *mSubscriberObserver{};
+
+  void notifySubscribersChanged() {
+    if (mSubscriberObserver) {
+      mSubscriberObserver->onSubscribersChanged();
+    }
+  }
 
 public:
+  /** observer to notify on subscription changes, at most one per emitter */
+  void setSubscriberObserver(ISubscriberObserver *observer) { mSubscriberObserver = observer; }
+
+  inline bool hasSubscribers() const {
+    return !mListenerSubscriptions.empty() || !mCallbackSubscriptions.empty();
+  }
+
   std::shared_ptr<Subscription> registerListener(IEventListener<T> &listener) {
     auto it = std::find_if(mListenerSubscriptions.begin(), mListenerSubscriptions.end(),
                            [&](auto &sub) { return sub->mListener == &listener; });
@@ -54,12 +75,14 @@ public:
     }
     auto sub = std::make_shared<ListenerSubscription<T>>(*this, listener);
     mListenerSubscriptions.push_back(sub);
+    notifySubscribersChanged();
     return sub;
   }
 
   std::shared_ptr<Subscription> registerCallback(std::function<void(T &)> callback) {
     auto sub = std::make_shared<CallbackSubscription<T>>(*this, callback);
     mCallbackSubscriptions.push_back(sub);
+    notifySubscribersChanged();
     return sub;
   }
 
@@ -68,6 +91,7 @@ public:
                            [&](auto &sub) { return sub->mListener == &listener; });
     if (it != mListenerSubscriptions.end()) {
       mListenerSubscriptions.erase(it);
+      notifySubscribersChanged();
     }
   }
 
@@ -76,7 +100,24 @@ public:
                         [&](auto &sub) { return sub.get() == &subscription; });
     if (it != mCallbackSubscriptions.end()) {
       mCallbackSubscriptions.erase(it);
+      notifySubscribersChanged();
+    }
+  }
+
+  /** drop all listeners and callbacks */
+  void clearSubscriptions() {
+    if (!hasSubscribers()) {
+      return;
+    }
+    for (auto &l : mListenerSubscriptions) {
+      l->disable();
+    }
+    for (auto &l : mCallbackSubscriptions) {
+      l->disable();
     }
+    mListenerSubscriptions.clear();
+    mCallbackSubscriptions.clear();
+    notifySubscribersChanged();
   }
 
   void emit(T &event) {
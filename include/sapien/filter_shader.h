@@ -1,9 +1,41 @@
 #pragma once
+#include "sapien_scene_config.h"
 #include <PxFiltering.h>
+#include <algorithm>
 
 namespace sapien {
 using namespace physx;
 
+/** bits 16-17 of filter word3 hold the contact report level of a shape plus one, 0 inherits
+ *  the group and scene levels; the lower 16 bits are the collision id group */
+static constexpr uint32_t kContactReportShift = 16;
+static constexpr uint32_t kContactReportMask = 0x3u << kContactReportShift;
+
+/** filter shader constant block, levels are stored plus one so 0 means unset */
+struct ContactReportFilterData {
+  uint32_t sceneLevel{static_cast<uint32_t>(ContactReportLevel::POINTS)};
+  uint32_t groupLevels[32]{};
+};
+
+inline uint32_t GetShapeContactReportLevel(PxFilterData const &data,
+                                           ContactReportFilterData const *config) {
+  uint32_t level = (data.word3 & kContactReportMask) >> kContactReportShift;
+  if (level) {
+    return level - 1;
+  }
+  if (!config) {
+    return static_cast<uint32_t>(ContactReportLevel::POINTS);
+  }
+  // the most detailed level among the contact type groups of the shape
+  uint32_t groupLevel = 0;
+  for (uint32_t groups = data.word0, i = 0; groups; groups >>= 1, ++i) {
+    if ((groups & 1) && config->groupLevels[i] > groupLevel) {
+      groupLevel = config->groupLevels[i];
+    }
+  }
+  return groupLevel ? groupLevel - 1 : config->sceneLevel;
+}
+
 inline PxFilterFlags
 TypeAffinityIgnoreFilterShader(PxFilterObjectAttributes attributes0, PxFilterData filterData0,
                                PxFilterObjectAttributes attributes1, PxFilterData filterData1,
@@ -21,11 +53,21 @@ TypeAffinityIgnoreFilterShader(PxFilterObjectAttributes attributes0, PxFilterDat
   }
 
   if ((filterData0.word0 & filterData1.word1) || (filterData1.word0 & filterData0.word1)) {
-    pairFlags = PxPairFlag::eCONTACT_DEFAULT | PxPairFlag::eNOTIFY_CONTACT_POINTS |
-                PxPairFlag::eNOTIFY_TOUCH_PERSISTS | PxPairFlag::eNOTIFY_TOUCH_FOUND |
-                PxPairFlag::eNOTIFY_TOUCH_LOST | PxPairFlag::ePRE_SOLVER_VELOCITY |
-                PxPairFlag::ePOST_SOLVER_VELOCITY | PxPairFlag::eDETECT_CCD_CONTACT;
+    pairFlags = PxPairFlag::eCONTACT_DEFAULT | PxPairFlag::eDETECT_CCD_CONTACT;
 
+    auto config = constantBlockSize >= sizeof(ContactReportFilterData)
+                      ? static_cast<ContactReportFilterData const *>(constantBlock)
+                      : nullptr;
+    // a pair is reported at the more detailed level of its two shapes
+    uint32_t level = std::max(GetShapeContactReportLevel(filterData0, config),
+                              GetShapeContactReportLevel(filterData1, config));
+    if (level >= static_cast<uint32_t>(ContactReportLevel::TOUCH)) {
+      pairFlags |= PxPairFlag::eNOTIFY_TOUCH_FOUND | PxPairFlag::eNOTIFY_TOUCH_LOST;
+    }
+    if (level >= static_cast<uint32_t>(ContactReportLevel::POINTS)) {
+      pairFlags |= PxPairFlag::eNOTIFY_CONTACT_POINTS | PxPairFlag::eNOTIFY_TOUCH_PERSISTS |
+                   PxPairFlag::ePRE_SOLVER_VELOCITY | PxPairFlag::ePOST_SOLVER_VELOCITY;
+    }
     return PxFilterFlag::eDEFAULT;
   }
   return PxFilterFlag::eKILL;
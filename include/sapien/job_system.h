@@ -0,0 +1,124 @@
+/**
+ * Work-stealing job system shared by the PhysX CPU dispatcher and ThreadPool.
+ *
+ * Notes:
+ * 1. Every worker owns a lock-free Chase-Lev deque. Jobs submitted from a worker go to its own
+ * deque (LIFO for the owner), idle workers steal from the other end of other deques.
+ * 2. Jobs submitted from outside the system go through a FIFO injection queue, so a system with a
+ * single worker executes external jobs in submission order.
+ * 3. Jobs are intrusive: the submitter owns the Job object and the job releases itself (or returns
+ * itself to a pool) in execute. Jobs still queued at shutdown are cancelled instead.
+ *
+ * References:
+ * Chase, Lev. Dynamic Circular Work-Stealing Deque. SPAA 2005.
+ * Le et al. Correct and Efficient Work-Stealing for Weak Memory Models. PPoPP 2013.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sapien {
+
+class Job {
+public:
+  /** run the job, the job is responsible for releasing itself afterwards */
+  virtual void execute() = 0;
+
+  /** called instead of execute for jobs still queued when the system shuts down */
+  virtual void cancel() {}
+
+  virtual ~Job() = default;
+};
+
+class WorkStealingQueue {
+public:
+  static constexpr int64_t kCapacity = 4096;
+
+  /** owner only, returns false when the queue is full */
+  bool push(Job *job);
+  /** owner only, takes the most recently pushed job */
+  Job *pop();
+  /** any thread, takes the oldest job; may spuriously return nullptr under contention */
+  Job *steal();
+
+  bool empty() const;
+
+private:
+  alignas(64) std::atomic<int64_t> mTop{0};
+  alignas(64) std::atomic<int64_t> mBottom{0};
+  alignas(64) std::array<std::atomic<Job *>, kCapacity> mBuffer{};
+};
+
+class JobSystem {
+public:
+  /** create a job system with threadCount workers,
+   *  a non-zero affinityMask pins every worker to the masked CPUs, bit i is CPU i */
+  explicit JobSystem(uint32_t threadCount, uint64_t affinityMask = 0);
+  JobSystem(JobSystem const &) = delete;
+  JobSystem &operator=(JobSystem const &) = delete;
+  ~JobSystem();
+
+  /** submit a job from any thread, a system without workers runs it immediately */
+  void submit(Job *job);
+
+  /** run at most one pending job on the calling thread, used to help while waiting */
+  bool runPendingJob();
+
+  /** run fn(0) ... fn(count - 1) on the workers and wait for all of them, the calling thread
+   *  helps while waiting; the first exception thrown by fn is rethrown after all calls finish */
+  void parallelFor(uint32_t count, std::function<void(uint32_t)> const &fn);
+
+  /** true if the calling thread is a worker of this system */
+  bool isWorkerThread() const;
+
+  inline uint32_t getThreadCount() const { return static_cast<uint32_t>(mWorkers.size()); }
+  inline uint64_t getAffinityMask() const { return mAffinityMask; }
+
+  /** stop the workers after their current job and cancel all pending jobs */
+  void shutdown();
+
+private:
+  struct Worker {
+    JobSystem *system;
+    uint32_t index;
+    WorkStealingQueue queue;
+    std::thread thread;
+  };
+
+  void workerMain(Worker *worker);
+  Job *findJob(Worker *worker);
+  Job *popInjected();
+  bool hasPendingJob() const;
+  void notifyWorker();
+
+  std::vector<std::unique_ptr<Worker>> mWorkers;
+  uint64_t mAffinityMask;
+
+  std::mutex mInjectionMutex;
+  std::deque<Job *> mInjectionQueue;
+  std::atomic<uint32_t> mInjectionSize{0};
+
+  std::mutex mSleepMutex;
+  std::condition_variable mSleepCondition;
+  std::atomic<uint32_t> mSleeping{0};
+  uint64_t mWakeEpoch{0};
+
+  std::atomic<bool> mShutdown{false};
+};
+
+/** process-wide job system for work outside simulation steps, such as batched kinematics and
+ *  mesh loading; one worker per hardware thread but the calling one, created on first use */
+JobSystem &getProcessJobSystem();
+
+} // namespace sapien
@@ -2,12 +2,15 @@
 #include <PxPhysicsAPI.h>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace sapien {
 class Simulation;
 
+enum class MeshLoadType { CONVEX, NON_CONVEX, GROUP };
+
 struct NonConvexMeshRecord {
   bool cached;
   std::string filename;
@@ -30,11 +33,25 @@ private:
   std::string mCacheSuffix = ".convex.stl";
   std::string mCacheSuffixNonConvex = ".nonconvex.stl";
 
+  // cooked PhysX meshes, keyed by the source file content and the cooking parameters
+  std::string mCookedCacheSuffix = ".convex.pxc";
+  std::string mCookedCacheSuffixNonConvex = ".nonconvex.pxc";
+  std::string mCookedCacheSuffixGroup = ".group.pxc";
+  bool mCookedCacheEnabled = true;
+
   Simulation *mSimulation;
+  std::mutex mRegistryMutex;
   std::map<std::string, NonConvexMeshRecord> mNonConvexMeshRegistry;
   std::map<std::string, MeshRecord> mMeshRegistry;
   std::map<std::string, MeshGroupRecord> mMeshGroupRegistry;
 
+  uint32_t mLoaderThreadCount;
+
+  // insert a record unless another thread loaded the same file first, returns the winner
+  physx::PxTriangleMesh *registerNonConvexMesh(NonConvexMeshRecord const &record);
+  physx::PxConvexMesh *registerMesh(MeshRecord const &record);
+  std::vector<physx::PxConvexMesh *> registerMeshGroup(MeshGroupRecord const &record);
+
 public:
   explicit MeshManager(Simulation *simulation);
 
@@ -46,11 +63,30 @@ public:
 
   std::vector<physx::PxConvexMesh *> loadMeshGroup(const std::string &filename);
 
+  /** import and cook the given files in parallel, the load functions above then only look up
+   *  the registry; all load functions are thread-safe */
+  void preloadMeshes(std::vector<std::pair<MeshLoadType, std::string>> const &meshes);
+
+  /** maximum number of process job system workers used by preloadMeshes besides the calling
+   *  thread, 0 loads on the calling thread */
+  void setLoaderThreadCount(uint32_t count);
+  inline uint32_t getLoaderThreadCount() const { return mLoaderThreadCount; }
+
+  /** number of loaded files, a file loaded as several kinds of mesh counts once per kind */
+  uint32_t getLoadedMeshCount();
+
 public:
   // cache config
 
   void setCacheSuffix(const std::string &filename);
   std::string getCachedFilename(const std::string &filename);
   std::string getCachedFilenameNonConvex(const std::string &filename);
+
+  /** cooked caches let later loads skip both mesh import and cooking */
+  inline void setCookedCacheEnabled(bool enabled) { mCookedCacheEnabled = enabled; }
+  inline bool isCookedCacheEnabled() const { return mCookedCacheEnabled; }
+  std::string getCookedCacheFilename(const std::string &filename);
+  std::string getCookedCacheFilenameNonConvex(const std::string &filename);
+  std::string getCookedCacheFilenameGroup(const std::string &filename);
 };
 } // namespace sapien
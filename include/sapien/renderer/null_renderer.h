@@ -0,0 +1,363 @@
+#pragma once
+#include "render_interface.h"
+
+namespace sapien {
+namespace Renderer {
+
+/**
+ * Renderer backend without a GPU. Scenes record their structure and body poses in flat arrays,
+ * cameras keep their poses and intrinsics and return zero-filled images of the right shape and
+ * type. Used to benchmark and test the render update path on machines without Vulkan.
+ */
+
+class NullScene;
+class NullRenderer;
+
+class NullMaterial : public IPxrMaterial {
+public:
+  inline void setBaseColor(std::array<float, 4> color) override { mBaseColor = color; }
+  [[nodiscard]] inline std::array<float, 4> getBaseColor() const override { return mBaseColor; }
+  inline void setRoughness(float roughness) override { mRoughness = roughness; }
+  [[nodiscard]] inline float getRoughness() const override { return mRoughness; }
+  inline void setSpecular(float specular) override { mSpecular = specular; }
+  [[nodiscard]] inline float getSpecular() const override { return mSpecular; }
+  inline void setMetallic(float metallic) override { mMetallic = metallic; }
+  [[nodiscard]] inline float getMetallic() const override { return mMetallic; }
+
+private:
+  std::array<float, 4> mBaseColor{1.f, 1.f, 1.f, 1.f};
+  float mRoughness{1.f};
+  float mSpecular{0.f};
+  float mMetallic{0.f};
+};
+
+class NullRenderMesh : public IRenderMesh {
+public:
+  NullRenderMesh(std::vector<float> const &vertices, std::vector<uint32_t> const &indices)
+      : mVertices(vertices), mIndices(indices) {}
+
+  inline std::vector<float> getVertices() override { return mVertices; }
+  inline std::vector<float> getNormals() override { return mNormals; }
+  inline std::vector<float> getUVs() override { return mUVs; }
+  inline std::vector<float> getTangents() override { return mTangents; }
+  inline std::vector<float> getBitangents() override { return mBitangents; }
+  inline std::vector<uint32_t> getIndices() override { return mIndices; }
+
+  inline void setVertices(std::vector<float> const &v) override { mVertices = v; }
+  inline void setNormals(std::vector<float> const &v) override { mNormals = v; }
+  inline void setUVs(std::vector<float> const &v) override { mUVs = v; }
+  inline void setTangents(std::vector<float> const &v) override { mTangents = v; }
+  inline void setBitangents(std::vector<float> const &v) override { mBitangents = v; }
+  inline void setIndices(std::vector<uint32_t> const &v) override { mIndices = v; }
+
+private:
+  std::vector<float> mVertices;
+  std::vector<float> mNormals;
+  std::vector<float> mUVs;
+  std::vector<float> mTangents;
+  std::vector<float> mBitangents;
+  std::vector<uint32_t> mIndices;
+};
+
+class NullRenderShape : public IPxrRenderShape {
+public:
+  NullRenderShape(std::shared_ptr<IRenderMesh> mesh, std::shared_ptr<IPxrMaterial> material)
+      : mMesh(mesh), mMaterial(material) {}
+
+  [[nodiscard]] std::shared_ptr<IRenderMesh> getGeometry() const override { return mMesh; }
+  [[nodiscard]] std::shared_ptr<IPxrMaterial> getMaterial() const override { return mMaterial; }
+  void setMaterial(std::shared_ptr<IPxrMaterial> material) override { mMaterial = material; }
+
+private:
+  std::shared_ptr<IRenderMesh> mMesh;
+  std::shared_ptr<IPxrMaterial> mMaterial;
+};
+
+class NullRigidbody : public IPxrRigidbody {
+public:
+  NullRigidbody(NullScene *scene, uint32_t index, physx::PxGeometryType::Enum type,
+                physx::PxVec3 const &scale, std::vector<std::shared_ptr<IPxrRenderShape>> shapes);
+
+  inline void setName(std::string const &name) override { mName = name; }
+  inline std::string getName() const override { return mName; }
+
+  void setUniqueId(uint32_t uniqueId) override;
+  uint32_t getUniqueId() const override;
+  void setSegmentationId(uint32_t segmentationId) override;
+  uint32_t getSegmentationId() const override;
+  inline void setSegmentationCustomData(std::vector<float> const &customData) override {
+    mCustomData = customData;
+  }
+  inline void setInitialPose(const physx::PxTransform &transform) override {
+    mInitialPose = transform;
+  }
+  inline physx::PxTransform getInitialPose() const override { return mInitialPose; }
+  void update(const physx::PxTransform &transform) override;
+  inline void setVisibility(float visibility) override { mVisibility = visibility; }
+  inline void setVisible(bool visible) override { mVisibility = visible ? 1.f : 0.f; }
+  inline float getVisibility() const { return mVisibility; }
+  inline void setRenderMode(uint32_t mode) override { mRenderMode = mode; }
+  inline void setShadeFlat(bool shadeFlat) override { mShadeFlat = shadeFlat; }
+  inline bool getShadeFlat() override { return mShadeFlat; }
+
+  inline physx::PxGeometryType::Enum getType() const override { return mType; }
+  inline physx::PxVec3 getScale() const override { return mScale; }
+  inline std::vector<std::shared_ptr<IPxrRenderShape>> getRenderShapes() override {
+    return mShapes;
+  }
+
+  void destroy() override;
+
+  /** slot of the body in the flat arrays of its scene */
+  inline uint32_t getIndex() const { return mIndex; }
+  inline void setIndex(uint32_t index) { mIndex = index; }
+
+private:
+  NullScene *mScene;
+  uint32_t mIndex;
+  std::string mName;
+  physx::PxGeometryType::Enum mType;
+  physx::PxVec3 mScale;
+  std::vector<std::shared_ptr<IPxrRenderShape>> mShapes;
+  std::vector<float> mCustomData;
+  physx::PxTransform mInitialPose{physx::PxIdentity};
+  float mVisibility{1.f};
+  uint32_t mRenderMode{0};
+  bool mShadeFlat{false};
+};
+
+class NullCamera : public ICamera {
+public:
+  NullCamera(NullScene *scene, uint32_t width, uint32_t height, float fovy, float near, float far);
+
+  [[nodiscard]] inline physx::PxTransform getPose() const override { return mPose; }
+  inline void setPose(physx::PxTransform const &pose) override { mPose = pose; }
+  IPxrScene *getScene() override;
+
+  inline uint32_t getWidth() const override { return mWidth; }
+  inline uint32_t getHeight() const override { return mHeight; }
+
+  [[nodiscard]] inline float getPrincipalPointX() const override { return mCx; }
+  [[nodiscard]] inline float getPrincipalPointY() const override { return mCy; }
+  [[nodiscard]] inline float getFocalX() const override { return mFx; }
+  [[nodiscard]] inline float getFocalY() const override { return mFy; }
+  [[nodiscard]] inline float getNear() const override { return mNear; }
+  [[nodiscard]] inline float getFar() const override { return mFar; }
+  [[nodiscard]] inline float getSkew() const override { return mSkew; }
+
+  void setPerspectiveCameraParameters(float near, float far, float fx, float fy, float cx,
+                                      float cy, float skew) override;
+
+  /** Segmentation is a 4-channel uint32 image, every other texture a 4-channel float image */
+  std::vector<float> getFloatImage(std::string const &name) override;
+  std::vector<uint32_t> getUintImage(std::string const &name) override;
+  std::string getImageFormat(std::string const &name) override;
+
+  inline void takePicture() override { ++mPictureCount; }
+  inline uint64_t getPictureCount() const { return mPictureCount; }
+
+private:
+  NullScene *mScene;
+  physx::PxTransform mPose{physx::PxIdentity};
+  uint32_t mWidth;
+  uint32_t mHeight;
+  float mCx;
+  float mCy;
+  float mFx;
+  float mFy;
+  float mNear;
+  float mFar;
+  float mSkew{0.f};
+  uint64_t mPictureCount{0};
+};
+
+class NullPointLight : public IPointLight {
+public:
+  inline physx::PxTransform getPose() const override { return mPose; }
+  inline void setPose(physx::PxTransform const &transform) override { mPose = transform; }
+  inline physx::PxVec3 getColor() const override { return mColor; }
+  inline void setColor(physx::PxVec3 color) override { mColor = color; }
+  inline bool getShadowEnabled() const override { return mShadow; }
+  inline void setShadowEnabled(bool enabled) override { mShadow = enabled; }
+  inline physx::PxVec3 getPosition() const override { return mPose.p; }
+  inline void setPosition(physx::PxVec3 position) override { mPose.p = position; }
+  inline void setShadowParameters(float near, float far) override {
+    mShadowNear = near;
+    mShadowFar = far;
+  }
+  inline float getShadowNear() const override { return mShadowNear; }
+  inline float getShadowFar() const override { return mShadowFar; }
+
+private:
+  physx::PxTransform mPose{physx::PxIdentity};
+  physx::PxVec3 mColor{0.f};
+  bool mShadow{false};
+  float mShadowNear{0.f};
+  float mShadowFar{0.f};
+};
+
+class NullDirectionalLight : public IDirectionalLight {
+public:
+  inline physx::PxTransform getPose() const override { return mPose; }
+  inline void setPose(physx::PxTransform const &transform) override { mPose = transform; }
+  inline physx::PxVec3 getColor() const override { return mColor; }
+  inline void setColor(physx::PxVec3 color) override { mColor = color; }
+  inline bool getShadowEnabled() const override { return mShadow; }
+  inline void setShadowEnabled(bool enabled) override { mShadow = enabled; }
+  inline physx::PxVec3 getDirection() const override { return mDirection; }
+  inline void setDirection(physx::PxVec3 direction) override { mDirection = direction; }
+  inline void setShadowParameters(float halfSize, float near, float far) override {
+    mShadowHalfSize = halfSize;
+    mShadowNear = near;
+    mShadowFar = far;
+  }
+  inline float getShadowHalfSize() const override { return mShadowHalfSize; }
+  inline float getShadowNear() const override { return mShadowNear; }
+  inline float getShadowFar() const override { return mShadowFar; }
+
+private:
+  physx::PxTransform mPose{physx::PxIdentity};
+  physx::PxVec3 mColor{0.f};
+  physx::PxVec3 mDirection{1.f, 0.f, 0.f};
+  bool mShadow{false};
+  float mShadowHalfSize{0.f};
+  float mShadowNear{0.f};
+  float mShadowFar{0.f};
+};
+
+class NullSpotLight : public ISpotLight {
+public:
+  inline physx::PxTransform getPose() const override { return mPose; }
+  inline void setPose(physx::PxTransform const &transform) override { mPose = transform; }
+  inline physx::PxVec3 getColor() const override { return mColor; }
+  inline void setColor(physx::PxVec3 color) override { mColor = color; }
+  inline bool getShadowEnabled() const override { return mShadow; }
+  inline void setShadowEnabled(bool enabled) override { mShadow = enabled; }
+  inline physx::PxVec3 getPosition() const override { return mPose.p; }
+  inline void setPosition(physx::PxVec3 position) override { mPose.p = position; }
+  inline physx::PxVec3 getDirection() const override { return mDirection; }
+  inline void setDirection(physx::PxVec3 direction) override { mDirection = direction; }
+  inline void setShadowParameters(float near, float far) override {
+    mShadowNear = near;
+    mShadowFar = far;
+  }
+  inline void setFov(float fov) override { mFov = fov; }
+  inline float getFov() const override { return mFov; }
+  inline float getShadowNear() const override { return mShadowNear; }
+  inline float getShadowFar() const override { return mShadowFar; }
+
+private:
+  physx::PxTransform mPose{physx::PxIdentity};
+  physx::PxVec3 mColor{0.f};
+  physx::PxVec3 mDirection{1.f, 0.f, 0.f};
+  bool mShadow{false};
+  float mFov{0.f};
+  float mShadowNear{0.f};
+  float mShadowFar{0.f};
+};
+
+class NullScene : public IPxrScene {
+public:
+  // number of floats of a body pose in the flat pose array: px py pz qw qx qy qz
+  static constexpr uint32_t kPoseSize = 7;
+
+  NullScene(NullRenderer *parent, std::string const &name);
+
+  inline std::string getName() const { return mName; }
+
+  //========== Body ==========//
+  IPxrRigidbody *addRigidbody(const std::string &meshFile, const physx::PxVec3 &scale) override;
+  IPxrRigidbody *addRigidbody(std::shared_ptr<IRenderMesh> mesh, const physx::PxVec3 &scale,
+                              std::shared_ptr<IPxrMaterial> material) override;
+  IPxrRigidbody *addRigidbody(physx::PxGeometryType::Enum type, const physx::PxVec3 &scale,
+                              std::shared_ptr<IPxrMaterial> material) override;
+  IPxrRigidbody *addRigidbody(physx::PxGeometryType::Enum type, const physx::PxVec3 &scale,
+                              const physx::PxVec3 &color) override;
+  IPxrRigidbody *addRigidbody(std::vector<physx::PxVec3> const &vertices,
+                              std::vector<physx::PxVec3> const &normals,
+                              std::vector<uint32_t> const &indices, const physx::PxVec3 &scale,
+                              std::shared_ptr<IPxrMaterial> material) override;
+  IPxrRigidbody *addRigidbody(std::vector<physx::PxVec3> const &vertices,
+                              std::vector<physx::PxVec3> const &normals,
+                              std::vector<uint32_t> const &indices, const physx::PxVec3 &scale,
+                              const physx::PxVec3 &color) override;
+
+  void removeRigidbody(IPxrRigidbody *body) override;
+
+  //========== Camera ==========//
+  ICamera *addCamera(uint32_t width, uint32_t height, float fovy, float near, float far,
+                     std::string const &shaderDir = "") override;
+  void removeCamera(ICamera *camera) override;
+  std::vector<ICamera *> getCameras() override;
+
+  //========== Light ==========//
+  inline void setAmbientLight(std::array<float, 3> const &color) override {
+    mAmbientLight = color;
+  }
+  inline std::array<float, 3> getAmbientLight() const override { return mAmbientLight; }
+
+  IPointLight *addPointLight(std::array<float, 3> const &position,
+                             std::array<float, 3> const &color, bool enableShadow,
+                             float shadowNear, float shadowFar, uint32_t shadowMapSize) override;
+  IDirectionalLight *addDirectionalLight(std::array<float, 3> const &direction,
+                                         std::array<float, 3> const &color, bool enableShadow,
+                                         std::array<float, 3> const &position, float shadowScale,
+                                         float shadowNear, float shadowFar,
+                                         uint32_t shadowMapSize) override;
+  ISpotLight *addSpotLight(std::array<float, 3> const &position,
+                           std::array<float, 3> const &direction, float fovInner, float fovOuter,
+                           std::array<float, 3> const &color, bool enableShadow, float shadowNear,
+                           float shadowFar, uint32_t shadowMapSize) override;
+  IActiveLight *addActiveLight(physx::PxTransform const &pose, std::array<float, 3> const &color,
+                               float fov, std::string_view texPath, float shadowNear,
+                               float shadowFar, uint32_t shadowMapSize) override {
+    throw std::runtime_error("Active light is not supported for the null renderer");
+  }
+  void removeLight(ILight *light) override;
+
+  void updateRender() override;
+  void updateRenderAndTakePictures(std::vector<ICamera *> const &cameras) override;
+
+  void destroy() override;
+
+  //========== Flat arrays ==========//
+  void setBodyPose(uint32_t index, physx::PxTransform const &pose);
+  inline std::vector<float> const &getBodyPoses() const { return mBodyPoses; }
+  // unique id and segmentation id of every body
+  inline std::vector<uint32_t> const &getBodyIds() const { return mBodyIds; }
+  inline std::vector<uint32_t> &getBodyIds() { return mBodyIds; }
+
+  inline uint64_t getUpdateCount() const { return mUpdateCount; }
+
+private:
+  NullRigidbody *addBody(physx::PxGeometryType::Enum type, physx::PxVec3 const &scale,
+                         std::vector<std::shared_ptr<IPxrRenderShape>> shapes);
+
+  NullRenderer *mParentRenderer;
+  std::string mName;
+  std::vector<std::unique_ptr<NullRigidbody>> mBodies;
+  std::vector<std::unique_ptr<NullCamera>> mCameras;
+  std::vector<std::unique_ptr<ILight>> mLights;
+  std::array<float, 3> mAmbientLight{0.f, 0.f, 0.f};
+
+  // indexed by body index, removing a body moves the last body into its slot
+  std::vector<float> mBodyPoses;
+  std::vector<uint32_t> mBodyIds;
+
+  uint64_t mUpdateCount{0};
+};
+
+class NullRenderer : public IPxrRenderer {
+public:
+  IPxrScene *createScene(std::string const &name) override;
+  void removeScene(IPxrScene *scene) override;
+  std::shared_ptr<IPxrMaterial> createMaterial() override;
+  std::shared_ptr<IRenderMesh> createMesh(std::vector<float> const &vertices,
+                                          std::vector<uint32_t> const &indices) override;
+
+private:
+  std::vector<std::unique_ptr<NullScene>> mScenes;
+};
+
+} // namespace Renderer
+} // namespace sapien
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "common.h"
+#include "shared_memory.h"
 #include "renderer/server/protos/render_server.grpc.pb.h"
 #include "sapien/renderer/render_interface.h"
 #include <grpc/grpc.h>
 #include <grpcpp/grpcpp.h>
+#include <mutex>
 
 namespace sapien {
 namespace Renderer {
@@ -350,8 +352,24 @@ public:
 
   ClientRenderer *getRenderer() { return mRenderer; }
 
+  /** wait until the server has applied every frame sent through the ring */
+  void waitFrames();
+  /** the server may not have applied the frames in flight, send a full frame next */
+  inline void invalidateFrames() { mSentBodyPoses.clear(); }
+
 private:
   void syncId();
+  /** send body poses changed since the last frame and all camera poses,
+   *  then take pictures with the given cameras */
+  void streamRender(std::vector<ICamera *> const &cameras);
+  /** set up the shared memory ring, falls back to gRPC if the server cannot map it */
+  void openSharedRing();
+  /** send a frame through the ring, waiting only if too many frames are in flight,
+   *  returns false if the frame does not fit in the ring */
+  bool sendSharedFrame(PackedFrame &frame);
+  void waitSharedAck(uint64_t frame);
+  /** stop using a ring closed by the server, later frames go through gRPC */
+  void dropSharedRing(std::string const &reason);
 
   ClientRenderer *mRenderer;
   rs_id_t mId;
@@ -360,11 +378,30 @@ private:
   std::vector<std::unique_ptr<ClientCamera>> mCameras;
   std::vector<std::unique_ptr<ILight>> mLights;
   bool mIdSynced{false};
+
+  // packed body poses of the current frame and of the last frame sent to the server,
+  // empty sent poses force a full frame
+  std::vector<float> mBodyPoses;
+  std::vector<float> mSentBodyPoses;
+
+  // frame buffers reused across frames
+  std::vector<uint32_t> mChangedBodies;
+  std::vector<float> mChangedPoses;
+  std::vector<float> mCameraPoses;
+  std::vector<uint64_t> mPictureCameras;
+
+  bool mSharedRingOpened{false};
+  std::unique_ptr<SharedFrameRing> mSharedRing;
+  uint64_t mSharedFrameCount{0};
+  uint64_t mSharedFrameAcked{0};
 };
 
 class ClientRenderer : public IPxrRenderer, public std::enable_shared_from_this<ClientRenderer> {
 public:
-  ClientRenderer(std::string const &address, uint64_t processIndex);
+  /** sharedMemory sends render frames through shared memory when the server is on this host,
+   *  maxFramesInFlight is the number of frames sent before waiting for the server */
+  ClientRenderer(std::string const &address, uint64_t processIndex, bool sharedMemory = true,
+                 uint32_t maxFramesInFlight = 1);
 
   ClientScene *createScene(std::string const &name) override;
   void removeScene(IPxrScene *scene) override;
@@ -379,11 +416,69 @@ public:
 
   inline uint64_t getProcessIndex() const { return mProcessIndex; }
 
+  /** reserve an id for an entity whose creation is queued */
+  rs_id_t reserveId();
+  /** queue a scene construction or setter call, calls are applied in order and sent in batches
+   *  without waiting for the server; a failed batch throws from a later call */
+  void enqueue(proto::SceneBatchOp &&op);
+  /** send the queued calls and wait until the server has applied them */
+  void flush();
+  /** wait until the server has applied every frame and queued call */
+  void synchronize();
+
+  /** send a frame on the render stream, waiting only if too many frames are in flight,
+   *  a broken stream throws and is reopened by the next frame */
+  void sendFrame(rs_id_t sceneId, PackedFrame const &frame);
+  /** wait until the server has applied every frame sent on the render stream */
+  void waitStreamFrames();
+
+  inline uint32_t getMaxFramesInFlight() const { return mMaxFramesInFlight; }
+
+  inline bool isSharedMemoryEnabled() const { return mSharedMemory; }
+  /** false if the server is known to be unreachable */
+  bool isConnected() const;
+
+  ~ClientRenderer();
+
 private:
+  struct SceneBatchCall {
+    grpc::ClientContext context;
+    proto::SceneBatchReq req;
+    proto::Empty res;
+    grpc::Status status;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<proto::Empty>> reader;
+  };
+
+  // the batch mutex must be held
+  void sendBatch();
+  void waitBatch();
+
+  // the stream mutex must be held
+  void readAck();
+  [[noreturn]] void failStream();
+  void closeStream();
+
   uint64_t mProcessIndex;
+  bool mSharedMemory;
+  uint32_t mMaxFramesInFlight;
   std::shared_ptr<grpc::Channel> mChannel;
   std::unique_ptr<proto::RenderService::Stub> mStub;
 
+  // queued calls, at most one batch is in flight so batches apply in order; batches and frames
+  // never overlap on the server
+  std::mutex mBatchMutex;
+  proto::SceneBatchReq mBatch;
+  std::unique_ptr<SceneBatchCall> mBatchCall;
+  grpc::CompletionQueue mBatchQueue;
+  rs_id_t mNextId{0};
+  rs_id_t mEndId{0};
+
+  std::mutex mStreamMutex;
+  std::unique_ptr<grpc::ClientContext> mStreamContext;
+  std::unique_ptr<grpc::ClientReaderWriter<proto::RenderFrame, proto::RenderFrameAck>> mStream;
+  uint64_t mFrameCount{0};
+  uint32_t mStreamFramesInFlight{0};
+
   std::vector<std::unique_ptr<ClientScene>> mScenes;
 };
 
@@ -2,11 +2,13 @@
 #include "common.h"
 #include "renderer/server/protos/render_server.grpc.pb.h"
 #include "safe_map.h"
+#include "shared_memory.h"
 #include "sapien/thread_pool.hpp"
 #include <grpc/grpc.h>
 #include <grpcpp/grpcpp.h>
 #include <memory>
 #include <shared_mutex>
+#include <thread>
 #include <svulkan2/core/context.h>
 #include <svulkan2/renderer/renderer.h>
 #include <svulkan2/resource/manager.h>
@@ -34,6 +36,9 @@ class RenderServiceImpl final : public proto::RenderService::Service {
   Status RemoveScene(ServerContext *c, const proto::Id *req, proto::Empty *res) override;
   Status CreateMaterial(ServerContext *c, const proto::Empty *req, proto::Id *res) override;
   Status RemoveMaterial(ServerContext *c, const proto::Id *req, proto::Empty *res) override;
+  Status ReserveIds(ServerContext *c, const proto::Uint32 *req, proto::Id *res) override;
+  Status BuildSceneBatch(ServerContext *c, const proto::SceneBatchReq *req,
+                         proto::Empty *res) override;
   // ========== Scene ==========//
   Status AddBodyMesh(ServerContext *c, const proto::AddBodyMeshReq *req, proto::Id *res) override;
   Status AddBodyPrimitive(ServerContext *c, const proto::AddBodyPrimitiveReq *req,
@@ -52,6 +57,11 @@ class RenderServiceImpl final : public proto::RenderService::Service {
   Status UpdateRenderAndTakePictures(ServerContext *c,
                                      const proto::UpdateRenderAndTakePicturesReq *req,
                                      proto::Empty *res) override;
+  Status StreamRender(
+      ServerContext *c,
+      grpc::ServerReaderWriter<proto::RenderFrameAck, proto::RenderFrame> *stream) override;
+  Status OpenSharedRing(ServerContext *c, const proto::SharedRingReq *req,
+                        proto::Empty *res) override;
   // ========== Material ==========//
   Status SetBaseColor(ServerContext *c, const proto::IdVec4 *req, proto::Empty *res) override;
   Status SetRoughness(ServerContext *c, const proto::IdFloat *req, proto::Empty *res) override;
@@ -85,7 +95,8 @@ private:
   std::shared_ptr<svulkan2::core::Context> mContext;
   std::shared_ptr<svulkan2::resource::SVResourceManager> mResourceManager;
 
-  std::atomic<uint64_t> mIdGenerator{0};
+  // ids start from 1, a create request with id 0 asks the server to generate one
+  std::atomic<uint64_t> mIdGenerator{1};
 
   struct CameraInfo {
     uint64_t cameraIndex;
@@ -118,8 +129,30 @@ private:
     std::vector<svulkan2::scene::Camera *> orderedCameras;
 
     std::unique_ptr<ThreadPool> threadRunner;
+
+    // frames from a client on the same host, applied on ringThread
+    std::unique_ptr<SharedFrameRing> ring;
+    std::thread ringThread;
+
+    ~SceneInfo() {
+      if (ring) {
+        ring->close();
+      }
+      if (ringThread.joinable()) {
+        ringThread.join();
+      }
+    }
   };
 
+  void createMaterial(rs_id_t id);
+
+  // submit rendering and copying of a camera to the scene thread
+  void takePicture(SceneInfo &info, rs_id_t cameraId);
+  // apply the poses of a frame and take its pictures
+  Status renderFrame(SceneInfo &info, PackedFrame const &frame);
+  // render the frames of a shared memory ring until it is closed
+  void runSharedRing(SceneInfo *info);
+
   // store materials on an object
   ts_unordered_map<rs_id_t, std::weak_ptr<svulkan2::resource::SVMetallicMaterial>>
       mObjectMaterialMap;
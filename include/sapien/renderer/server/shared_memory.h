@@ -0,0 +1,124 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sapien {
+namespace Renderer {
+namespace server {
+
+// number of floats in a packed pose: px py pz qw qx qy qz
+static constexpr uint32_t kPackedPoseSize = 7;
+
+/** view of a render frame, the data is owned by the message or ring it was read from */
+struct PackedFrame {
+  uint64_t frame{};
+  // bodyPoses holds every body in entity order, otherwise the bodies in bodyIndices
+  bool full{};
+  uint32_t const *bodyIndices{};
+  uint32_t bodyIndexCount{};
+  // packed poses, not necessarily aligned
+  char const *bodyPoses{};
+  uint32_t bodyCount{};
+  char const *cameraPoses{};
+  uint32_t cameraCount{};
+  // cameras to take pictures with after the update
+  uint64_t const *cameraIds{};
+  uint32_t cameraIdCount{};
+};
+
+/** client side, fill the body poses of a frame with the poses that differ from sentPoses, or with
+ *  every pose if the number of bodies changed; the frame points into poses and changedPoses */
+void encodeBodyPoses(std::vector<float> const &poses, std::vector<float> const &sentPoses,
+                     std::vector<uint32_t> &changedIndices, std::vector<float> &changedPoses,
+                     PackedFrame &frame);
+
+/** server side, check the body poses of a frame against a scene of bodyCount bodies,
+ *  returns an error message, empty if every pose can be applied */
+std::string checkBodyPoses(PackedFrame const &frame, uint32_t bodyCount);
+
+/** index of the i-th body pose of a frame */
+inline uint32_t getBodyIndex(PackedFrame const &frame, uint32_t i) {
+  return frame.full ? i : frame.bodyIndices[i];
+}
+
+/** single-waiter event in shared memory, ringing only enters the kernel when someone sleeps */
+struct SharedDoorbell {
+  std::atomic<uint32_t> sequence{0};
+  std::atomic<uint32_t> waiting{0};
+
+  void ring();
+  /** wait until the sequence differs from seen, returns false on timeout */
+  bool wait(uint32_t seen, std::chrono::microseconds timeout);
+};
+
+struct SharedRingHeader;
+
+/**
+ * Frame ring in POSIX shared memory, for a render client and a render server on the same host.
+ * The client creates the ring for a scene and writes frames, the server opens it by name, applies
+ * frames in order and acknowledges them. Frames too large for the ring go through gRPC instead.
+ */
+class SharedFrameRing {
+public:
+  /** create and map a new segment, the client side */
+  static std::unique_ptr<SharedFrameRing> create(std::string const &name, uint64_t capacity);
+  /** map an existing segment, the server side */
+  static std::unique_ptr<SharedFrameRing> open(std::string const &name);
+
+  SharedFrameRing(SharedFrameRing const &) = delete;
+  SharedFrameRing &operator=(SharedFrameRing const &) = delete;
+  ~SharedFrameRing();
+
+  /** remove the name of the segment, the mappings stay valid */
+  void unlink();
+
+  /** producer, copy a frame into the ring and notify the consumer,
+   *  returns false if the frame can never fit in the ring; throws if no room frees up in time */
+  bool push(PackedFrame const &frame, std::chrono::microseconds timeout);
+  /** producer, wait until the frame is acknowledged, returns false on timeout;
+   *  throws if the consumer rejected a frame */
+  bool waitAck(uint64_t frame, std::chrono::microseconds timeout);
+
+  /** consumer, wait for the next frame, returns false on timeout or close;
+   *  the poses point into the ring until release, the body indices and camera ids are copies
+   *  owned by the ring, so the producer cannot change them after they are checked.
+   *  A malformed record rejects the frame, closes the ring and throws */
+  bool pop(PackedFrame &frame, std::chrono::microseconds timeout);
+  /** consumer, free the popped frame and acknowledge it, a non-empty error rejects it */
+  void release(std::string const &error = "");
+
+  /** wake and stop both sides */
+  void close();
+  bool isClosed() const;
+
+  inline std::string const &getName() const { return mName; }
+  /** offset of the ring data in the segment */
+  static uint64_t getDataOffset();
+
+private:
+  SharedFrameRing(std::string name, int fd, void *data, size_t size);
+  /** consumer, reject the ring and close it */
+  [[noreturn]] void fail(std::string const &error);
+
+  std::string mName;
+  int mFd;
+  void *mData;
+  size_t mSize;
+  SharedRingHeader *mHeader;
+  char *mRing;
+  uint64_t mCapacity;
+
+  // consumer state of the popped frame
+  uint64_t mPoppedFrame{};
+  uint64_t mPoppedSize{};
+  std::vector<uint32_t> mPoppedIndices;
+  std::vector<uint64_t> mPoppedCameraIds;
+};
+
+} // namespace server
+} // namespace Renderer
+} // namespace sapien
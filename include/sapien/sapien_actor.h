@@ -21,6 +21,11 @@ class SActor : public SActorDynamicBase {
 private:
   PxRigidDynamic *mActor = nullptr;
 
+  // mass properties set by the builder, restored when the actor is reused
+  PxReal mBuiltMass{};
+  PxVec3 mBuiltInertia{};
+  PxTransform mBuiltCMassPose{PxIdentity};
+
 public:
   PxRigidDynamic *getPxActor() const override;
   void setPose(PxTransform const &pose);
@@ -40,6 +45,9 @@ public:
 
   std::vector<PxReal> packData() override;
   void unpackData(std::vector<PxReal> const &data) override;
+  uint32_t getPackedSize() const override;
+  void packData(PxReal *data) override;
+  void unpackData(PxReal const *data) override;
 
 private:
   /* Only actor builder can create actor */
@@ -61,6 +69,9 @@ public:
 
   std::vector<PxReal> packData() override;
   void unpackData(std::vector<PxReal> const &data) override;
+  uint32_t getPackedSize() const override;
+  void packData(PxReal *data) override;
+  void unpackData(PxReal const *data) override;
 
 public:
   void destroy();
@@ -7,6 +7,7 @@
 #include "sapien_trigger.h"
 #include <PxPhysicsAPI.h>
 #include <functional>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -38,7 +39,8 @@ class SActorBase : public SEntity,
                    public EventEmitter<EventActorPreDestroy>,
                    public EventEmitter<EventActorStep>,
                    public EventEmitter<EventActorContact>,
-                   public EventEmitter<EventActorTrigger> {
+                   public EventEmitter<EventActorTrigger>,
+                   public ISubscriberObserver {
 protected:
   // std::string mName{""};
   physx_id_t mId{0};
@@ -51,17 +53,22 @@ protected:
   uint32_t mCol2{0};
   uint32_t mCol3{0};
 
+  std::optional<ContactReportLevel> mContactReportLevel{};
+
   bool collisionRender{false};
   bool mHidden{false};
   float mDisplayVisibility{1.f};
 
   int mDestroyedState{0};
+  PxTransform mCachedPose{PxIdentity};
+  bool mRenderQueued{false};
 
   std::vector<StepCallback> mOnStepCallback;
   std::vector<ContactCallback> mOnContactCallback;
   std::vector<TriggerCallback> mOnTriggerCallback;
 
   std::shared_ptr<class ActorBuilder const> mBuilder{};
+  uint64_t mBuilderRevision{};
 
 public:
   void renderCollisionBodies(bool collision);
@@ -72,11 +79,26 @@ public:
   bool isHidingVisual() const;
 
   inline physx_id_t getId() { return mId; }
+  /** while the scene is stepping, returns the pose cached before the step started */
   PxTransform getPose() const override;
 
+  /** internal use only, cache the pose to report while the scene is stepping */
+  inline void cachePose() { mCachedPose = getPxActor()->getGlobalPose(); }
+
+  /** internal use only, whether the actor is queued for the next render update */
+  inline bool isRenderQueued() const { return mRenderQueued; }
+  inline void setRenderQueued(bool queued) { mRenderQueued = queued; }
+
   void attachShape(std::unique_ptr<SCollisionShape> shape);
   std::vector<SCollisionShape *> getCollisionShapes() const;
 
+  /** contact report level of all shapes of this actor, including shapes attached later;
+   *  nullopt lets the shapes inherit the group and scene levels */
+  void setContactReportLevel(std::optional<ContactReportLevel> level);
+  inline std::optional<ContactReportLevel> getContactReportLevel() const {
+    return mContactReportLevel;
+  }
+
   // render
   std::vector<Renderer::IPxrRigidbody *> getRenderBodies();
   std::vector<Renderer::IPxrRigidbody *> getCollisionBodies();
@@ -86,9 +108,13 @@ public:
   virtual EActorType getType() const = 0;
   virtual ~SActorBase() = default;
 
-  // called by scene to notify a simulation step is about to happen
+  /** called by scene before a simulation step for the per-step work of the actor,
+   *  step events are dispatched by the scene */
   virtual void prestep();
 
+  /** internal use only, lets the scene track actors with step subscribers */
+  void onSubscribersChanged() override;
+
   void setDisplayVisibility(float visibility);
   float getDisplayVisibility() const;
 
@@ -109,7 +135,20 @@ public:
   inline virtual std::vector<PxReal> packData() { return {}; };
   inline virtual void unpackData(std::vector<PxReal> const &data){};
 
+  /** number of values written by packData */
+  inline virtual uint32_t getPackedSize() const { return 0; }
+  /** write getPackedSize() values to data */
+  inline virtual void packData(PxReal *data){};
+  /** read getPackedSize() values from data */
+  inline virtual void unpackData(PxReal const *data){};
+
+  /** internal use only, give a pooled actor a new id and drop the state set after it was
+   *  built: subscriptions, callbacks, contact report level and display settings */
+  void resetForReuse(physx_id_t id);
+
   inline std::shared_ptr<ActorBuilder const> getBuilder() const { return mBuilder; }
+  /** revision of the builder when this actor was built, see ActorBuilder::getRevision */
+  inline uint64_t getBuilderRevision() const { return mBuilderRevision; }
 
   // callback from python
   void onContact(ContactCallback callback);
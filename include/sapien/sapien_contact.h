@@ -1,4 +1,6 @@
 #pragma once
+#include "id_generator.h"
+#include "utils/id_table.hpp"
 #include <PxPhysicsAPI.h>
 #include <vector>
 
@@ -15,13 +17,115 @@ struct SContactPoint {
   PxReal separation;
 };
 
+/** contact points of a pair, they live in the scene contact buffer until the next step */
+struct SContactPointSpan {
+  SContactPoint const *data{};
+  uint32_t count{};
+
+  inline SContactPoint const *begin() const { return data; }
+  inline SContactPoint const *end() const { return data + count; }
+  inline uint32_t size() const { return count; }
+  inline bool empty() const { return count == 0; }
+  inline SContactPoint const &operator[](uint32_t i) const { return data[i]; }
+};
+
 struct SContact {
   SActorBase *actors[2];
   SCollisionShape *collisionShapes[2];
+  physx_id_t actorIds[2];
   bool starts;
   bool ends;
   bool persists;
-  std::vector<SContactPoint> points;
+  SContactPointSpan points;
+  uint32_t pointOffset; // index of the first point in the contact buffer
+};
+
+/** a copy of a contact that owns its points, it stays valid across steps */
+struct SOwnedContact : public SContact {
+  std::vector<SContactPoint> ownedPoints;
+
+  inline explicit SOwnedContact(SContact const &contact)
+      : SContact(contact), ownedPoints(contact.points.begin(), contact.points.end()) {
+    rebind();
+  }
+  inline SOwnedContact(SOwnedContact const &other)
+      : SContact(other), ownedPoints(other.ownedPoints) {
+    rebind();
+  }
+  inline SOwnedContact(SOwnedContact &&other) noexcept
+      : SContact(other), ownedPoints(std::move(other.ownedPoints)) {
+    rebind();
+  }
+  SOwnedContact &operator=(SOwnedContact const &) = delete;
+
+private:
+  inline void rebind() {
+    points = {ownedPoints.data(), static_cast<uint32_t>(ownedPoints.size())};
+    pointOffset = 0;
+  }
+};
+
+/**
+ * Contacts of a scene stored in flat arrays that are reused every step.
+ *
+ * Pairs reported during fetchResults are staged by addContact. endStep then merges them with
+ * the still active pairs of the previous step (e.g. sleeping ones, which PhysX does not report
+ * again), so that no pointer is handed out before the arrays stop growing.
+ */
+class SContactBuffer {
+public:
+  /** start collecting the contacts of a new step */
+  void beginStep();
+
+  /** stage one reported pair */
+  void addContact(PxContactPairHeader const &header, PxContactPair const &pair);
+
+  /** finish the step, returns the contacts reported in this step in report order */
+  std::vector<SContact> const &endStep();
+
+  /** active contacts, i.e. contacts that started or persist, valid until the next step */
+  inline std::vector<SContact> const &getContacts() const { return mActive; }
+  /** points of all contacts, indexed by SContact::pointOffset */
+  inline std::vector<SContactPoint> const &getPoints() const { return mPoints; }
+
+  /** drop active contacts for which pred(contact) is true */
+  template <typename Pred> void removeIf(Pred pred) {
+    for (auto &c : mActive) {
+      if (pred(c)) {
+        mIndex.erase(keyOf(c));
+      }
+    }
+    std::erase_if(mActive, pred);
+    for (uint32_t i = 0; i < mActive.size(); ++i) {
+      mIndex.insert_or_assign(keyOf(mActive[i]), i);
+    }
+  }
+
+private:
+  using ShapePair = std::pair<PxShape *, PxShape *>;
+  struct ShapePairHash {
+    inline size_t operator()(ShapePair const &pair) const {
+      // pointers are aligned, mix the bits so the low ones used by the table vary
+      uint64_t x = reinterpret_cast<uint64_t>(pair.first) * 31 +
+                   reinterpret_cast<uint64_t>(pair.second);
+      x ^= x >> 33;
+      x *= 0xff51afd7ed558ccdull;
+      x ^= x >> 33;
+      return x;
+    }
+  };
+  static ShapePair keyOf(SContact const &contact);
+
+  // values of mIndex refer to mReported while tagged, to the previous active array otherwise
+  static constexpr uint32_t kReportedTag = 1u << 31;
+
+  std::vector<SContact> mReported;
+  std::vector<SContact> mActive;
+  std::vector<SContact> mPrevActive;
+  std::vector<SContactPoint> mPoints;
+  std::vector<SContactPoint> mPrevPoints;
+  std::vector<PxContactPairPoint> mExtractBuffer;
+  utils::FlatHashMap<ShapePair, uint32_t, ShapePairHash> mIndex;
 };
 
 } // namespace sapien
@@ -15,25 +15,32 @@
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <future>
 
 #include <PxPhysicsAPI.h>
 
+#include "cpu_dispatcher.h"
 #include "event_system/event_system.h"
 #include "extension.h"
+#include "filter_shader.h"
 #include "id_generator.h"
 #include "renderer/render_interface.h"
 #include "sapien_camera.h"
+#include "sapien_contact.h"
 #include "sapien_light.h"
 #include "sapien_material.h"
 #include "sapien_scene_config.h"
+#include "scene_snapshot.h"
 #include "simulation_callback.h"
 
 #include "thread_pool.hpp"
+#include "utils/id_table.hpp"
 
 namespace sapien {
 class SActor;
@@ -41,9 +48,12 @@ class SActorStatic;
 class SLink;
 class SLinkBase;
 class SActorBase;
+enum class EActorType;
 class SEntityParticle;
+class SArticulationBase;
 class SArticulation;
 class SKArticulation;
+struct SDriveCommand;
 class Simulation;
 class ActorBuilder;
 class LinkBuilder;
@@ -69,6 +79,29 @@ struct SceneData {
   std::map<physx_id_t, std::vector<PxReal>> mArticulationDriveData;
 };
 
+/** Structure-of-arrays copy of the dynamic state of a scene
+ *  actor rows cover actors and articulation links, articulation rows cover dynamic
+ *  articulations and are zero padded to the largest dof
+ *  poses are [x, y, z, qw, qx, qy, qz], velocities are [vx, vy, vz, wx, wy, wz]
+ *  a new buffer is allocated whenever actors or articulations are added or removed
+ */
+struct SceneStateBuffer {
+  uint32_t actorCount{};
+  uint32_t articulationCount{};
+  uint32_t maxDof{};
+
+  std::vector<physx_id_t> actorIds;    // [actorCount]
+  std::vector<PxReal> actorPoses;      // [actorCount, 7]
+  std::vector<PxReal> actorVelocities; // [actorCount, 6]
+
+  std::vector<physx_id_t> articulationIds; // [articulationCount], id of the root link
+  std::vector<uint32_t> articulationDofs;  // [articulationCount]
+  std::vector<PxReal> qpos;                // [articulationCount, maxDof]
+  std::vector<PxReal> qvel;                // [articulationCount, maxDof]
+  std::vector<PxReal> driveTargets;        // [articulationCount, maxDof]
+  std::vector<PxReal> driveVelocityTargets; // [articulationCount, maxDof]
+};
+
 class SScene : public EventEmitter<EventSceneStep> {
 
   friend ActorBuilder;
@@ -131,9 +164,47 @@ public:
   std::future<void> stepAsync();
   std::future<void> multistepAsync(int steps, SceneMultistepCallback *callback);
 
+  /** start a step and return immediately
+   *  until #endStep is called, actor poses report the state before this step,
+   *  so it is safe to update the renderer while PhysX computes the next frame
+   */
+  void beginStep();
+  /** block until the step started by #beginStep finishes */
+  void endStep();
+  inline bool isStepping() const { return mStepping; }
+  /** number of finished simulation steps */
+  inline uint64_t getStepCount() const { return mStepCount; }
+
+  /** internal use only, run per-step work of actors and articulations, emit their step events
+   *  and confirm removals */
+  void prestep();
+  /** internal use only, block until the running PhysX step finishes and fetch its results */
+  void waitForResults();
+  /** internal use only, emit the scene step event */
+  void emitStepEvent();
+  /** internal use only, called when an actor or articulation gains or loses step subscribers */
+  inline void markStepSubscribersDirty() { mStepSubscribersDirty = true; }
+  /** internal use only, called when the angular velocity of an actor is set from outside PhysX */
+  inline void markVelocityChanged(SActorBase *actor) { mVelocityChangedActors.push_back(actor); }
+
 private:
   PxReal mTimestep = 1 / 500.f;
   std::string mName;
+  bool mStepping{false};
+  uint64_t mStepCount{0};
+
+  void cachePoses();
+
+  // only actors and articulations with step subscribers receive step events, the lists are
+  // rebuilt when subscriptions change or objects leave the scene
+  bool mStepSubscribersDirty{true};
+  std::vector<SActorBase *> mStepSubscribedActors;
+  std::vector<SArticulationBase *> mStepSubscribedArticulations;
+  void updateStepSubscribers();
+
+  // only spinning dynamic actors need per-step work (gyroscopic torque), these are the actors
+  // PhysX reported active in the last step and the ones whose velocity was set since then
+  std::vector<SActorBase *> mVelocityChangedActors;
 
   /************************************************
    * Physical Objects
@@ -172,6 +243,27 @@ public:
    */
   void removeKinematicArticulation(SKArticulation *articulation);
 
+  /** Object pools
+   *  a deactivated actor or articulation leaves the PhysX scene and is hidden, but keeps its
+   *  PhysX objects, shapes and render bodies until it is activated again or removed; drives
+   *  and gears attached to it are removed. ActorBuilder::build and buildStatic with reuse
+   *  take a deactivated actor of the same unmodified builder instead of building a new one.
+   *  These functions cannot be called while the scene is stepping.
+   */
+  void deactivateActor(SActorBase *actor);
+  /** put a deactivated actor back into the scene at pose with zero velocity */
+  void activateActor(SActorBase *actor, PxTransform const &pose);
+  void deactivateArticulation(SArticulation *articulation);
+  /** put a deactivated articulation back into the scene at root pose with zero velocities,
+   *  joint positions are kept */
+  void activateArticulation(SArticulation *articulation, PxTransform const &rootPose);
+  bool isActive(SActorBase *actor) const;
+  bool isActive(SArticulation *articulation) const;
+  inline uint32_t getInactiveActorCount() const { return mInactiveActors.size(); }
+  inline uint32_t getInactiveArticulationCount() const { return mInactiveArticulations.size(); }
+  /** remove all deactivated actors and articulations */
+  void clearInactiveObjects();
+
   SDrive6D *createDrive(SActorBase *actor1, PxTransform const &pose1, SActorBase *actor2,
                         PxTransform const &pose2);
   /** Remove a drive immediately */
@@ -198,11 +290,23 @@ private:
 
   void removeCleanUp();
 
+  /** activate a deactivated actor built by builder at the given revision with a new id,
+   *  or return nullptr; the builder resets the properties it sets */
+  SActorBase *reuseActor(ActorBuilder const *builder, uint64_t revision, EActorType type);
+  void eraseFromActorPool(SActorBase *actor);
+  void hideForPool(SActorBase *actor);
+  void unhideFromPool(SActorBase *actor);
+
+  /** release the drives and gears attached to an actor, found through the adjacency index */
+  void removeJointsOf(SActorBase *actor);
+  void eraseDrive(SDrive *drive);
+  void eraseGear(SGear *gear);
+
   IDGenerator mActorIdGenerator;  // unique id generator for actors (including links)
   IDGenerator mRenderIdGenerator; //  unique id generator for visuals
 
-  std::map<physx_id_t, SActorBase *> mActorId2Actor;
-  std::map<physx_id_t, SLinkBase *> mActorId2Link;
+  utils::DenseIdTable<SActorBase> mActorId2Actor;
+  utils::DenseIdTable<SLinkBase> mActorId2Link;
 
   std::vector<std::unique_ptr<SActorBase>> mActors; // manages all actors
   std::vector<std::unique_ptr<SArticulation>> mArticulations;
@@ -214,6 +318,44 @@ private:
   std::vector<std::unique_ptr<SDrive>> mDrives;
   std::vector<std::unique_ptr<SGear>> mGears;
 
+  // storage positions for swap-and-pop removal, the storage order changes on removal
+  std::unordered_map<SActorBase *, uint32_t> mActorIndex;
+  std::unordered_map<SArticulation *, uint32_t> mArticulationIndex;
+  std::unordered_map<SKArticulation *, uint32_t> mKinematicArticulationIndex;
+  std::unordered_map<SDrive *, uint32_t> mDriveIndex;
+  std::unordered_map<SGear *, uint32_t> mGearIndex;
+
+  // drives and gears attached to every actor or link
+  std::unordered_map<SActorBase *, std::vector<SDrive *>> mActorDrives;
+  std::unordered_map<SActorBase *, std::vector<SGear *>> mActorGears;
+
+  // deactivated objects, kept out of the lists above
+  std::vector<std::unique_ptr<SActorBase>> mInactiveActors;
+  std::vector<std::unique_ptr<SArticulation>> mInactiveArticulations;
+  std::unordered_map<SActorBase *, uint32_t> mInactiveActorIndex;
+  std::unordered_map<SArticulation *, uint32_t> mInactiveArticulationIndex;
+
+  // deactivated actors by the builder, builder revision and type they were built with
+  struct ActorPoolKey {
+    ActorBuilder const *builder;
+    uint64_t revision;
+    EActorType type;
+    bool operator==(ActorPoolKey const &other) const = default;
+  };
+  struct ActorPoolKeyHash {
+    size_t operator()(ActorPoolKey const &key) const {
+      size_t h = std::hash<ActorBuilder const *>{}(key.builder);
+      h ^= std::hash<uint64_t>{}(key.revision) + 0x9e3779b9 + (h << 6) + (h >> 2);
+      return h ^ (static_cast<size_t>(key.type) << 1);
+    }
+  };
+  std::unordered_map<ActorPoolKey, std::vector<SActorBase *>, ActorPoolKeyHash> mActorPool;
+
+  // objects marked for removal, released by removeCleanUp
+  std::vector<SActorBase *> mRemovedActors;
+  std::vector<SArticulation *> mRemovedArticulations;
+  std::vector<SKArticulation *> mRemovedKinematicArticulations;
+
   /************************************************
    * Sensor
    ***********************************************/
@@ -225,8 +367,23 @@ public:
 
   std::vector<SCamera *> getCameras();
 
+  /** removing objects moves the last object into the removed slot, so the order of
+   *  getAllActors and getAllArticulations is not preserved across removals */
   std::vector<SActorBase *> getAllActors() const;
   std::vector<SArticulationBase *> getAllArticulations() const;
+
+  /** write getState(fields) of every articulation into out, shaped
+   *  [articulations, field count, stride] and zero padded; stride 0 uses the largest dof */
+  void getArticulationStates(std::vector<SArticulation *> const &articulations, uint32_t fields,
+                             PxReal *out, uint32_t stride = 0) const;
+  /** inverse of getArticulationStates */
+  void setArticulationStates(std::vector<SArticulation *> const &articulations, uint32_t fields,
+                             PxReal const *data, uint32_t stride = 0);
+
+  /** apply a drive command to every articulation, each array of command is shaped
+   *  [articulations, stride]; stride 0 uses the largest dof */
+  void applyDriveCommands(std::vector<SArticulation *> const &articulations,
+                          SDriveCommand const &command, uint32_t stride = 0);
   std::vector<SLight *> getAllLights() const;
 
   void setAmbientLight(PxVec3 const &color);
@@ -260,12 +417,25 @@ public:
   void updateRender();
   void updateRenderAndTakePictures(std::vector<SCamera *> const &cameras);
   std::future<void> updateRenderAsync();
+
+  /** Render synchronization
+   *  updateRender only pushes the poses of bodies that may have moved since the last update:
+   *  bodies reported active by PhysX, bodies moved through SAPIEN and newly added bodies;
+   *  static and sleeping bodies are skipped.
+   *  Call markRenderDirty after moving PhysX objects directly.
+   */
+  void markRenderDirty(SActorBase *actor);
+  void markRenderDirty(SArticulationBase *articulation);
+  /** push every pose in the next render update */
+  void markAllRenderDirty();
   SActorStatic *addGround(PxReal altitude, bool render = true,
                           std::shared_ptr<SPhysicalMaterial> material = nullptr,
                           std::shared_ptr<Renderer::IPxrMaterial> renderMaterial = nullptr,
                           PxVec2 const &renderSize = {1.f, 1.f});
 
-  std::map<physx_id_t, std::string> findRenderId2VisualName() const;
+  /** visual names indexed by render id, empty for unused ids; rebuilt after actors or
+   *  articulations are added or removed */
+  std::vector<std::string> const &findRenderId2VisualName();
 
   ThreadPool &getThread();
 
@@ -280,21 +450,89 @@ private:
    * Contact
    ***********************************************/
 public:
-  void updateContact(std::unique_ptr<SContact> contact);
-  std::vector<SContact *> getContacts() const;
+  /** internal use only, contact buffer filled by the simulation event callback */
+  inline SContactBuffer &getContactBuffer() { return mContactBuffer; }
+  /** contacts active after the last step, valid until the next step */
+  inline std::vector<SContact> const &getContacts() const { return mContactBuffer.getContacts(); }
+  /** points of the contacts, indexed by SContact::pointOffset */
+  inline std::vector<SContactPoint> const &getContactPoints() const {
+    return mContactBuffer.getPoints();
+  }
+
+  /** contact report level of shapes without an actor or group level */
+  void setContactReportLevel(ContactReportLevel level);
+  ContactReportLevel getContactReportLevel() const;
+
+  /** contact report level of shapes in contact type group (group0 bit) 1 to 32, nullopt clears
+   *  it; a shape in several groups uses the most detailed of their levels */
+  void setGroupContactReportLevel(uint32_t group, std::optional<ContactReportLevel> level);
+  std::optional<ContactReportLevel> getGroupContactReportLevel(uint32_t group) const;
+
+private:
+  /** upload the contact report levels to the filter shader and filter all pairs again,
+   *  callers reject changes while the scene is stepping */
+  void updateContactReportFilter();
+  ContactReportFilterData mContactReportFilter{};
+
+public:
 
   SceneData packScene();
   void unpackScene(SceneData const &data);
 
+  /** write a binary snapshot of actors, articulations and drives, buffer is reused */
+  void saveSnapshot(std::vector<uint8_t> &buffer);
+  std::vector<uint8_t> saveSnapshot();
+  /** restore a snapshot written by saveSnapshot, entities not in the snapshot are unchanged */
+  void restoreSnapshot(uint8_t const *data, size_t size);
+  inline void restoreSnapshot(std::vector<uint8_t> const &buffer) {
+    restoreSnapshot(buffer.data(), buffer.size());
+  }
+
+  /** number of snapshots kept for rollback, 0 disables the history */
+  void setSnapshotHistoryCapacity(uint32_t capacity);
+  inline uint32_t getSnapshotHistoryCapacity() const { return mSnapshotHistory.getCapacity(); }
+  inline uint32_t getSnapshotHistorySize() const { return mSnapshotHistory.size(); }
+  /** save a snapshot into the history */
+  void pushSnapshot();
+  /** restore the snapshot saved `steps` pushes before the most recent one and drop newer
+   *  snapshots, the restored snapshot stays in the history */
+  void rollback(uint32_t steps = 0);
+
+  /** when enabled, the state buffer is refreshed after every step */
+  void enableStateBuffer(bool enable);
+  inline bool isStateBufferEnabled() const { return mStateBufferEnabled; }
+  /** refresh the state buffer from the current PhysX state */
+  void updateStateBuffer();
+  std::shared_ptr<SceneStateBuffer> getStateBuffer();
+
 private:
   SceneConfig mConfig{};
 
-  std::map<std::pair<PxShape *, PxShape *>, std::unique_ptr<SContact>> mContacts;
+  SContactBuffer mContactBuffer;
+
+  std::vector<std::string> mRenderId2VisualName;
+  bool mRenderId2VisualNameDirty{true};
+
+  SnapshotHistory mSnapshotHistory;
+
+  bool mStateBufferEnabled{false};
+  bool mStateBufferLayoutDirty{true};
+  std::shared_ptr<SceneStateBuffer> mStateBuffer;
+  std::vector<SActorBase *> mStateBufferActors;
+  std::vector<SArticulation *> mStateBufferArticulations;
+  void rebuildStateBufferLayout();
 
   ThreadPool mRunnerThread{1};
   std::mutex mUpdateRenderMutex;
 
-  PxDefaultCpuDispatcher *mCpuDispatcher = nullptr;
+  // bodies whose render poses are pushed in the next render update
+  std::mutex mRenderDirtyMutex;
+  std::vector<SActorBase *> mRenderDirtyActors;
+  bool mRenderAllDirty{true};
+  void collectActiveActors();
+  void syncRenderPoses();
+
+  std::unique_ptr<SapienCpuDispatcher> mCpuDispatcher;
   bool mDisableCollisionVisual{};
 };
 } // namespace sapien
@@ -3,6 +3,13 @@
 
 namespace sapien {
 
+/** how much contact information PhysX extracts and reports for a colliding pair */
+enum class ContactReportLevel : uint32_t {
+  NONE = 0,   // contacts are solved but never reported
+  TOUCH = 1,  // start and end of touch, without contact points
+  POINTS = 2  // start, persist and end of touch with contact points
+};
+
 struct SceneConfig {
   Eigen::Vector3f gravity = {0, 0, -9.81}; // default gravity
   float static_friction = 0.3f;            // default static friction coefficient
@@ -21,5 +28,12 @@ struct SceneConfig {
       true;                         // better friction calculation, recommended for robotics
   bool enableAdaptiveForce = false; // improve solver convergence
   bool disableCollisionVisual = false;   // do not create visual shapes for collisions
+
+  uint32_t threadCount = 0;         // PhysX worker threads of this scene, 0 uses the engine count
+  bool shareThreadPool = false;     // step on the engine-wide PhysX worker pool
+  uint64_t threadAffinityMask = 0;  // CPU affinity of scene workers, 0 lets the OS decide
+
+  // default contact report level of shapes without an actor or group level
+  ContactReportLevel contactReportLevel = ContactReportLevel::POINTS;
 };
 } // namespace sapien
@@ -1,6 +1,8 @@
 #pragma once
+#include "sapien_scene_config.h"
 #include <PxPhysicsAPI.h>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -64,6 +66,11 @@ public:
   void setCollisionGroups(uint32_t group0, uint32_t group1, uint32_t group2, uint32_t group3);
   std::array<uint32_t, 4> getCollisionGroups() const;
 
+  /** contact report level of this shape, overrides the group and scene levels;
+   *  nullopt inherits them */
+  void setContactReportLevel(std::optional<ContactReportLevel> level);
+  std::optional<ContactReportLevel> getContactReportLevel() const;
+
   void setRestOffset(physx::PxReal offset);
   physx::PxReal getRestOffset() const;
 
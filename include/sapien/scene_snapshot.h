@@ -0,0 +1,69 @@
+/**
+ * Flat binary scene snapshot.
+ *
+ * Layout: SnapshotHeader | SnapshotEntry[actorCount + articulationCount] | PxReal data
+ *
+ * Actor entries come first, followed by articulation entries. Every entry refers to a range of
+ * the data block; an articulation range holds its packed state followed by its packed drives.
+ * Offsets are in bytes from the start of the snapshot, so a snapshot written to a file can be
+ * memory-mapped and restored directly.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "id_generator.h"
+
+namespace sapien {
+
+constexpr uint32_t kSnapshotMagic = 0x4e535053; // "SPSN"
+constexpr uint32_t kSnapshotVersion = 1;
+
+struct SnapshotHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t actorCount;
+  uint32_t articulationCount;
+  uint64_t size; // total size in bytes
+};
+
+struct SnapshotEntry {
+  physx_id_t id;       // actor id, or root link id for articulations
+  uint32_t offset;     // byte offset of the first value
+  uint32_t count;      // number of state values
+  uint32_t driveCount; // number of drive values following the state, 0 for actors
+};
+
+static_assert(sizeof(SnapshotHeader) == 24);
+static_assert(sizeof(SnapshotEntry) == 16);
+
+/** Fixed size ring of recent snapshots, buffers are reused once the ring is full */
+class SnapshotHistory {
+public:
+  explicit SnapshotHistory(uint32_t capacity = 0);
+
+  /** resize the ring, the most recent snapshots are kept */
+  void setCapacity(uint32_t capacity);
+  inline uint32_t getCapacity() const { return static_cast<uint32_t>(mBuffers.size()); }
+  inline uint32_t size() const { return mSize; }
+
+  /** get a buffer for a new snapshot, the oldest one is overwritten when the ring is full */
+  std::vector<uint8_t> &push();
+
+  /** get a snapshot, 0 is the most recent */
+  std::vector<uint8_t> const &get(uint32_t index) const;
+
+  /** drop the count most recent snapshots */
+  void pop(uint32_t count);
+
+  void clear();
+
+private:
+  std::vector<std::vector<uint8_t>> mBuffers;
+  uint32_t mNext{0}; // slot of the next push
+  uint32_t mSize{0};
+};
+
+} // namespace sapien
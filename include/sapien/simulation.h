@@ -15,10 +15,12 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 
 #include <PxPhysicsAPI.h>
 
 // TODO(jigu): check whether to replace with forward declaration
+#include "job_system.h"
 #include "mesh_manager.h"
 #include "renderer/render_interface.h"
 #include "sapien_material.h"
@@ -48,6 +50,13 @@ public:
 
   std::unique_ptr<SScene> createScene(SceneConfig const &config = {});
 
+  /** step all scenes in parallel on the shared job system, which has as many workers as the
+   *  thread count of the simulation; with the default thread count of 0 the scenes are stepped
+   *  one after another on the calling thread. Actor step and contact callbacks may run on worker
+   *  threads, scene step events are emitted on the calling thread after all scenes finish.
+   *  Each scene may be listed once and must not be in a step begun by beginStep */
+  void stepScenes(std::vector<SScene *> const &scenes);
+
   std::shared_ptr<SPhysicalMaterial>
   createPhysicalMaterial(PxReal staticFriction, PxReal dynamicFriction, PxReal restitution) const;
 
@@ -65,6 +74,17 @@ public:
   inline MeshManager &getMeshManager() { return mMeshManager; }
   void setLogLevel(std::string const &level);
 
+  inline uint32_t getThreadCount() const { return mThreadCount; }
+
+  /** CPU affinity applied to every worker of the engine-wide pool,
+   *  only effective before the first scene with shareThreadPool is created */
+  void setThreadAffinityMask(uint64_t mask);
+  inline uint64_t getThreadAffinityMask() const { return mThreadAffinityMask; }
+
+  /** job system shared by all scenes created with shareThreadPool,
+   *  lazily created with the thread count passed to the constructor */
+  std::shared_ptr<JobSystem> getSharedJobSystem();
+
 #ifdef _PVD
   PxPvd *mPvd = nullptr;
   PxPvdTransport *mTransport = nullptr;
@@ -76,8 +96,10 @@ public:
 private:
   // PhysX objects
   uint32_t mThreadCount;
+  uint64_t mThreadAffinityMask{0};
   PxFoundation *mFoundation = nullptr;
-  PxDefaultCpuDispatcher *mCpuDispatcher = nullptr;
+  std::shared_ptr<JobSystem> mSharedJobSystem;
+  std::mutex mSharedJobSystemMutex;
   SapienErrorCallback mErrorCallback;
 
   std::shared_ptr<Renderer::IPxrRenderer> mRenderer = nullptr;
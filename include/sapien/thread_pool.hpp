@@ -1,56 +1,63 @@
-// adapted from https://github.com/mtrebi/thread-pool with bug fixes
+// originally adapted from https://github.com/mtrebi/thread-pool, now a thin wrapper of JobSystem
 #pragma once
 
-#include <mutex>
-#include <queue>
-
+#include <atomic>
 #include <functional>
 #include <future>
-#include <thread>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
 #include <utility>
-#include <vector>
+
+#include "job_system.h"
 
 namespace sapien {
 
 class ThreadPool {
 private:
-  class ThreadWorker {
-  private:
-    int m_id;
-    ThreadPool *m_pool;
-
+  // a single allocation holds the callable, its arguments and the promise
+  template <typename F, typename... Args> class TaskJob : public Job {
   public:
-    ThreadWorker(ThreadPool *pool, const int id) : m_id(id), m_pool(pool) {}
-
-    void operator()() {
-      std::function<void()> func;
-      while (!m_pool->m_shutdown) {
-        {
-          std::unique_lock<std::mutex> lock(m_pool->m_mutex);
-          while (m_pool->m_queue.empty()) {
-            m_pool->m_conditional_lock.wait(lock);
-            if (m_pool->m_shutdown) {
-              return;
-            }
-          }
-          func = std::move(m_pool->m_queue.front());
-          m_pool->m_queue.pop();
+    using Result = std::invoke_result_t<F &, Args &...>;
+
+    template <typename F2, typename... Args2>
+    TaskJob(F2 &&f, Args2 &&...args)
+        : m_func(std::forward<F2>(f)), m_args(std::forward<Args2>(args)...) {}
+
+    std::future<Result> getFuture() { return m_promise.get_future(); }
+
+    void execute() override {
+      try {
+        if constexpr (std::is_void_v<Result>) {
+          std::apply(m_func, m_args);
+          m_promise.set_value();
+        } else {
+          m_promise.set_value(std::apply(m_func, m_args));
         }
-        func();
+      } catch (...) {
+        m_promise.set_exception(std::current_exception());
       }
+      delete this;
     }
+
+    // the destroyed promise reports broken_promise to the waiting future
+    void cancel() override { delete this; }
+
+  private:
+    F m_func;
+    std::tuple<Args...> m_args;
+    std::promise<Result> m_promise;
   };
 
-  bool m_init;
-  bool m_shutdown;
-  std::queue<std::function<void()>> m_queue;
-  std::mutex m_mutex;
-  std::condition_variable m_conditional_lock;
-  std::vector<std::thread> m_threads;
+  int m_threads;
+  std::once_flag m_initFlag;
+  std::atomic<bool> m_init{false};
+  std::unique_ptr<JobSystem> m_jobs;
 
 public:
-  ThreadPool(const int n_threads)
-      : m_init(false), m_shutdown(false), m_threads(std::vector<std::thread>(n_threads)) {}
+  // workers start on first use, most scenes never submit anything
+  ThreadPool(const int n_threads) : m_threads(n_threads) {}
 
   ThreadPool(const ThreadPool &) = delete;
   ThreadPool(ThreadPool &&) = delete;
@@ -60,51 +67,37 @@ public:
 
   ~ThreadPool() { shutdown(); }
 
-  // Inits thread pool
+  // Inits thread pool, safe to call more than once and from several threads
   void init() {
-    m_init = true;
-    for (uint32_t i = 0; i < m_threads.size(); ++i) {
-      m_threads[i] = std::thread(ThreadWorker(this, i));
-    }
+    std::call_once(m_initFlag, [this]() {
+      m_jobs = std::make_unique<JobSystem>(m_threads);
+      m_init.store(true, std::memory_order_release);
+    });
   }
 
   // Waits until threads finish their current task and shutdowns the pool
   void shutdown() {
-    m_shutdown = true;
-    m_conditional_lock.notify_all();
-
-    for (uint32_t i = 0; i < m_threads.size(); ++i) {
-      if (m_threads[i].joinable()) {
-        m_threads[i].join();
-      }
+    if (running()) {
+      m_jobs->shutdown();
     }
   }
 
   // Submit a function to be executed asynchronously by the pool
   template <typename F, typename... Args>
-  auto submit(F &&f, Args &&...args) -> std::future<decltype(f(args...))> {
-    // Create a function with bounded parameters ready to execute
-    std::function<decltype(f(args...))()> func =
-        std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-    // Encapsulate it into a shared ptr in order to be able to copy construct / assign
-    auto task_ptr = std::make_shared<std::packaged_task<decltype(f(args...))()>>(func);
-
-    // Wrap packaged task into void function
-    std::function<void()> wrapper_func = [task_ptr]() { (*task_ptr)(); };
-
-    // Enqueue generic wrapper function
-    {
-      std::lock_guard lock(m_mutex);
-      m_queue.push(std::move(wrapper_func));
-    }
+  auto submit(F &&f, Args &&...args) {
+    auto job = new TaskJob<std::decay_t<F>, std::decay_t<Args>...>(std::forward<F>(f),
+                                                                   std::forward<Args>(args)...);
+    auto future = job->getFuture();
+    init();
+    m_jobs->submit(job);
+    return future;
+  }
 
-    // Wake up one thread if its waiting
-    m_conditional_lock.notify_one();
+  bool running() const { return m_init.load(std::memory_order_acquire); }
 
-    // Return future from promise
-    return task_ptr->get_future();
+  inline JobSystem &getJobSystem() {
+    init();
+    return *m_jobs;
   }
-
-  bool running() const { return m_init; }
 };
 } // namespace sapien
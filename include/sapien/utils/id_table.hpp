@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace sapien::utils {
+
+/** Pointer table indexed directly by small sequential ids such as the ones from IDGenerator */
+template <typename T> class DenseIdTable {
+public:
+  inline void set(uint32_t id, T *value) {
+    if (id >= mData.size()) {
+      mData.resize(std::max<size_t>(id + 1, mData.size() * 2), nullptr);
+    }
+    mData[id] = value;
+  }
+
+  inline void erase(uint32_t id) {
+    if (id < mData.size()) {
+      mData[id] = nullptr;
+    }
+  }
+
+  /** nullptr if the id is not in the table */
+  inline T *get(uint32_t id) const { return id < mData.size() ? mData[id] : nullptr; }
+
+  inline void clear() { mData.clear(); }
+
+private:
+  std::vector<T *> mData;
+};
+
+/**
+ * Open-addressing hash map with linear probing and backward-shift deletion.
+ * Iterators and references are invalidated by insertion and erasure.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>> class FlatHashMap {
+  struct Slot {
+    K key;
+    V value;
+  };
+
+public:
+  /** insert or overwrite, returns the stored value */
+  V &insert_or_assign(K const &key, V value) {
+    if ((mSize + 1) * 4 > mSlots.size() * 3) {
+      rehash(mSlots.empty() ? 16 : mSlots.size() * 2);
+    }
+    size_t i = probe(key);
+    if (!mUsed[i]) {
+      mUsed[i] = true;
+      mSlots[i].key = key;
+      ++mSize;
+    }
+    mSlots[i].value = std::move(value);
+    return mSlots[i].value;
+  }
+
+  /** nullptr if the key is not in the map */
+  V *find(K const &key) {
+    if (mSlots.empty()) {
+      return nullptr;
+    }
+    size_t i = probe(key);
+    return mUsed[i] ? &mSlots[i].value : nullptr;
+  }
+
+  V const *find(K const &key) const { return const_cast<FlatHashMap *>(this)->find(key); }
+
+  bool erase(K const &key) {
+    if (mSlots.empty()) {
+      return false;
+    }
+    size_t i = probe(key);
+    if (!mUsed[i]) {
+      return false;
+    }
+    eraseSlot(i);
+    return true;
+  }
+
+  /** erase all entries for which pred(key, value) is true */
+  template <typename Pred> void erase_if(Pred pred) {
+    for (size_t i = 0; i < mSlots.size();) {
+      // backward shift may move an unvisited entry into slot i, so only advance when kept;
+      // entries wrapping around from the front were already visited and kept
+      if (mUsed[i] && pred(mSlots[i].key, mSlots[i].value)) {
+        eraseSlot(i);
+      } else {
+        ++i;
+      }
+    }
+  }
+
+  /** call fn(key, value) for every entry */
+  template <typename F> void forEach(F fn) const {
+    for (size_t i = 0; i < mSlots.size(); ++i) {
+      if (mUsed[i]) {
+        fn(mSlots[i].key, mSlots[i].value);
+      }
+    }
+  }
+
+  inline size_t size() const { return mSize; }
+  inline bool empty() const { return mSize == 0; }
+
+  void clear() {
+    mSlots.clear();
+    mUsed.clear();
+    mSize = 0;
+  }
+
+private:
+  inline size_t mask() const { return mSlots.size() - 1; }
+
+  // slot holding key, or the empty slot where it would be inserted
+  size_t probe(K const &key) const {
+    size_t i = Hash{}(key) & mask();
+    while (mUsed[i] && !(mSlots[i].key == key)) {
+      i = (i + 1) & mask();
+    }
+    return i;
+  }
+
+  void eraseSlot(size_t i) {
+    size_t j = i;
+    while (true) {
+      j = (j + 1) & mask();
+      if (!mUsed[j]) {
+        break;
+      }
+      size_t home = Hash{}(mSlots[j].key) & mask();
+      // move j back to i if its home slot is not in the cyclic range (i, j]
+      bool inRange = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+      if (!inRange) {
+        mSlots[i] = std::move(mSlots[j]);
+        i = j;
+      }
+    }
+    mUsed[i] = false;
+    mSlots[i] = Slot{};
+    --mSize;
+  }
+
+  void rehash(size_t capacity) {
+    std::vector<Slot> slots(capacity);
+    std::vector<bool> used(capacity, false);
+    std::swap(slots, mSlots);
+    std::swap(used, mUsed);
+    mSize = 0;
+    for (size_t i = 0; i < slots.size(); ++i) {
+      if (used[i]) {
+        insert_or_assign(slots[i].key, std::move(slots[i].value));
+      }
+    }
+  }
+
+  std::vector<Slot> mSlots;
+  std::vector<bool> mUsed;
+  size_t mSize{0};
+};
+
+} // namespace sapien::utils
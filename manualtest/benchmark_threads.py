@@ -0,0 +1,53 @@
+import sapien.core as sapien
+import numpy as np
+import time
+
+
+def build_scene(engine, thread_count, share, n_actors):
+    config = sapien.SceneConfig()
+    config.thread_count = thread_count
+    config.share_thread_pool = share
+    scene = engine.create_scene(config)
+    scene.set_timestep(1 / 240.0)
+    scene.add_ground(0, render=False)
+
+    builder = scene.create_actor_builder()
+    builder.add_box_collision(half_size=[0.05, 0.05, 0.05])
+    side = int(np.ceil(np.sqrt(n_actors)))
+    for i in range(n_actors):
+        actor = builder.build()
+        x, y = i % side, i // side
+        actor.set_pose(sapien.Pose([x * 0.12, y * 0.12, 0.05 + 0.2 * (i % 5)]))
+    return scene
+
+
+def benchmark(engine, thread_count, share=False, n_actors=1000, steps=500):
+    scene = build_scene(engine, thread_count, share, n_actors)
+    for _ in range(20):
+        scene.step()
+
+    start = time.time()
+    for _ in range(steps):
+        scene.step()
+    return (time.time() - start) / steps
+
+
+def main():
+    engine_threads = 8
+    engine = sapien.Engine(thread_count=engine_threads)
+
+    print("threads | step time (ms)")
+    for n in [1, 2, 4, 8, 16, 32]:
+        dt = benchmark(engine, n)
+        print("{:7d} | {:.3f}".format(n, dt * 1000))
+
+    # a scene thread count of 0 uses the engine thread count
+    dt = benchmark(engine, 0)
+    print("default | {:.3f}  (engine, {} threads)".format(dt * 1000, engine_threads))
+
+    dt = benchmark(engine, 0, share=True)
+    print(" shared | {:.3f}".format(dt * 1000))
+
+
+if __name__ == "__main__":
+    main()
@@ -34,6 +34,7 @@
 #include "sapien/renderer/kuafu_renderer.hpp"
 #endif
 
+#include "sapien/renderer/null_renderer.h"
 #include "sapien/renderer/render_config.h"
 #include "sapien/renderer/svulkan2_pointbody.h"
 #include "sapien/renderer/svulkan2_renderer.h"
@@ -228,6 +229,13 @@ URDF::URDFConfig parseURDFConfig(py::dict &dict) {
 
 PxVec3 array2vec3(const py::array_t<PxReal> &arr) { return {arr.at(0), arr.at(1), arr.at(2)}; }
 
+// numpy view of a [rows, cols] block owned by base, no copy is made
+template <typename T>
+py::array_t<T> make_view(std::vector<T> &values, uint32_t rows, uint32_t cols,
+                         py::handle base) {
+  return py::array_t<T>({rows, cols}, {sizeof(T) * cols, sizeof(T)}, values.data(), base);
+}
+
 template <typename T> py::array_t<T> make_array(std::vector<T> const &values) {
   return py::array_t(values.size(), values.data());
 }
@@ -271,6 +279,105 @@ static auto getAddressMode(std::string mode) {
   }
 }
 
+static ContactReportLevel getContactReportLevel(std::string const &level) {
+  if (level == "none") {
+    return ContactReportLevel::NONE;
+  } else if (level == "touch") {
+    return ContactReportLevel::TOUCH;
+  } else if (level == "points") {
+    return ContactReportLevel::POINTS;
+  }
+  throw std::invalid_argument("Unknown contact report level " + level);
+}
+
+static std::optional<ContactReportLevel>
+getOptionalContactReportLevel(std::optional<std::string> const &level) {
+  if (!level) {
+    return {};
+  }
+  return getContactReportLevel(*level);
+}
+
+static std::string contactReportLevelName(ContactReportLevel level) {
+  switch (level) {
+  case ContactReportLevel::NONE:
+    return "none";
+  case ContactReportLevel::TOUCH:
+    return "touch";
+  case ContactReportLevel::POINTS:
+    return "points";
+  }
+  throw std::runtime_error("invalid contact report level");
+}
+
+static std::optional<std::string>
+optionalContactReportLevelName(std::optional<ContactReportLevel> level) {
+  if (!level) {
+    return {};
+  }
+  return contactReportLevelName(*level);
+}
+
+static uint32_t getArticulationStateFields(std::vector<std::string> const &names) {
+  uint32_t fields = 0;
+  for (auto &name : names) {
+    if (name == "qpos") {
+      fields |= ArticulationStateField::QPOS;
+    } else if (name == "qvel") {
+      fields |= ArticulationStateField::QVEL;
+    } else if (name == "qacc") {
+      fields |= ArticulationStateField::QACC;
+    } else if (name == "qf") {
+      fields |= ArticulationStateField::QF;
+    } else {
+      throw std::invalid_argument("Unknown articulation state field " + name);
+    }
+  }
+  return fields;
+}
+
+// check that out is a writable float32 array of the given shape, or allocate one; out is taken
+// as py::array so that a float64 or strided array is rejected instead of silently copied
+static py::array_t<PxReal> getOutputArray(std::optional<py::array> out,
+                                          std::vector<py::ssize_t> const &shape) {
+  if (!out) {
+    return py::array_t<PxReal>(shape);
+  }
+  if (!py::isinstance<py::array_t<PxReal>>(*out) || !(out->flags() & py::array::c_style) ||
+      !out->writeable() ||
+      std::vector<py::ssize_t>(out->shape(), out->shape() + out->ndim()) != shape) {
+    throw std::runtime_error("out must be a writable C-contiguous float32 array of shape " +
+                             std::string(py::str(py::tuple(py::cast(shape)))));
+  }
+  return py::reinterpret_borrow<py::array_t<PxReal>>(*out);
+}
+
+using DriveArray =
+    std::optional<py::array_t<PxReal, py::array::c_style | py::array::forcecast>>;
+
+// drive command over the given arrays, every array must hold size values
+static SDriveCommand makeDriveCommand(DriveArray const &target, DriveArray const &velocityTarget,
+                                      DriveArray const &stiffness, DriveArray const &damping,
+                                      DriveArray const &forceLimit, py::ssize_t size) {
+  auto get = [size](DriveArray const &array, char const *name) -> PxReal const * {
+    if (!array) {
+      return nullptr;
+    }
+    if (array->size() != size) {
+      throw std::runtime_error(std::string(name) + " should have " + std::to_string(size) +
+                               " values");
+    }
+    return array->data();
+  };
+  SDriveCommand command;
+  command.target = get(target, "target");
+  command.velocityTarget = get(velocityTarget, "velocity_target");
+  command.stiffness = get(stiffness, "stiffness");
+  command.damping = get(damping, "damping");
+  command.forceLimit = get(forceLimit, "force_limit");
+  return command;
+}
+
 #define DEPRECATE_WARN(OLD, NEW)                                                                  \
   PyErr_WarnEx(PyExc_DeprecationWarning, #OLD " is deprecated, use " #NEW " instead.", 1)
 
@@ -336,6 +443,8 @@ void buildSapien(py::module &m) {
   auto PyEngine = py::class_<Simulation, std::shared_ptr<Simulation>>(m, "Engine");
   auto PySceneConfig = py::class_<SceneConfig>(m, "SceneConfig");
   auto PyScene = py::class_<SScene>(m, "Scene");
+  auto PySceneStateBuffer =
+      py::class_<SceneStateBuffer, std::shared_ptr<SceneStateBuffer>>(m, "SceneStateBuffer");
   auto PyConstraint = py::class_<SDrive>(m, "Constraint");
   auto PyDrive = py::class_<SDrive6D, SDrive>(m, "Drive");
   auto PyGear = py::class_<SGear>(m, "Gear");
@@ -362,6 +471,7 @@ void buildSapien(py::module &m) {
   py::class_<SKArticulation, SArticulationDrivable>(m, "KinematicArticulation");
 
   auto PyContact = py::class_<SContact>(m, "Contact");
+  py::class_<SOwnedContact, SContact>(m, "_OwnedContact");
   auto PyTrigger = py::class_<STrigger>(m, "Trigger");
   auto PyContactPoint = py::class_<SContactPoint>(m, "ContactPoint");
 
@@ -480,8 +590,114 @@ void buildSapien(py::module &m) {
   auto PyRenderServerBuffer =
       py::class_<Renderer::server::VulkanCudaBuffer>(m, "RenderServerBuffer");
 
-  PyRenderClient.def(py::init<std::string, uint64_t>(), py::arg("address"),
-                     py::arg("process_index"));
+  // internal, lets tests drive the shared memory frame ring of the render client and server
+  auto PySharedFrameRing =
+      py::class_<Renderer::server::SharedFrameRing>(m, "_SharedFrameRing");
+
+  auto PyNullRenderer =
+      py::class_<Renderer::NullRenderer, Renderer::IPxrRenderer,
+                 std::shared_ptr<Renderer::NullRenderer>>(m, "NullRenderer");
+  PyNullRenderer.def(py::init<>());
+
+  PyRenderClient
+      .def(py::init<std::string, uint64_t, bool, uint32_t>(), py::arg("address"),
+           py::arg("process_index"), py::arg("shared_memory") = true,
+           py::arg("max_frames_in_flight") = 1)
+      .def("synchronize", &Renderer::server::ClientRenderer::synchronize,
+           "Wait until the render server has applied all frames and calls sent by this client");
+
+  PySharedFrameRing
+      .def_static("create", &Renderer::server::SharedFrameRing::create, py::arg("name"),
+                  py::arg("capacity"))
+      .def_static("open", &Renderer::server::SharedFrameRing::open, py::arg("name"))
+      .def_property_readonly_static(
+          "data_offset",
+          [](py::object) { return Renderer::server::SharedFrameRing::getDataOffset(); })
+      .def("unlink", &Renderer::server::SharedFrameRing::unlink)
+      .def(
+          "push",
+          [](Renderer::server::SharedFrameRing &ring, uint64_t frame,
+             py::array_t<float, py::array::c_style | py::array::forcecast> const &bodyPoses,
+             std::optional<py::array_t<uint32_t, py::array::c_style | py::array::forcecast>> const
+                 &bodyIndices,
+             float timeout) {
+            Renderer::server::PackedFrame packed;
+            packed.frame = frame;
+            packed.full = !bodyIndices;
+            packed.bodyPoses = reinterpret_cast<char const *>(bodyPoses.data());
+            packed.bodyCount = bodyPoses.size() / Renderer::server::kPackedPoseSize;
+            if (bodyIndices) {
+              packed.bodyIndices = bodyIndices->data();
+              packed.bodyIndexCount = bodyIndices->size();
+            }
+            return ring.push(packed, std::chrono::microseconds(int64_t(timeout * 1e6)));
+          },
+          py::arg("frame"), py::arg("body_poses"), py::arg("body_indices") = py::none(),
+          py::arg("timeout") = 1.f)
+      .def(
+          "wait_ack",
+          [](Renderer::server::SharedFrameRing &ring, uint64_t frame, float timeout) {
+            return ring.waitAck(frame, std::chrono::microseconds(int64_t(timeout * 1e6)));
+          },
+          py::arg("frame"), py::arg("timeout") = 1.f)
+      .def(
+          "pop",
+          [](Renderer::server::SharedFrameRing &ring, float timeout) -> py::object {
+            Renderer::server::PackedFrame frame;
+            if (!ring.pop(frame, std::chrono::microseconds(int64_t(timeout * 1e6)))) {
+              return py::none();
+            }
+            py::array_t<float> poses(
+                {py::ssize_t(frame.bodyCount), py::ssize_t(Renderer::server::kPackedPoseSize)});
+            std::memcpy(poses.mutable_data(), frame.bodyPoses, poses.nbytes());
+            py::array_t<uint32_t> indices(frame.bodyIndexCount);
+            std::memcpy(indices.mutable_data(), frame.bodyIndices, indices.nbytes());
+            return py::make_tuple(frame.frame, frame.full, poses, indices);
+          },
+          py::arg("timeout") = 1.f,
+          "Returns (frame, full, body_poses, body_indices), or None on timeout")
+      .def("release", &Renderer::server::SharedFrameRing::release, py::arg("error") = "")
+      .def("close", &Renderer::server::SharedFrameRing::close)
+      .def_property_readonly("closed", &Renderer::server::SharedFrameRing::isClosed);
+
+  // internal, lets tests check the delta encoding of render frames
+  m.def(
+      "_encode_body_poses",
+      [](py::array_t<float, py::array::c_style | py::array::forcecast> const &poses,
+         py::array_t<float, py::array::c_style | py::array::forcecast> const &sentPoses) {
+        std::vector<float> current(poses.data(), poses.data() + poses.size());
+        std::vector<float> sent(sentPoses.data(), sentPoses.data() + sentPoses.size());
+        std::vector<uint32_t> changedIndices;
+        std::vector<float> changedPoses;
+        Renderer::server::PackedFrame frame;
+        Renderer::server::encodeBodyPoses(current, sent, changedIndices, changedPoses, frame);
+        py::array_t<float> bodyPoses(
+            {py::ssize_t(frame.bodyCount), py::ssize_t(Renderer::server::kPackedPoseSize)});
+        std::memcpy(bodyPoses.mutable_data(), frame.bodyPoses, bodyPoses.nbytes());
+        py::array_t<uint32_t> bodyIndices(frame.bodyIndexCount);
+        std::memcpy(bodyIndices.mutable_data(), frame.bodyIndices, bodyIndices.nbytes());
+        return py::make_tuple(frame.full, bodyPoses, bodyIndices);
+      },
+      py::arg("poses"), py::arg("sent_poses"),
+      "Returns (full, body_poses, body_indices) of a frame sent after sent_poses");
+  m.def(
+      "_check_body_poses",
+      [](uint32_t bodyCount,
+         py::array_t<float, py::array::c_style | py::array::forcecast> const &bodyPoses,
+         std::optional<py::array_t<uint32_t, py::array::c_style | py::array::forcecast>> const
+             &bodyIndices) {
+        Renderer::server::PackedFrame frame;
+        frame.full = !bodyIndices;
+        frame.bodyPoses = reinterpret_cast<char const *>(bodyPoses.data());
+        frame.bodyCount = bodyPoses.size() / Renderer::server::kPackedPoseSize;
+        if (bodyIndices) {
+          frame.bodyIndices = bodyIndices->data();
+          frame.bodyIndexCount = bodyIndices->size();
+        }
+        return Renderer::server::checkBodyPoses(frame, bodyCount);
+      },
+      py::arg("body_count"), py::arg("body_poses"), py::arg("body_indices") = py::none(),
+      "Returns the error the render server reports for the frame, empty if it is applied");
 
   PyRenderServer
       .def_static("_set_shader_dir", &Renderer::server::setDefaultShaderDirectory,
@@ -666,6 +882,16 @@ Here is some explanation: g2 is the "ignore group" and g3 is the "id group". The
 
 If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g0 is the "contact type group" and g1 is the "contact affinity group". Collision shapes collide only when a bit in the contact type of the first shape matches a bit in the contact affinity of the second shape.)doc",
            py::arg("group0"), py::arg("group1"), py::arg("group2"), py::arg("group3"))
+      .def_property(
+          "contact_report_level",
+          [](SCollisionShape &shape) {
+            return optionalContactReportLevelName(shape.getContactReportLevel());
+          },
+          [](SCollisionShape &shape, std::optional<std::string> const &level) {
+            shape.setContactReportLevel(getOptionalContactReportLevel(level));
+          },
+          "contact report level of this shape, overrides the group and scene levels; None "
+          "inherits them")
       .def_property("rest_offset", &SCollisionShape::getRestOffset,
                     &SCollisionShape::setRestOffset)
       .def_property("contact_offset", &SCollisionShape::getContactOffset,
@@ -841,6 +1067,16 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
       .def_readwrite("enable_friction_every_iteration", &SceneConfig::enableFrictionEveryIteration)
       .def_readwrite("enable_adaptive_force", &SceneConfig::enableAdaptiveForce)
       .def_readwrite("disable_collision_visual", &SceneConfig::disableCollisionVisual)
+      .def_readwrite("thread_count", &SceneConfig::threadCount)
+      .def_readwrite("share_thread_pool", &SceneConfig::shareThreadPool)
+      .def_readwrite("thread_affinity_mask", &SceneConfig::threadAffinityMask)
+      .def_property(
+          "contact_report_level",
+          [](SceneConfig &config) { return contactReportLevelName(config.contactReportLevel); },
+          [](SceneConfig &config, std::string const &level) {
+            config.contactReportLevel = getContactReportLevel(level);
+          },
+          "default contact report level of the scene: \"none\", \"touch\" or \"points\"")
       .def("__repr__", [](SceneConfig &) { return "SceneConfig()"; });
 
   //======== Simulation ========//
@@ -851,10 +1087,58 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
            py::arg("thread_count") = 0, py::arg("tolerance_length") = 0.1f,
            py::arg("tolerance_speed") = 0.2f)
       .def("create_scene", &Simulation::createScene, py::arg("config") = SceneConfig())
+      .def("step_scenes", &Simulation::stepScenes, py::arg("scenes"),
+           py::call_guard<py::gil_scoped_release>(),
+           "Step scenes in parallel on thread_count worker threads, an engine created with "
+           "thread_count=0 steps them one after another. Actor step and contact callbacks may "
+           "run on worker threads.")
       .def_property("renderer", &Simulation::getRenderer, &Simulation::setRenderer)
       .def("get_renderer", &Simulation::getRenderer)
       .def("set_renderer", &Simulation::setRenderer, py::arg("renderer"))
       .def("set_log_level", &Simulation::setLogLevel, py::arg("level"))
+      .def_property_readonly("thread_count", &Simulation::getThreadCount)
+      .def_property("thread_affinity_mask", &Simulation::getThreadAffinityMask,
+                    &Simulation::setThreadAffinityMask)
+      .def_property(
+          "cooked_mesh_cache_enabled",
+          [](Simulation &sim) { return sim.getMeshManager().isCookedCacheEnabled(); },
+          [](Simulation &sim, bool enabled) { sim.getMeshManager().setCookedCacheEnabled(enabled); })
+      .def_property(
+          "mesh_loader_thread_count",
+          [](Simulation &sim) { return sim.getMeshManager().getLoaderThreadCount(); },
+          [](Simulation &sim, uint32_t count) { sim.getMeshManager().setLoaderThreadCount(count); })
+      .def(
+          "preload_meshes",
+          [](Simulation &sim, std::vector<std::string> const &filenames, std::string const &type) {
+            MeshLoadType loadType;
+            if (type == "convex") {
+              loadType = MeshLoadType::CONVEX;
+            } else if (type == "nonconvex") {
+              loadType = MeshLoadType::NON_CONVEX;
+            } else if (type == "group") {
+              loadType = MeshLoadType::GROUP;
+            } else {
+              throw std::runtime_error("failed to preload meshes: invalid type " + type);
+            }
+            std::vector<std::pair<MeshLoadType, std::string>> meshes;
+            for (auto &filename : filenames) {
+              meshes.push_back({loadType, filename});
+            }
+            py::gil_scoped_release release;
+            sim.getMeshManager().preloadMeshes(meshes);
+          },
+          R"doc(
+Import and cook collision meshes in parallel, so later builds only look them up. Safe to call
+from several threads.
+
+Args:
+  filenames: mesh files
+  type: "convex", "nonconvex" or "group" (multiple convex meshes), matching the builder functions
+        that will use the meshes)doc",
+          py::arg("filenames"), py::arg("type") = "convex")
+      .def_property_readonly(
+          "loaded_mesh_count",
+          [](Simulation &sim) { return sim.getMeshManager().getLoadedMeshCount(); })
       .def("create_physical_material", &Simulation::createPhysicalMaterial,
            py::arg("static_friction"), py::arg("dynamic_friction"), py::arg("restitution"))
       .def(
@@ -909,6 +1193,33 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
       .def("remove_kinematic_articulation", &SScene::removeKinematicArticulation,
            py::arg("kinematic_articulation"))
       .def("remove_drive", &SScene::removeDrive, py::arg("drive"))
+      .def("deactivate_actor", &SScene::deactivateActor, py::arg("actor"),
+           R"doc(
+Take an actor out of the simulation without destroying it. The actor keeps its PhysX objects,
+shapes and render bodies, drives and gears attached to it are removed. ActorBuilder.build with
+reuse=True takes deactivated actors built by the same unmodified builder.)doc")
+      .def("activate_actor", &SScene::activateActor, py::arg("actor"),
+           py::arg("pose") = PxTransform(PxIdentity),
+           "Put a deactivated actor back into the simulation at pose with zero velocity")
+      .def("deactivate_articulation", &SScene::deactivateArticulation, py::arg("articulation"),
+           "Take an articulation out of the simulation without destroying it, see "
+           "deactivate_actor")
+      .def("activate_articulation", &SScene::activateArticulation, py::arg("articulation"),
+           py::arg("pose") = PxTransform(PxIdentity),
+           "Put a deactivated articulation back into the simulation at root pose with zero "
+           "velocities, joint positions are kept")
+      .def(
+          "is_active", [](SScene &s, SActorBase *actor) { return s.isActive(actor); },
+          py::arg("actor"))
+      .def(
+          "is_active",
+          [](SScene &s, SArticulation *articulation) { return s.isActive(articulation); },
+          py::arg("articulation"))
+      .def_property_readonly("inactive_actor_count", &SScene::getInactiveActorCount)
+      .def_property_readonly("inactive_articulation_count",
+                             &SScene::getInactiveArticulationCount)
+      .def("clear_inactive_objects", &SScene::clearInactiveObjects,
+           "Remove all deactivated actors and articulations")
       .def("find_actor_by_id", &SScene::findActorById, py::arg("id"),
            py::return_value_policy::reference)
       .def("find_articulation_link_by_link_id", &SScene::findArticulationLinkById, py::arg("id"),
@@ -943,6 +1254,9 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
       .def("get_mounted_cameras", &SScene::getCameras, py::return_value_policy::reference)
       .def("remove_camera", &SScene::removeCamera, py::arg("camera"))
       .def("step", &SScene::step)
+      .def("begin_step", &SScene::beginStep)
+      .def("end_step", &SScene::endStep, py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly("is_stepping", &SScene::isStepping)
       .def("step_async",
            [](SScene &scene) {
              return std::static_pointer_cast<IAwaitable<void>>(
@@ -961,6 +1275,11 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
              return std::static_pointer_cast<IAwaitable<void>>(
                  std::make_shared<AwaitableFuture<void>>(scene.updateRenderAsync()));
            })
+      .def("mark_render_dirty", py::overload_cast<SActorBase *>(&SScene::markRenderDirty),
+           py::arg("actor"))
+      .def("mark_render_dirty", py::overload_cast<SArticulationBase *>(&SScene::markRenderDirty),
+           py::arg("articulation"))
+      .def("mark_all_render_dirty", &SScene::markAllRenderDirty)
       .def(
           "add_ground",
           [](SScene &s, float altitude, bool render, std::shared_ptr<SPhysicalMaterial> material,
@@ -973,7 +1292,134 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
           py::arg("render_material") = nullptr,
           py::arg("render_half_size") = make_array<float>({10.f, 10.f}),
           py::return_value_policy::reference)
-      .def("get_contacts", &SScene::getContacts, py::return_value_policy::reference)
+      .def(
+          "get_contacts",
+          [](SScene &s) {
+            // the scene reuses its contact arrays every step, hand out copies
+            auto const &contacts = s.getContacts();
+            return std::vector<SOwnedContact>(contacts.begin(), contacts.end());
+          },
+          "Copies of the active contacts, use get_contact_arrays to read them without copying")
+      .def(
+          "get_articulation_states",
+          [](SScene &s, std::vector<SArticulation *> const &articulations,
+             std::vector<std::string> const &fields, std::optional<py::array> out) {
+            uint32_t mask = getArticulationStateFields(fields);
+            uint32_t maxDof = 0;
+            for (auto a : articulations) {
+              maxDof = std::max(maxDof, a->dof());
+            }
+            auto result = getOutputArray(out, {static_cast<py::ssize_t>(articulations.size()),
+                                               ArticulationStateField::count(mask), maxDof});
+            s.getArticulationStates(articulations, mask, result.mutable_data());
+            return result;
+          },
+          R"doc(
+Read joint states of many articulations in one call.
+
+Args:
+  articulations: list of Articulation
+  fields: subset of "qpos", "qvel", "qacc", "qf", always packed in this order
+  out: optional float32 array of shape [articulation count, field count, max dof] to write into
+
+Returns: array of shape [articulation count, field count, max dof], zero padded)doc",
+          py::arg("articulations"),
+          py::arg("fields") = std::vector<std::string>{"qpos", "qvel", "qf"},
+          py::arg("out") = py::none())
+      .def(
+          "set_articulation_states",
+          [](SScene &s, std::vector<SArticulation *> const &articulations,
+             std::vector<std::string> const &fields,
+             py::array_t<PxReal, py::array::c_style | py::array::forcecast> const &data) {
+            uint32_t mask = getArticulationStateFields(fields);
+            uint32_t maxDof = 0;
+            for (auto a : articulations) {
+              maxDof = std::max(maxDof, a->dof());
+            }
+            if (data.size() != articulations.size() * ArticulationStateField::count(mask) * maxDof) {
+              throw std::runtime_error(
+                  "states should have shape [articulation count, field count, max dof]");
+            }
+            s.setArticulationStates(articulations, mask, data.data());
+          },
+          "inverse of get_articulation_states", py::arg("articulations"), py::arg("fields"),
+          py::arg("states"))
+      .def(
+          "set_drive_commands",
+          [](SScene &s, std::vector<SArticulation *> const &articulations,
+             DriveArray const &target, DriveArray const &velocityTarget,
+             DriveArray const &stiffness, DriveArray const &damping,
+             DriveArray const &forceLimit) {
+            uint32_t maxDof = 0;
+            for (auto a : articulations) {
+              maxDof = std::max(maxDof, a->dof());
+            }
+            s.applyDriveCommands(articulations,
+                                 makeDriveCommand(target, velocityTarget, stiffness, damping,
+                                                  forceLimit, articulations.size() * maxDof));
+          },
+          R"doc(
+Articulation.set_drive_command for many articulations, every array has shape
+[articulation count, max dof] and padding is ignored.)doc",
+          py::arg("articulations"), py::arg("target") = py::none(),
+          py::arg("velocity_target") = py::none(), py::arg("stiffness") = py::none(),
+          py::arg("damping") = py::none(), py::arg("force_limit") = py::none())
+      .def_property(
+          "contact_report_level",
+          [](SScene &s) { return contactReportLevelName(s.getContactReportLevel()); },
+          [](SScene &s, std::string const &level) {
+            s.setContactReportLevel(getContactReportLevel(level));
+          },
+          R"doc(
+Contact report level of shapes without an actor or group level. "none" solves contacts without
+reporting them, "touch" reports the start and end of touch without contact points, "points"
+reports every step with contact points. A pair is reported at the more detailed level of its
+two shapes.)doc")
+      .def(
+          "set_group_contact_report_level",
+          [](SScene &s, uint32_t group, std::optional<std::string> const &level) {
+            s.setGroupContactReportLevel(group, getOptionalContactReportLevel(level));
+          },
+          R"doc(
+Set the contact report level of shapes whose contact type group (group0 of
+CollisionShape.set_collision_groups) contains group, 1 to 32. None clears it. A shape in
+several groups uses the most detailed of their levels.)doc",
+          py::arg("group"), py::arg("level"))
+      .def(
+          "get_group_contact_report_level",
+          [](SScene &s, uint32_t group) {
+            return optionalContactReportLevelName(s.getGroupContactReportLevel(group));
+          },
+          py::arg("group"))
+      .def(
+          "get_contact_arrays",
+          [](py::object self) {
+            auto &scene = self.cast<SScene &>();
+            auto &contacts = scene.getContacts();
+            auto &points = scene.getContactPoints();
+            py::dtype contactType(
+                {"actor0", "actor1", "starts", "persists", "ends", "point_offset", "point_count"},
+                {"u4", "u4", "?", "?", "?", "u4", "u4"},
+                {offsetof(SContact, actorIds), offsetof(SContact, actorIds) + sizeof(physx_id_t),
+                 offsetof(SContact, starts), offsetof(SContact, persists),
+                 offsetof(SContact, ends), offsetof(SContact, pointOffset),
+                 offsetof(SContact, points) + offsetof(SContactPointSpan, count)},
+                sizeof(SContact));
+            py::dtype pointType({"position", "normal", "impulse", "separation"},
+                                {"(3,)f4", "(3,)f4", "(3,)f4", "f4"},
+                                {offsetof(SContactPoint, position),
+                                 offsetof(SContactPoint, normal),
+                                 offsetof(SContactPoint, impulse),
+                                 offsetof(SContactPoint, separation)},
+                                sizeof(SContactPoint));
+            return py::make_tuple(
+                py::array(contactType, {contacts.size()}, contacts.data(), self),
+                py::array(pointType, {points.size()}, points.data(), self));
+          },
+          R"doc(
+Active contacts and their points as structured numpy arrays without copying. Contacts refer
+to actors by id and to their points by point_offset and point_count. The arrays are only valid
+until the next step.)doc")
       .def("get_all_actors", &SScene::getAllActors, py::return_value_policy::reference)
       .def("get_all_articulations", &SScene::getAllArticulations,
            py::return_value_policy::reference)
@@ -983,7 +1429,17 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
            py::arg("actor2"), py::arg("pose2"), py::return_value_policy::reference)
       .def("create_gear", &SScene::createGear, py::arg("actor1"), py::arg("pose1"),
            py::arg("actor2"), py::arg("pose2"), py::return_value_policy::reference)
-      .def_property_readonly("render_id_to_visual_name", &SScene::findRenderId2VisualName)
+      .def_property_readonly("render_id_to_visual_name",
+                             [](SScene &scene) {
+                               auto &names = scene.findRenderId2VisualName();
+                               py::dict result;
+                               for (size_t id = 0; id < names.size(); ++id) {
+                                 if (!names[id].empty()) {
+                                   result[py::int_(id)] = names[id];
+                                 }
+                               }
+                               return result;
+                             })
 
       // renderer
       .def_property_readonly("renderer_scene", &SScene::getRendererScene,
@@ -1092,7 +1548,105 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
             data.mArticulationDriveData = t3->second;
             scene.unpackScene(data);
           },
-          py::arg("data"));
+          py::arg("data"))
+      .def(
+          "save_snapshot",
+          [](SScene &scene) {
+            auto buffer = scene.saveSnapshot();
+            return py::bytes(reinterpret_cast<char const *>(buffer.data()), buffer.size());
+          },
+          R"doc(
+Save actors, articulations and drives into a flat binary snapshot. The snapshot can be written
+to a file and restored later, including from a memory-mapped file.)doc")
+      .def(
+          "restore_snapshot",
+          [](SScene &scene, py::buffer snapshot) {
+            auto info = snapshot.request();
+            // the snapshot is parsed as raw bytes, a strided view would be read as garbage
+            py::ssize_t stride = info.itemsize;
+            for (py::ssize_t i = info.ndim - 1; i >= 0; --i) {
+              if (info.shape[i] > 1 && info.strides[i] != stride) {
+                throw std::runtime_error(
+                    "failed to restore snapshot: the buffer is not C-contiguous");
+              }
+              stride *= info.shape[i];
+            }
+            scene.restoreSnapshot(static_cast<uint8_t const *>(info.ptr),
+                                  info.size * info.itemsize);
+          },
+          py::arg("snapshot"),
+          R"doc(
+Restore a snapshot from any object supporting the buffer protocol, e.g. bytes, numpy arrays
+or mmap objects.)doc")
+      .def_property("snapshot_history_capacity", &SScene::getSnapshotHistoryCapacity,
+                    &SScene::setSnapshotHistoryCapacity)
+      .def_property_readonly("snapshot_history_size", &SScene::getSnapshotHistorySize)
+      .def("push_snapshot", &SScene::pushSnapshot)
+      .def("rollback", &SScene::rollback, py::arg("steps") = 0,
+           R"doc(
+Restore the snapshot pushed `steps` pushes before the most recent one. Newer snapshots are
+discarded and the restored snapshot stays in the history.)doc")
+      .def("enable_state_buffer", &SScene::enableStateBuffer, py::arg("enable") = true,
+           R"doc(
+When enabled, the state buffer is refreshed after every step. Arrays obtained from the buffer
+are views into it and always hold the latest state until actors or articulations are added or
+removed, after which get_state_buffer returns a new buffer.)doc")
+      .def_property_readonly("state_buffer_enabled", &SScene::isStateBufferEnabled)
+      .def("update_state_buffer", &SScene::updateStateBuffer)
+      .def("get_state_buffer", &SScene::getStateBuffer);
+
+  PySceneStateBuffer
+      .def_readonly("actor_count", &SceneStateBuffer::actorCount)
+      .def_readonly("articulation_count", &SceneStateBuffer::articulationCount)
+      .def_readonly("max_dof", &SceneStateBuffer::maxDof)
+      .def_property_readonly("actor_ids",
+                             [](py::object self) {
+                               auto &b = self.cast<SceneStateBuffer &>();
+                               return py::array_t<physx_id_t>(b.actorCount, b.actorIds.data(),
+                                                              self);
+                             })
+      .def_property_readonly("actor_poses",
+                             [](py::object self) {
+                               auto &b = self.cast<SceneStateBuffer &>();
+                               return make_view(b.actorPoses, b.actorCount, 7, self);
+                             })
+      .def_property_readonly("actor_velocities",
+                             [](py::object self) {
+                               auto &b = self.cast<SceneStateBuffer &>();
+                               return make_view(b.actorVelocities, b.actorCount, 6, self);
+                             })
+      .def_property_readonly("articulation_ids",
+                             [](py::object self) {
+                               auto &b = self.cast<SceneStateBuffer &>();
+                               return py::array_t<physx_id_t>(
+                                   b.articulationCount, b.articulationIds.data(), self);
+                             })
+      .def_property_readonly("articulation_dofs",
+                             [](py::object self) {
+                               auto &b = self.cast<SceneStateBuffer &>();
+                               return py::array_t<uint32_t>(b.articulationCount,
+                                                            b.articulationDofs.data(), self);
+                             })
+      .def_property_readonly("qpos",
+                             [](py::object self) {
+                               auto &b = self.cast<SceneStateBuffer &>();
+                               return make_view(b.qpos, b.articulationCount, b.maxDof, self);
+                             })
+      .def_property_readonly("qvel",
+                             [](py::object self) {
+                               auto &b = self.cast<SceneStateBuffer &>();
+                               return make_view(b.qvel, b.articulationCount, b.maxDof, self);
+                             })
+      .def_property_readonly("drive_targets",
+                             [](py::object self) {
+                               auto &b = self.cast<SceneStateBuffer &>();
+                               return make_view(b.driveTargets, b.articulationCount, b.maxDof,
+                                                self);
+                             })
+      .def_property_readonly("drive_velocity_targets", [](py::object self) {
+        auto &b = self.cast<SceneStateBuffer &>();
+        return make_view(b.driveVelocityTargets, b.articulationCount, b.maxDof, self);
+      });
 
   //======= Drive =======//
   PyDrive.def("set_x_limit", &SDrive6D::setXLimit, py::arg("low"), py::arg("high"))
@@ -1171,6 +1725,14 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
       .def("get_scene", &SActorBase::getScene, py::return_value_policy::reference)
       .def("get_collision_shapes", &SActorBase::getCollisionShapes,
            py::return_value_policy::reference)
+      .def_property(
+          "contact_report_level",
+          [](SActorBase &a) { return optionalContactReportLevelName(a.getContactReportLevel()); },
+          [](SActorBase &a, std::optional<std::string> const &level) {
+            a.setContactReportLevel(getOptionalContactReportLevel(level));
+          },
+          "contact report level of all shapes of this actor, overrides the group and scene "
+          "levels; None inherits them")
       .def("get_visual_bodies", &SActorBase::getRenderBodies, py::return_value_policy::reference)
       .def("get_collision_visual_bodies", &SActorBase::getCollisionBodies,
            py::return_value_policy::reference)
@@ -1219,7 +1781,7 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
       .def_property("ccd", &SActorDynamicBase::getCCDEnabled, &SActorDynamicBase::setCCDEnabled);
 
   PyActorStatic.def("set_pose", &SActorStatic::setPose, py::arg("pose"))
-      .def("pack", &SActorStatic::packData)
+      .def("pack", py::overload_cast<>(&SActorStatic::packData))
       .def("unpack",
            [](SActorStatic &a,
               const py::array_t<PxReal, py::array::c_style | py::array::forcecast> &arr) {
@@ -1232,7 +1794,7 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
            [](SActor &a, py::array_t<PxReal> v) { a.setAngularVelocity(array2vec3(v)); })
       .def("lock_motion", &SActor::lockMotion, py::arg("x") = true, py::arg("y") = true,
            py::arg("z") = true, py::arg("rx") = true, py::arg("ry") = true, py::arg("rz") = true)
-      .def("pack", &SActor::packData)
+      .def("pack", py::overload_cast<>(&SActor::packData))
       .def("unpack",
            [](SActor &a,
               const py::array_t<PxReal, py::array::c_style | py::array::forcecast> &arr) {
@@ -1459,6 +2021,51 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
             a.setDriveVelocityTarget(std::vector<PxReal>(arr.data(), arr.data() + arr.size()));
           },
           py::arg("drive_velocity_target"))
+      .def(
+          "get_state",
+          [](SArticulation &a, std::vector<std::string> const &fields,
+             std::optional<py::array> out) {
+            uint32_t mask = getArticulationStateFields(fields);
+            auto result = getOutputArray(
+                out, {ArticulationStateField::count(mask), static_cast<py::ssize_t>(a.dof())});
+            a.getState(mask, result.mutable_data());
+            return result;
+          },
+          R"doc(
+Read several joint state fields with a single copy of the PhysX cache.
+
+Args:
+  fields: subset of "qpos", "qvel", "qacc", "qf", always packed in this order
+  out: optional float32 array of shape [field count, dof] to write into
+
+Returns: array of shape [field count, dof])doc",
+          py::arg("fields") = std::vector<std::string>{"qpos", "qvel", "qf"},
+          py::arg("out") = py::none())
+      .def(
+          "set_state",
+          [](SArticulation &a, std::vector<std::string> const &fields,
+             py::array_t<PxReal, py::array::c_style | py::array::forcecast> const &data) {
+            uint32_t mask = getArticulationStateFields(fields);
+            if (data.size() != ArticulationStateField::count(mask) * a.dof()) {
+              throw std::runtime_error("state should have shape [field count, dof]");
+            }
+            a.setState(mask, data.data());
+          },
+          "inverse of get_state", py::arg("fields"), py::arg("state"))
+      .def(
+          "set_drive_command",
+          [](SArticulation &a, DriveArray const &target, DriveArray const &velocityTarget,
+             DriveArray const &stiffness, DriveArray const &damping,
+             DriveArray const &forceLimit) {
+            a.applyDriveCommand(makeDriveCommand(target, velocityTarget, stiffness, damping,
+                                                 forceLimit, a.dof()));
+          },
+          R"doc(
+Set drive targets and properties of all active joints in one call, arguments left as None are
+unchanged. Every array holds dof values. Drive types (force or acceleration) are kept.)doc",
+          py::arg("target") = py::none(), py::arg("velocity_target") = py::none(),
+          py::arg("stiffness") = py::none(), py::arg("damping") = py::none(),
+          py::arg("force_limit") = py::none())
 
       .def("get_active_joints", &SArticulation::getActiveJoints,
            py::return_value_policy::reference)
@@ -1515,6 +2122,29 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
       .def("compute_manipulator_inertia_matrix", &SArticulation::computeManipulatorInertiaMatrix)
       .def("compute_spatial_twist_jacobian", &SArticulation::computeSpatialTwistJacobianMatrix)
       .def("compute_world_cartesian_jacobian", &SArticulation::computeWorldCartesianJacobianMatrix)
+      .def(
+          "get_kinematics_bundle",
+          [](py::object self) {
+            auto &bundle = self.cast<SArticulation &>().getKinematicsBundle();
+            auto policy = py::return_value_policy::reference_internal;
+            return py::make_tuple(py::cast(bundle.cartesianJacobian, policy, self),
+                                  py::cast(bundle.massMatrix, policy, self),
+                                  py::cast(bundle.passiveForce, policy, self));
+          },
+          R"doc(
+World Cartesian Jacobian, manipulator inertia matrix and passive force (gravity and Coriolis)
+of the current state, computed once per step or state change.
+
+Returns: read-only views (jacobian, mass_matrix, passive_force) into storage of the
+articulation; they are overwritten when the state changes and the bundle is requested again,
+copy them to keep old values)doc")
+      .def("mark_kinematics_dirty", &SArticulation::markKinematicsDirty,
+           R"doc(
+Drop the cached Jacobian, mass matrix and passive force.
+
+They are recomputed after every step and state change, but not after changes the articulation
+cannot see. Call this after changing link mass, inertia or collision geometry at runtime through
+PhysX directly, before querying the kinematics again in the same step.)doc")
       .def("compute_transformation_matrix",
            py::overload_cast<uint32_t, uint32_t>(&SArticulation::computeRelativeTransformation),
            py::arg("source_link_id"), py::arg("target_link_id"))
@@ -1526,7 +2156,7 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
       .def("compute_cartesian_diff_ik", &SArticulation::computeCartesianVelocityDiffIK,
            py::arg("world_velocity"), py::arg("commanded_link_id"),
            py::arg("active_joint_ids") = std::vector<uint32_t>())
-      .def("pack", &SArticulation::packData)
+      .def("pack", py::overload_cast<>(&SArticulation::packData))
       .def("unpack",
            [](SArticulation &a,
               const py::array_t<PxReal, py::array::c_style | py::array::forcecast> &arr) {
@@ -1551,7 +2181,11 @@ If after testing g2 and g3, the objects may collide, g0 and g1 come into play. g
       .def_readonly("starts", &SContact::starts)
       .def_readonly("persists", &SContact::persists)
       .def_readonly("ends", &SContact::ends)
-      .def_readonly("points", &SContact::points)
+      .def_property_readonly("points",
+                             [](SContact &contact) {
+                               return std::vector<SContactPoint>(contact.points.begin(),
+                                                                 contact.points.end());
+                             })
       .def("__repr__", [](SContact const &c) {
         std::ostringstream oss;
         oss << "Contact(actor0=" << c.actors[0]->getName() << ", actor1=" << c.actors[1]->getName()
@@ -1766,14 +2400,28 @@ References:
            py::arg("group2"), py::arg("group3"))
       .def("reset_collision_groups", &ActorBuilder::resetCollisionGroup)
       .def(
-          "build", [](ActorBuilder &a, std::string const &name) { return a.build(false, name); },
-          py::arg("name") = "", py::return_value_policy::reference)
+          "build",
+          [](ActorBuilder &a, std::string const &name, bool reuse) {
+            return a.build(false, name, reuse);
+          },
+          py::arg("name") = "", py::arg("reuse") = false, py::return_value_policy::reference,
+          R"doc(
+Build a dynamic actor.
+
+Args:
+  name: name of the actor
+  reuse: take an actor deactivated by Scene.deactivate_actor that this builder built since its
+    last modification when there is one. The actor gets a new id, an identity pose, zero
+    velocity and the properties set by the builder; callbacks added to it are dropped.)doc")
       .def(
           "build_kinematic",
-          [](ActorBuilder &a, std::string const &name) { return a.build(true, name); },
-          py::arg("name") = "", py::return_value_policy::reference)
+          [](ActorBuilder &a, std::string const &name, bool reuse) {
+            return a.build(true, name, reuse);
+          },
+          py::arg("name") = "", py::arg("reuse") = false, py::return_value_policy::reference,
+          "see build")
       .def("build_static", &ActorBuilder::buildStatic, py::return_value_policy::reference,
-           py::arg("name") = "");
+           py::arg("name") = "", py::arg("reuse") = false, "see build");
 
   PyShapeRecord.def_readonly("filename", &ActorBuilder::ShapeRecord::filename)
       .def_property_readonly("type",
@@ -2017,7 +2665,8 @@ Returns:
 )doc",
            py::arg("link_index"), py::arg("pose"), py::arg("initial_qpos") = Eigen::VectorXd{},
            py::arg("active_qmask") = Eigen::VectorXi{}, py::arg("eps") = 1e-4,
-           py::arg("max_iterations") = 1000, py::arg("dt") = 0.1, py::arg("damp") = 1e-6)
+           py::arg("max_iterations") = 1000, py::arg("dt") = 0.1, py::arg("damp") = 1e-6,
+           py::call_guard<py::gil_scoped_release>())
       .def("compute_forward_dynamics", &PinocchioModel::computeForwardDynamics, py::arg("qpos"),
            py::arg("qvel"), py::arg("qf"))
       .def("compute_inverse_dynamics", &PinocchioModel::computeInverseDynamics, py::arg("qpos"),
@@ -2041,7 +2690,157 @@ Args:
       .def("compute_single_link_local_jacobian", &PinocchioModel::computeSingleLinkLocalJacobian,
            "Compute the link(body) Jacobian for a single link. It is faster than "
            "compute_full_jacobian followed by get_link_jacobian",
-           py::arg("qpos"), py::arg("link_index"));
+           py::arg("qpos"), py::arg("link_index"))
+      .def_property("batch_thread_count", &PinocchioModel::getBatchThreadCount,
+                    &PinocchioModel::setBatchThreadCount,
+                    "maximum number of shared pool workers used by the batched functions besides "
+                    "the calling thread, 0 computes on the calling thread")
+      .def(
+          "compute_forward_kinematics_batch",
+          [](PinocchioModel &m, PinocchioModel::RowMatrixXd const &qpos) {
+            PinocchioModel::RowMatrixXd poses;
+            {
+              py::gil_scoped_release release;
+              poses = m.computeForwardKinematicsBatch(qpos);
+            }
+            py::ssize_t links = poses.cols() / 7;
+            return py::array_t<double>({poses.rows(), links, py::ssize_t(7)}, poses.data());
+          },
+          R"doc(
+Compute link poses (in articulation base frame) for many configurations in parallel.
+
+Args:
+  qpos: [N, dof] array, one configuration per row
+Returns: [N, links, 7] array, each pose is [x, y, z, qw, qx, qy, qz])doc",
+          py::arg("qpos"))
+      .def(
+          "compute_link_jacobian_batch",
+          [](PinocchioModel &m, PinocchioModel::RowMatrixXd const &qpos, uint32_t linkIndex,
+             bool local) {
+            PinocchioModel::RowMatrixXd J;
+            {
+              py::gil_scoped_release release;
+              J = m.computeLinkJacobianBatch(qpos, linkIndex, local);
+            }
+            return py::array_t<double>({qpos.rows(), py::ssize_t(6), J.cols()}, J.data());
+          },
+          R"doc(
+Compute the Jacobian of a link for many configurations in parallel.
+
+Args:
+  qpos: [N, dof] array, one configuration per row
+  link_index: index of the link
+  local: False for world(spatial) frame; True for link(body) frame
+Returns: [N, 6, dof] array)doc",
+          py::arg("qpos"), py::arg("link_index"), py::arg("local") = false)
+      .def("compute_inverse_dynamics_derivatives",
+           &PinocchioModel::computeInverseDynamicsDerivatives,
+           R"doc(
+Compute the partial derivatives of compute_inverse_dynamics with analytic derivatives of RNEA.
+
+Returns:
+  dtau_dqpos, dtau_dqvel, dtau_dqacc: [dof, dof] arrays, dtau_dqacc is the mass matrix)doc",
+           py::arg("qpos"), py::arg("qvel"), py::arg("qacc"),
+           py::call_guard<py::gil_scoped_release>())
+      .def("compute_forward_dynamics_derivatives",
+           &PinocchioModel::computeForwardDynamicsDerivatives,
+           R"doc(
+Compute the partial derivatives of compute_forward_dynamics with analytic derivatives of ABA.
+
+Returns:
+  dqacc_dqpos, dqacc_dqvel, dqacc_dqf: [dof, dof] arrays, dqacc_dqf is the inverse mass matrix)doc",
+           py::arg("qpos"), py::arg("qvel"), py::arg("qf"),
+           py::call_guard<py::gil_scoped_release>())
+      .def("compute_link_velocity_derivatives", &PinocchioModel::computeLinkVelocityDerivatives,
+           R"doc(
+Compute the partial derivatives of a link velocity w.r.t. qpos and qvel.
+
+Args:
+  link_index: index of the link
+  local: False for the spatial twist in world frame; True for the body twist in link frame
+Returns:
+  dv_dqpos, dv_dqvel: [6, dof] arrays, dv_dqvel is the link Jacobian)doc",
+           py::arg("qpos"), py::arg("qvel"), py::arg("link_index"), py::arg("local") = false,
+           py::call_guard<py::gil_scoped_release>())
+      .def("compute_link_jacobian_time_variation",
+           &PinocchioModel::computeLinkJacobianTimeVariation,
+           "Compute the time derivative of the link Jacobian at the given qpos and qvel, see "
+           "get_link_jacobian for local",
+           py::arg("qpos"), py::arg("qvel"), py::arg("link_index"), py::arg("local") = false,
+           py::call_guard<py::gil_scoped_release>())
+      .def(
+          "compute_inverse_dynamics_derivatives_batch",
+          [](PinocchioModel &m, PinocchioModel::RowMatrixXd const &qpos,
+             PinocchioModel::RowMatrixXd const &qvel, PinocchioModel::RowMatrixXd const &qacc) {
+            PinocchioModel::RowMatrixXd dq, dv, da;
+            {
+              py::gil_scoped_release release;
+              std::tie(dq, dv, da) = m.computeInverseDynamicsDerivativesBatch(qpos, qvel, qacc);
+            }
+            std::vector<py::ssize_t> shape{qpos.rows(), qpos.cols(), qpos.cols()};
+            return py::make_tuple(py::array_t<double>(shape, dq.data()),
+                                  py::array_t<double>(shape, dv.data()),
+                                  py::array_t<double>(shape, da.data()));
+          },
+          R"doc(
+compute_inverse_dynamics_derivatives for many configurations in parallel.
+
+Args:
+  qpos, qvel, qacc: [N, dof] arrays, one configuration per row
+Returns: dtau_dqpos, dtau_dqvel, dtau_dqacc as [N, dof, dof] arrays)doc",
+          py::arg("qpos"), py::arg("qvel"), py::arg("qacc"))
+      .def(
+          "compute_forward_dynamics_derivatives_batch",
+          [](PinocchioModel &m, PinocchioModel::RowMatrixXd const &qpos,
+             PinocchioModel::RowMatrixXd const &qvel, PinocchioModel::RowMatrixXd const &qf) {
+            PinocchioModel::RowMatrixXd dq, dv, dtau;
+            {
+              py::gil_scoped_release release;
+              std::tie(dq, dv, dtau) = m.computeForwardDynamicsDerivativesBatch(qpos, qvel, qf);
+            }
+            std::vector<py::ssize_t> shape{qpos.rows(), qpos.cols(), qpos.cols()};
+            return py::make_tuple(py::array_t<double>(shape, dq.data()),
+                                  py::array_t<double>(shape, dv.data()),
+                                  py::array_t<double>(shape, dtau.data()));
+          },
+          R"doc(
+compute_forward_dynamics_derivatives for many configurations in parallel.
+
+Args:
+  qpos, qvel, qf: [N, dof] arrays, one configuration per row
+Returns: dqacc_dqpos, dqacc_dqvel, dqacc_dqf as [N, dof, dof] arrays)doc",
+          py::arg("qpos"), py::arg("qvel"), py::arg("qf"))
+      .def("compute_inverse_dynamics_batch", &PinocchioModel::computeInverseDynamicsBatch,
+           "compute_inverse_dynamics for many configurations in parallel, all arguments and the "
+           "result have shape [N, dof]",
+           py::arg("qpos"), py::arg("qvel"), py::arg("qacc"),
+           py::call_guard<py::gil_scoped_release>())
+      .def("compute_inverse_kinematics_multi_seed",
+           &PinocchioModel::computeInverseKinematicsMultiSeed,
+           R"doc(
+Compute inverse kinematics for many target poses of one link, every target is solved from
+several seeds in parallel and the remaining seeds of a target stop once one of them converges.
+Unlike compute_inverse_kinematics, joint positions are kept within their limits.
+
+Args:
+    link_index: index of the link
+    poses: list of target poses of the link in articulation base frame
+    seed_count: number of seeds per target, the first seed is initial_qpos (or the neutral configuration) and the others are random
+    initial_qpos: first seed
+    active_qmask: dof sized integer array, 1 to indicate active joints and 0 for inactive joints, default to all 1s
+    max_iterations: number of iterations steps per seed
+    dt: iteration step "speed"
+    damp: iteration step "damping"
+Returns:
+    result: qpos from IK with shape [N, dof]
+    success: whether IK is successful for every target
+    error: se3 error of every target with shape [N, 6]
+)doc",
+           py::arg("link_index"), py::arg("poses"), py::arg("seed_count") = 8,
+           py::arg("initial_qpos") = Eigen::VectorXd{},
+           py::arg("active_qmask") = Eigen::VectorXi{}, py::arg("eps") = 1e-4,
+           py::arg("max_iterations") = 1000, py::arg("dt") = 0.1, py::arg("damp") = 1e-6,
+           py::call_guard<py::gil_scoped_release>());
 
   PyVulkanRenderer
       .def_static("set_log_level", &Renderer::SVulkan2Renderer::setLogLevel, py::arg("level"))
@@ -10,11 +10,11 @@ ActorBuilder::ActorBuilder(SScene *scene) : mScene(scene) {}
 
 std::shared_ptr<ActorBuilder> ActorBuilder::removeAllShapes() {
   mShapeRecord.clear();
-  return shared_from_this();
+  return modified();
 }
 std::shared_ptr<ActorBuilder> ActorBuilder::removeAllVisuals() {
   mVisualRecord.clear();
-  return shared_from_this();
+  return modified();
 }
 int ActorBuilder::getShapeCount() const { return mShapeRecord.size(); }
 int ActorBuilder::getVisualCount() const { return mVisualRecord.size(); }
@@ -22,13 +22,13 @@ std::shared_ptr<ActorBuilder> ActorBuilder::removeShapeAt(uint32_t index) {
   if (index < mShapeRecord.size()) {
     mShapeRecord.erase(mShapeRecord.begin() + index);
   }
-  return shared_from_this();
+  return modified();
 }
 std::shared_ptr<ActorBuilder> ActorBuilder::removeVisualAt(uint32_t index) {
   if (index < mVisualRecord.size()) {
     mVisualRecord.erase(mVisualRecord.begin() + index);
   }
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder> ActorBuilder::addNonConvexShapeFromFile(
@@ -48,7 +48,7 @@ std::shared_ptr<ActorBuilder> ActorBuilder::addNonConvexShapeFromFile(
 
   mShapeRecord.push_back(r);
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder>
@@ -69,7 +69,7 @@ ActorBuilder::addConvexShapeFromFile(const std::string &filename, const PxTransf
 
   mShapeRecord.push_back(r);
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder> ActorBuilder::addMultipleConvexShapesFromFile(
@@ -90,7 +90,7 @@ std::shared_ptr<ActorBuilder> ActorBuilder::addMultipleConvexShapesFromFile(
 
   mShapeRecord.push_back(r);
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder>
@@ -109,7 +109,7 @@ ActorBuilder::addBoxShape(const PxTransform &pose, const PxVec3 &halfSize,
 
   mShapeRecord.push_back(r);
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder>
@@ -129,7 +129,7 @@ ActorBuilder::addCapsuleShape(const PxTransform &pose, PxReal radius, PxReal hal
 
   mShapeRecord.push_back(r);
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder>
@@ -148,7 +148,7 @@ ActorBuilder::addSphereShape(const PxTransform &pose, PxReal radius,
 
   mShapeRecord.push_back(r);
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder>
@@ -157,7 +157,7 @@ ActorBuilder::addBoxVisualWithMaterial(const PxTransform &pose, const PxVec3 &ha
                                        std::string const &name) {
   auto renderer = mScene->getSimulation()->getRenderer();
   if (!renderer) {
-    return shared_from_this();
+    return modified();
   }
   if (!material) {
     material = mScene->getSimulation()->getRenderer()->createMaterial();
@@ -171,7 +171,7 @@ ActorBuilder::addBoxVisualWithMaterial(const PxTransform &pose, const PxVec3 &ha
 
   mVisualRecord.push_back(r);
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder> ActorBuilder::addBoxVisual(const PxTransform &pose,
@@ -183,7 +183,7 @@ std::shared_ptr<ActorBuilder> ActorBuilder::addBoxVisual(const PxTransform &pose
     mat->setBaseColor({color.x, color.y, color.z, 1.f});
     addBoxVisualWithMaterial(pose, size, mat, name);
   }
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder> ActorBuilder::addCapsuleVisualWithMaterial(
@@ -191,7 +191,7 @@ std::shared_ptr<ActorBuilder> ActorBuilder::addCapsuleVisualWithMaterial(
     std::shared_ptr<Renderer::IPxrMaterial> material, std::string const &name) {
   auto renderer = mScene->getSimulation()->getRenderer();
   if (!renderer) {
-    return shared_from_this();
+    return modified();
   }
   if (!material) {
     material = mScene->getSimulation()->getRenderer()->createMaterial();
@@ -206,7 +206,7 @@ std::shared_ptr<ActorBuilder> ActorBuilder::addCapsuleVisualWithMaterial(
 
   mVisualRecord.push_back(r);
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder> ActorBuilder::addCapsuleVisual(const PxTransform &pose,
@@ -220,7 +220,7 @@ std::shared_ptr<ActorBuilder> ActorBuilder::addCapsuleVisual(const PxTransform &
     addCapsuleVisualWithMaterial(pose, radius, halfLength, mat, name);
   }
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder>
@@ -240,7 +240,7 @@ ActorBuilder::addSphereVisualWithMaterial(const PxTransform &pose, PxReal radius
 
   mVisualRecord.push_back(r);
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder> ActorBuilder::addSphereVisual(const PxTransform &pose, PxReal radius,
@@ -253,7 +253,7 @@ std::shared_ptr<ActorBuilder> ActorBuilder::addSphereVisual(const PxTransform &p
     addSphereVisualWithMaterial(pose, radius, mat, name);
   }
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder> ActorBuilder::addVisualFromFile(
@@ -269,7 +269,7 @@ std::shared_ptr<ActorBuilder> ActorBuilder::addVisualFromFile(
 
   mVisualRecord.push_back(r);
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder> ActorBuilder::addVisualFromMeshWithMaterial(
@@ -288,7 +288,7 @@ std::shared_ptr<ActorBuilder> ActorBuilder::addVisualFromMeshWithMaterial(
   r.name = name;
   mVisualRecord.push_back(r);
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder>
@@ -298,12 +298,36 @@ ActorBuilder::setMassAndInertia(PxReal mass, PxTransform const &cMassPose, PxVec
   mCMassPose = cMassPose;
   mInertia = inertia;
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder> ActorBuilder::setScene(SScene *scene) {
   mScene = scene;
-  return shared_from_this();
+  return modified();
+}
+
+void ActorBuilder::collectMeshes(std::vector<std::pair<MeshLoadType, std::string>> &meshes) const {
+  for (auto &r : mShapeRecord) {
+    switch (r.type) {
+    case ShapeRecord::Type::NonConvexMesh:
+      meshes.push_back({MeshLoadType::NON_CONVEX, r.filename});
+      break;
+    case ShapeRecord::Type::SingleMesh:
+      meshes.push_back({MeshLoadType::CONVEX, r.filename});
+      break;
+    case ShapeRecord::Type::MultipleMeshes:
+      meshes.push_back({MeshLoadType::GROUP, r.filename});
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+void ActorBuilder::preloadMeshes() const {
+  std::vector<std::pair<MeshLoadType, std::string>> meshes;
+  collectMeshes(meshes);
+  mScene->getSimulation()->getMeshManager().preloadMeshes(meshes);
 }
 
 void ActorBuilder::buildShapes(std::vector<std::unique_ptr<SCollisionShape>> &shapes,
@@ -494,7 +518,7 @@ std::shared_ptr<ActorBuilder> ActorBuilder::setCollisionGroup(uint32_t g0, uint3
   mCollisionGroup.w2 = g2;
   mCollisionGroup.w3 = g3;
 
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder> ActorBuilder::addCollisionGroup(uint32_t g0, uint32_t g1,
@@ -511,7 +535,7 @@ std::shared_ptr<ActorBuilder> ActorBuilder::addCollisionGroup(uint32_t g0, uint3
   if (g3) {
     mCollisionGroup.w2 |= 1 << (g3 - 1);
   }
-  return shared_from_this();
+  return modified();
 }
 
 std::shared_ptr<ActorBuilder> ActorBuilder::resetCollisionGroup() {
@@ -519,7 +543,7 @@ std::shared_ptr<ActorBuilder> ActorBuilder::resetCollisionGroup() {
   mCollisionGroup.w1 = 1;
   mCollisionGroup.w2 = 0;
   mCollisionGroup.w3 = 0;
-  return shared_from_this();
+  return modified();
 }
 
 void ActorBuilder::buildCollisionVisuals(
@@ -666,11 +690,41 @@ void ActorBuilder::buildCollisionVisuals(
   }
 }
 
-SActor *ActorBuilder::build(bool isKinematic, std::string const &name) const {
+template <class T> void ActorBuilder::resetReusedActor(T *actor, std::string const &name) const {
+  actor->setName(name);
+  actor->mCol1 = mCollisionGroup.w0;
+  actor->mCol2 = mCollisionGroup.w1;
+  actor->mCol3 = mCollisionGroup.w2;
+  for (auto shape : actor->getCollisionShapes()) {
+    shape->setCollisionGroups(mCollisionGroup.w0, mCollisionGroup.w1, mCollisionGroup.w2,
+                              mCollisionGroup.w3);
+  }
+}
+
+SActor *ActorBuilder::build(bool isKinematic, std::string const &name, bool reuse) const {
+  if (reuse) {
+    if (auto actor = static_cast<SActor *>(mScene->reuseActor(
+            this, mRevision, isKinematic ? EActorType::KINEMATIC : EActorType::DYNAMIC))) {
+      resetReusedActor(actor, name);
+      auto px = actor->getPxActor();
+      px->setMass(actor->mBuiltMass);
+      px->setCMassLocalPose(actor->mBuiltCMassPose);
+      px->setMassSpaceInertiaTensor(actor->mBuiltInertia);
+      px->setLinearDamping(0.f);
+      px->setAngularDamping(0.05f);
+      px->setRigidBodyFlag(PxRigidBodyFlag::eENABLE_CCD, false);
+      px->setRigidDynamicLockFlags(PxRigidDynamicLockFlags());
+      px->setSleepThreshold(mScene->mDefaultSleepThreshold);
+      px->setSolverIterationCounts(mScene->mDefaultSolverIterations,
+                                   mScene->mDefaultSolverVelocityIterations);
+      return actor;
+    }
+  }
   physx_id_t actorId = mScene->mActorIdGenerator.next();
 
   std::vector<std::unique_ptr<SCollisionShape>> shapes;
   std::vector<PxReal> densities;
+  preloadMeshes();
   buildShapes(shapes, densities);
 
   std::vector<physx_id_t> renderIds;
@@ -739,18 +793,31 @@ SActor *ActorBuilder::build(bool isKinematic, std::string const &name) const {
   actor->setSolverIterationCounts(mScene->mDefaultSolverIterations,
                                   mScene->mDefaultSolverVelocityIterations);
 
+  sActor->mBuiltMass = actor->getMass();
+  sActor->mBuiltCMassPose = actor->getCMassLocalPose();
+  sActor->mBuiltInertia = actor->getMassSpaceInertiaTensor();
+
   auto result = sActor.get();
   mScene->addActor(std::move(sActor));
 
   result->mBuilder = shared_from_this();
+  result->mBuilderRevision = mRevision;
   return result;
 }
 
-SActorStatic *ActorBuilder::buildStatic(std::string const &name) const {
+SActorStatic *ActorBuilder::buildStatic(std::string const &name, bool reuse) const {
+  if (reuse) {
+    if (auto actor = static_cast<SActorStatic *>(
+            mScene->reuseActor(this, mRevision, EActorType::STATIC))) {
+      resetReusedActor(actor, name);
+      return actor;
+    }
+  }
   physx_id_t actorId = mScene->mActorIdGenerator.next();
 
   std::vector<std::unique_ptr<SCollisionShape>> shapes;
   std::vector<PxReal> densities;
+  preloadMeshes();
   buildShapes(shapes, densities);
 
   std::vector<physx_id_t> renderIds;
@@ -794,6 +861,7 @@ SActorStatic *ActorBuilder::buildStatic(std::string const &name) const {
   mScene->addActor(std::move(sActor));
 
   result->mBuilder = shared_from_this();
+  result->mBuilderRevision = mRevision;
   return result;
 }
 
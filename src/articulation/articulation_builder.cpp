@@ -392,12 +392,23 @@ bool ArticulationBuilder::prebuild(std::vector<int> &tosort) const {
   return true;
 }
 
+void ArticulationBuilder::preloadMeshes() const {
+  // load the meshes of all links at once, links are then assembled sequentially
+  std::vector<std::pair<MeshLoadType, std::string>> meshes;
+  for (auto &builder : mLinkBuilders) {
+    builder->collectMeshes(meshes);
+  }
+  mScene->getSimulation()->getMeshManager().preloadMeshes(meshes);
+}
+
 SArticulation *ArticulationBuilder::build(bool fixBase) const {
   std::vector<int> sorted;
   if (!prebuild(sorted)) {
     return nullptr;
   }
 
+  preloadMeshes();
+
   auto sArticulation = std::unique_ptr<SArticulation>(new SArticulation(mScene));
   sArticulation->mPxArticulation =
       mScene->getSimulation()->mPhysicsSDK->createArticulationReducedCoordinate();
@@ -524,6 +535,8 @@ SKArticulation *ArticulationBuilder::buildKinematic() const {
     return nullptr;
   }
 
+  preloadMeshes();
+
   auto articulation = std::unique_ptr<SKArticulation>(new SKArticulation(mScene));
   articulation->mLinks.resize(mLinkBuilders.size());
   articulation->mJoints.resize(mLinkBuilders.size());
@@ -1,15 +1,27 @@
 #include "sapien/articulation/pinocchio_model.h"
+#include <pinocchio/algorithm/aba-derivatives.hpp>
 #include <pinocchio/algorithm/aba.hpp>
 #include <pinocchio/algorithm/crba.hpp>
+#include <pinocchio/algorithm/frames-derivatives.hpp>
+#include <pinocchio/algorithm/frames.hpp>
 #include <pinocchio/algorithm/joint-configuration.hpp>
+#include <pinocchio/algorithm/kinematics-derivatives.hpp>
+#include <pinocchio/algorithm/rnea-derivatives.hpp>
 #include <pinocchio/algorithm/rnea.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #define ASSERT(exp, info)                                                                         \
   if (!(exp)) {                                                                                   \
     throw std::runtime_error((info));                                                             \
   }
 
 namespace sapien {
+PinocchioModel::PinocchioModel()
+    : mBatchThreadCount(std::max(1u, std::thread::hardware_concurrency()) - 1) {}
+
 std::unique_ptr<PinocchioModel> PinocchioModel::fromURDFXML(std::string const &urdf,
                                                             Eigen::Vector3d gravity) {
   auto m = std::unique_ptr<PinocchioModel>(new PinocchioModel);
@@ -17,10 +29,19 @@ std::unique_ptr<PinocchioModel> PinocchioModel::fromURDFXML(std::string const &u
   m->model.gravity = {gravity, Eigen::Vector3d{0, 0, 0}};
   m->data = pinocchio::Data(m->model);
   m->indexS2P.setIdentity(m->model.nv);
+  for (int j = 1; j < m->model.njoints; ++j) {
+    if (m->model.nqs[j] == 1) {
+      int q = m->model.idx_qs[j];
+      if (std::isfinite(m->model.lowerPositionLimit[q]) &&
+          std::isfinite(m->model.upperPositionLimit[q])) {
+        m->mLimitedQ.push_back(q);
+      }
+    }
+  }
   return m;
 }
 
-Eigen::VectorXd PinocchioModel::posS2P(const Eigen::VectorXd &qext) {
+Eigen::VectorXd PinocchioModel::posS2P(const Eigen::VectorXd &qext) const {
   Eigen::VectorXd qint(model.nq);
   uint32_t count = 0;
   for (Eigen::Index N = 0; N < QIDX.size(); ++N) {
@@ -45,7 +66,7 @@ Eigen::VectorXd PinocchioModel::posS2P(const Eigen::VectorXd &qext) {
   return qint;
 }
 
-Eigen::VectorXd PinocchioModel::posP2S(const Eigen::VectorXd &qint) {
+Eigen::VectorXd PinocchioModel::posP2S(const Eigen::VectorXd &qint) const {
   Eigen::VectorXd qext(model.nv);
 
   int count = 0;
@@ -114,14 +135,17 @@ void PinocchioModel::setLinkOrder(std::vector<std::string> names) {
 }
 
 Eigen::MatrixXd PinocchioModel::getRandomConfiguration() {
+  std::lock_guard lock(mMutex);
   return posP2S(pinocchio::randomConfiguration(model));
 }
 
 void PinocchioModel::computeForwardKinematics(const Eigen::VectorXd &qpos) {
+  std::lock_guard lock(mMutex);
   pinocchio::forwardKinematics(model, data, posS2P(qpos));
 }
 
 physx::PxTransform PinocchioModel::getLinkPose(uint32_t index) {
+  std::lock_guard lock(mMutex);
   ASSERT(index < linkIdx2FrameIdx.size(), "link index out of bound");
   auto frame = linkIdx2FrameIdx[index];
   auto parentJoint = model.frames[frame].parent;
@@ -135,11 +159,13 @@ physx::PxTransform PinocchioModel::getLinkPose(uint32_t index) {
 }
 
 void PinocchioModel::computeFullJacobian(const Eigen::VectorXd &qpos) {
+  std::lock_guard lock(mMutex);
   pinocchio::computeJointJacobians(model, data, posS2P(qpos));
 }
 
 Eigen::Matrix<double, 6, Eigen::Dynamic> PinocchioModel::getLinkJacobian(uint32_t index,
                                                                          bool local) {
+  std::lock_guard lock(mMutex);
   ASSERT(index < linkIdx2FrameIdx.size(), "link index out of bound");
   auto frameIdx = linkIdx2FrameIdx[index];
   auto jointIdx = model.frames[frameIdx].parent;
@@ -161,6 +187,7 @@ Eigen::Matrix<double, 6, Eigen::Dynamic> PinocchioModel::getLinkJacobian(uint32_
 
 Eigen::Matrix<double, 6, Eigen::Dynamic>
 PinocchioModel::computeSingleLinkLocalJacobian(Eigen::VectorXd const &qpos, uint32_t index) {
+  std::lock_guard lock(mMutex);
   ASSERT(index < linkIdx2FrameIdx.size(), "link index out of bound");
   auto frameIdx = linkIdx2FrameIdx[index];
   auto jointIdx = model.frames[frameIdx].parent;
@@ -173,6 +200,7 @@ PinocchioModel::computeSingleLinkLocalJacobian(Eigen::VectorXd const &qpos, uint
 }
 
 Eigen::MatrixXd PinocchioModel::computeGeneralizedMassMatrix(const Eigen::VectorXd &qpos) {
+  std::lock_guard lock(mMutex);
   pinocchio::crba(model, data, posS2P(qpos));
   data.M.triangularView<Eigen::StrictlyLower>() =
       data.M.transpose().triangularView<Eigen::StrictlyLower>();
@@ -181,6 +209,7 @@ Eigen::MatrixXd PinocchioModel::computeGeneralizedMassMatrix(const Eigen::Vector
 
 Eigen::MatrixXd PinocchioModel::computeCoriolisMatrix(const Eigen::VectorXd &qpos,
                                                       const Eigen::VectorXd &qvel) {
+  std::lock_guard lock(mMutex);
   return indexS2P.transpose() *
          pinocchio::computeCoriolisMatrix(model, data, posS2P(qpos), indexS2P * qvel) * indexS2P;
 }
@@ -188,6 +217,7 @@ Eigen::MatrixXd PinocchioModel::computeCoriolisMatrix(const Eigen::VectorXd &qpo
 Eigen::VectorXd PinocchioModel::computeInverseDynamics(const Eigen::VectorXd &qpos,
                                                        const Eigen::VectorXd &qvel,
                                                        const Eigen::VectorXd &qacc) {
+  std::lock_guard lock(mMutex);
   return indexS2P.transpose() *
          pinocchio::rnea(model, data, posS2P(qpos), indexS2P * qvel, indexS2P * qacc);
 }
@@ -195,79 +225,377 @@ Eigen::VectorXd PinocchioModel::computeInverseDynamics(const Eigen::VectorXd &qp
 Eigen::VectorXd PinocchioModel::computeForwardDynamics(const Eigen::VectorXd &qpos,
                                                        const Eigen::VectorXd &qvel,
                                                        const Eigen::VectorXd &qf) {
+  std::lock_guard lock(mMutex);
   return indexS2P.transpose() *
          pinocchio::aba(model, data, posS2P(qpos), indexS2P * qvel, indexS2P * qf);
 }
 
-std::tuple<Eigen::VectorXd, bool, Eigen::Matrix<double, 6, 1>>
-PinocchioModel::computeInverseKinematics(uint32_t linkIdx, physx::PxTransform const &pose,
-                                         Eigen::VectorXd const &initialQpos,
-                                         Eigen::VectorXi const &activeQMask, double eps,
-                                         int maxIter, double dt, double damp) {
-  ASSERT(linkIdx < linkIdx2FrameIdx.size(), "link index out of bound");
-  Eigen::VectorXd q;
-  if (initialQpos.size() == 0) {
-    q = pinocchio::neutral(model);
+static void fillLowerTriangle(Eigen::MatrixXd &M) {
+  M.triangularView<Eigen::StrictlyLower>() = M.transpose().triangularView<Eigen::StrictlyLower>();
+}
+
+std::tuple<Eigen::MatrixXd, Eigen::MatrixXd, Eigen::MatrixXd>
+PinocchioModel::computeInverseDynamicsDerivatives(const Eigen::VectorXd &qpos,
+                                                  const Eigen::VectorXd &qvel,
+                                                  const Eigen::VectorXd &qacc) {
+  std::lock_guard lock(mMutex);
+  Eigen::MatrixXd dq = Eigen::MatrixXd::Zero(model.nv, model.nv);
+  Eigen::MatrixXd dv = Eigen::MatrixXd::Zero(model.nv, model.nv);
+  Eigen::MatrixXd da = Eigen::MatrixXd::Zero(model.nv, model.nv);
+  Eigen::VectorXd v = indexS2P * qvel;
+  Eigen::VectorXd a = indexS2P * qacc;
+  pinocchio::computeRNEADerivatives(model, data, posS2P(qpos), v, a, dq, dv, da);
+  fillLowerTriangle(da);
+  return {indexS2P.transpose() * dq * indexS2P, indexS2P.transpose() * dv * indexS2P,
+          indexS2P.transpose() * da * indexS2P};
+}
+
+std::tuple<Eigen::MatrixXd, Eigen::MatrixXd, Eigen::MatrixXd>
+PinocchioModel::computeForwardDynamicsDerivatives(const Eigen::VectorXd &qpos,
+                                                  const Eigen::VectorXd &qvel,
+                                                  const Eigen::VectorXd &qf) {
+  std::lock_guard lock(mMutex);
+  Eigen::MatrixXd dq = Eigen::MatrixXd::Zero(model.nv, model.nv);
+  Eigen::MatrixXd dv = Eigen::MatrixXd::Zero(model.nv, model.nv);
+  Eigen::MatrixXd dtau = Eigen::MatrixXd::Zero(model.nv, model.nv);
+  Eigen::VectorXd v = indexS2P * qvel;
+  Eigen::VectorXd tau = indexS2P * qf;
+  pinocchio::computeABADerivatives(model, data, posS2P(qpos), v, tau, dq, dv, dtau);
+  fillLowerTriangle(dtau);
+  return {indexS2P.transpose() * dq * indexS2P, indexS2P.transpose() * dv * indexS2P,
+          indexS2P.transpose() * dtau * indexS2P};
+}
+
+std::tuple<Eigen::Matrix<double, 6, Eigen::Dynamic>, Eigen::Matrix<double, 6, Eigen::Dynamic>>
+PinocchioModel::computeLinkVelocityDerivatives(const Eigen::VectorXd &qpos,
+                                               const Eigen::VectorXd &qvel, uint32_t index,
+                                               bool local) {
+  std::lock_guard lock(mMutex);
+  ASSERT(index < linkIdx2FrameIdx.size(), "link index out of bound");
+  auto frameIdx = linkIdx2FrameIdx[index];
+  Eigen::VectorXd v = indexS2P * qvel;
+  pinocchio::computeForwardKinematicsDerivatives(model, data, posS2P(qpos), v,
+                                                 Eigen::VectorXd::Zero(model.nv));
+  pinocchio::updateFramePlacements(model, data);
+
+  Eigen::Matrix<double, 6, Eigen::Dynamic> dq = Eigen::MatrixXd::Zero(6, model.nv);
+  Eigen::Matrix<double, 6, Eigen::Dynamic> dv = Eigen::MatrixXd::Zero(6, model.nv);
+  pinocchio::getFrameVelocityDerivatives(
+      model, data, frameIdx, local ? pinocchio::LOCAL : pinocchio::WORLD, dq, dv);
+  return {dq * indexS2P, dv * indexS2P};
+}
+
+Eigen::Matrix<double, 6, Eigen::Dynamic>
+PinocchioModel::computeLinkJacobianTimeVariation(const Eigen::VectorXd &qpos,
+                                                 const Eigen::VectorXd &qvel, uint32_t index,
+                                                 bool local) {
+  std::lock_guard lock(mMutex);
+  ASSERT(index < linkIdx2FrameIdx.size(), "link index out of bound");
+  auto frameIdx = linkIdx2FrameIdx[index];
+  Eigen::VectorXd v = indexS2P * qvel;
+  pinocchio::computeJointJacobiansTimeVariation(model, data, posS2P(qpos), v);
+  pinocchio::updateFramePlacements(model, data);
+
+  Eigen::Matrix<double, 6, Eigen::Dynamic> dJ = Eigen::MatrixXd::Zero(6, model.nv);
+  pinocchio::getFrameJacobianTimeVariation(model, data, frameIdx,
+                                           local ? pinocchio::LOCAL : pinocchio::WORLD, dJ);
+  return dJ * indexS2P;
+}
+
+void PinocchioModel::setBatchThreadCount(uint32_t count) { mBatchThreadCount = count; }
+
+void PinocchioModel::parallelRows(uint32_t rows,
+                                  std::function<void(BatchContext &, uint32_t)> const &fn) {
+  if (rows == 0) {
+    return;
+  }
+  std::lock_guard lock(mMutex);
+  auto &jobs = getProcessJobSystem();
+  // the calling thread helps in parallelFor, so it gets a chunk as well
+  uint32_t chunks = std::min(rows, std::min(mBatchThreadCount, jobs.getThreadCount()) + 1);
+  while (mBatchContexts.size() < chunks) {
+    mBatchContexts.push_back(std::make_unique<BatchContext>(model));
+  }
+  auto runChunk = [&](uint32_t chunk) {
+    uint32_t begin = static_cast<uint64_t>(rows) * chunk / chunks;
+    uint32_t end = static_cast<uint64_t>(rows) * (chunk + 1) / chunks;
+    for (uint32_t row = begin; row < end; ++row) {
+      fn(*mBatchContexts[chunk], row);
+    }
+  };
+  if (chunks == 1) {
+    runChunk(0);
   } else {
-    q = posS2P(initialQpos);
+    jobs.parallelFor(chunks, runChunk);
   }
+}
 
-  Eigen::VectorXd mask;
-  if (activeQMask.size() > 0) {
-    mask = indexS2P * activeQMask.cast<double>();
-  } else {
-    mask = Eigen::VectorXd(model.nv);
-    for (int i = 0; i < model.nv; ++i) {
-      mask(i) = 1.0;
+PinocchioModel::RowMatrixXd PinocchioModel::computeForwardKinematicsBatch(RowMatrixXd const &qpos) {
+  ASSERT(qpos.cols() == model.nv, "qpos should have shape [N, dof]");
+  uint32_t links = linkIdx2FrameIdx.size();
+  RowMatrixXd result(qpos.rows(), links * 7);
+  parallelRows(qpos.rows(), [&](BatchContext &context, uint32_t row) {
+    auto &d = context.data;
+    pinocchio::forwardKinematics(model, d, posS2P(qpos.row(row).transpose()));
+    for (uint32_t i = 0; i < links; ++i) {
+      auto &frame = model.frames[linkIdx2FrameIdx[i]];
+      auto link2world = d.oMi[frame.parent] * frame.placement;
+      auto P = link2world.translation();
+      auto Q = Eigen::Quaterniond(link2world.rotation());
+      result.block<1, 7>(row, i * 7) << P.x(), P.y(), P.z(), Q.w(), Q.x(), Q.y(), Q.z();
+    }
+  });
+  return result;
+}
+
+PinocchioModel::RowMatrixXd
+PinocchioModel::computeLinkJacobianBatch(RowMatrixXd const &qpos, uint32_t index, bool local) {
+  ASSERT(qpos.cols() == model.nv, "qpos should have shape [N, dof]");
+  ASSERT(index < linkIdx2FrameIdx.size(), "link index out of bound");
+  auto &frame = model.frames[linkIdx2FrameIdx[index]];
+  auto jointIdx = frame.parent;
+
+  RowMatrixXd result(qpos.rows() * 6, model.nv);
+  parallelRows(qpos.rows(), [&](BatchContext &context, uint32_t row) {
+    auto &d = context.data;
+    // joint frame Jacobian, also computes the joint placements on the way
+    pinocchio::Data::Matrix6x J = pinocchio::Data::Matrix6x::Zero(6, model.nv);
+    pinocchio::computeJointJacobian(model, d, posS2P(qpos.row(row).transpose()), jointIdx, J);
+    if (local) {
+      J = frame.placement.toActionMatrixInverse() * J;
+    } else {
+      J = d.oMi[jointIdx].toActionMatrix() * J;
     }
+    result.middleRows<6>(row * 6) = J * indexS2P;
+  });
+  return result;
+}
+
+PinocchioModel::RowMatrixXd PinocchioModel::computeInverseDynamicsBatch(RowMatrixXd const &qpos,
+                                                                       RowMatrixXd const &qvel,
+                                                                       RowMatrixXd const &qacc) {
+  ASSERT(qpos.cols() == model.nv && qvel.cols() == model.nv && qacc.cols() == model.nv &&
+             qvel.rows() == qpos.rows() && qacc.rows() == qpos.rows(),
+         "qpos, qvel and qacc should have shape [N, dof]");
+  RowMatrixXd result(qpos.rows(), model.nv);
+  parallelRows(qpos.rows(), [&](BatchContext &context, uint32_t row) {
+    auto &d = context.data;
+    Eigen::VectorXd v = indexS2P * qvel.row(row).transpose();
+    Eigen::VectorXd a = indexS2P * qacc.row(row).transpose();
+    Eigen::VectorXd tau = pinocchio::rnea(model, d, posS2P(qpos.row(row).transpose()), v, a);
+    result.row(row) = (indexS2P.transpose() * tau).transpose();
+  });
+  return result;
+}
+
+std::tuple<PinocchioModel::RowMatrixXd, PinocchioModel::RowMatrixXd, PinocchioModel::RowMatrixXd>
+PinocchioModel::computeInverseDynamicsDerivativesBatch(RowMatrixXd const &qpos,
+                                                       RowMatrixXd const &qvel,
+                                                       RowMatrixXd const &qacc) {
+  ASSERT(qpos.cols() == model.nv && qvel.cols() == model.nv && qacc.cols() == model.nv &&
+             qvel.rows() == qpos.rows() && qacc.rows() == qpos.rows(),
+         "qpos, qvel and qacc should have shape [N, dof]");
+  int nv = model.nv;
+  RowMatrixXd dq(qpos.rows() * nv, nv), dv(qpos.rows() * nv, nv), da(qpos.rows() * nv, nv);
+  parallelRows(qpos.rows(), [&](BatchContext &context, uint32_t row) {
+    context.dq.setZero(nv, nv);
+    context.dv.setZero(nv, nv);
+    context.da.setZero(nv, nv);
+    Eigen::VectorXd v = indexS2P * qvel.row(row).transpose();
+    Eigen::VectorXd a = indexS2P * qacc.row(row).transpose();
+    pinocchio::computeRNEADerivatives(model, context.data, posS2P(qpos.row(row).transpose()), v,
+                                      a, context.dq, context.dv, context.da);
+    fillLowerTriangle(context.da);
+    dq.middleRows(row * nv, nv) = indexS2P.transpose() * context.dq * indexS2P;
+    dv.middleRows(row * nv, nv) = indexS2P.transpose() * context.dv * indexS2P;
+    da.middleRows(row * nv, nv) = indexS2P.transpose() * context.da * indexS2P;
+  });
+  return {dq, dv, da};
+}
+
+std::tuple<PinocchioModel::RowMatrixXd, PinocchioModel::RowMatrixXd, PinocchioModel::RowMatrixXd>
+PinocchioModel::computeForwardDynamicsDerivativesBatch(RowMatrixXd const &qpos,
+                                                       RowMatrixXd const &qvel,
+                                                       RowMatrixXd const &qf) {
+  ASSERT(qpos.cols() == model.nv && qvel.cols() == model.nv && qf.cols() == model.nv &&
+             qvel.rows() == qpos.rows() && qf.rows() == qpos.rows(),
+         "qpos, qvel and qf should have shape [N, dof]");
+  int nv = model.nv;
+  RowMatrixXd dq(qpos.rows() * nv, nv), dv(qpos.rows() * nv, nv), dtau(qpos.rows() * nv, nv);
+  parallelRows(qpos.rows(), [&](BatchContext &context, uint32_t row) {
+    context.dq.setZero(nv, nv);
+    context.dv.setZero(nv, nv);
+    context.da.setZero(nv, nv);
+    Eigen::VectorXd v = indexS2P * qvel.row(row).transpose();
+    Eigen::VectorXd tau = indexS2P * qf.row(row).transpose();
+    pinocchio::computeABADerivatives(model, context.data, posS2P(qpos.row(row).transpose()), v,
+                                     tau, context.dq, context.dv, context.da);
+    fillLowerTriangle(context.da);
+    dq.middleRows(row * nv, nv) = indexS2P.transpose() * context.dq * indexS2P;
+    dv.middleRows(row * nv, nv) = indexS2P.transpose() * context.dv * indexS2P;
+    dtau.middleRows(row * nv, nv) = indexS2P.transpose() * context.da * indexS2P;
+  });
+  return {dq, dv, dtau};
+}
+
+Eigen::VectorXd PinocchioModel::getActiveMask(Eigen::VectorXi const &activeQMask) const {
+  if (activeQMask.size() > 0) {
+    return indexS2P * activeQMask.cast<double>();
   }
+  return Eigen::VectorXd::Ones(model.nv);
+}
 
+pinocchio::SE3 PinocchioModel::getJointTarget(uint32_t linkIdx,
+                                              physx::PxTransform const &pose) const {
   auto frameIdx = linkIdx2FrameIdx[linkIdx];
-  auto jointIdx = model.frames[frameIdx].parent;
   pinocchio::SE3 l2w;
   l2w.translation({pose.p.x, pose.p.y, pose.p.z});
   l2w.rotation(Eigen::Quaterniond(pose.q.w, pose.q.x, pose.q.y, pose.q.z).toRotationMatrix());
   auto l2j = model.frames[frameIdx].placement;
-  pinocchio::SE3 oMdes = l2w * l2j.inverse();
+  return l2w * l2j.inverse();
+}
 
-  pinocchio::Data::Matrix6x J(6, model.nv);
-  J.setZero();
-  bool success = false;
-  typedef Eigen::Matrix<double, 6, 1> Vector6d;
-  Vector6d err;
-  Eigen::VectorXd v(model.nv);
+bool PinocchioModel::runCLIK(pinocchio::Data &d, IKWorkspace &ws, pinocchio::JointIndex jointIdx,
+                             pinocchio::SE3 const &oMdes, Eigen::VectorXd const &mask, double eps,
+                             int maxIter, double dt, double damp, bool clampLimits,
+                             std::atomic<bool> const *cancel) {
+  // buffers keep their size between calls, the loop below does not allocate
+  ws.J.setZero(6, model.nv);
+  ws.v.resize(model.nv);
+  ws.qNext.resize(model.nq);
+  ws.bestQ = ws.q;
 
+  typedef Eigen::Matrix<double, 6, 1> Vector6d;
   double minError = 1e10;
-  Eigen::VectorXd bestQ = q;
-  Vector6d bestErr;
   for (int i = 0;; i++) {
-    pinocchio::forwardKinematics(model, data, q);
-    const pinocchio::SE3 dMi = oMdes.actInv(data.oMi[jointIdx]);
-    err = pinocchio::log6(dMi).toVector();
+    pinocchio::forwardKinematics(model, d, ws.q);
+    const pinocchio::SE3 dMi = oMdes.actInv(d.oMi[jointIdx]);
+    Vector6d err = pinocchio::log6(dMi).toVector();
     double errNorm = err.norm();
     if (errNorm < minError) {
       minError = errNorm;
-      bestQ = q;
-      bestErr = err;
+      ws.bestQ = ws.q;
+      ws.bestErr = err;
     }
     if (errNorm < eps) {
-      success = true;
-      break;
+      return true;
     }
-    if (i >= maxIter) {
-      success = false;
-      break;
+    if (i >= maxIter || (cancel && cancel->load(std::memory_order_relaxed))) {
+      return false;
     }
-    pinocchio::computeJointJacobian(model, data, q, jointIdx, J);
-    J = J * mask.asDiagonal();
+    pinocchio::computeJointJacobian(model, d, ws.q, jointIdx, ws.J);
+    ws.J.array().rowwise() *= mask.transpose().array();
 
     pinocchio::Data::Matrix6 JJt;
-    JJt.noalias() = J * J.transpose();
+    JJt.noalias() = ws.J * ws.J.transpose();
     JJt.diagonal().array() += damp;
-    v.noalias() = -J.transpose() * JJt.ldlt().solve(err);
-    q = pinocchio::integrate(model, q, v * dt);
+    Vector6d step = JJt.ldlt().solve(err);
+    ws.v.noalias() = -dt * ws.J.transpose() * step;
+    pinocchio::integrate(model, ws.q, ws.v, ws.qNext);
+    ws.q.swap(ws.qNext);
+    if (clampLimits) {
+      for (int q : mLimitedQ) {
+        ws.q[q] = std::clamp(ws.q[q], model.lowerPositionLimit[q], model.upperPositionLimit[q]);
+      }
+    }
+  }
+}
+
+std::tuple<Eigen::VectorXd, bool, Eigen::Matrix<double, 6, 1>>
+PinocchioModel::computeInverseKinematics(uint32_t linkIdx, physx::PxTransform const &pose,
+                                         Eigen::VectorXd const &initialQpos,
+                                         Eigen::VectorXi const &activeQMask, double eps,
+                                         int maxIter, double dt, double damp) {
+  std::lock_guard lock(mMutex);
+  ASSERT(linkIdx < linkIdx2FrameIdx.size(), "link index out of bound");
+  IKWorkspace ws;
+  if (initialQpos.size() == 0) {
+    ws.q = pinocchio::neutral(model);
+  } else {
+    ws.q = posS2P(initialQpos);
+  }
+  auto jointIdx = model.frames[linkIdx2FrameIdx[linkIdx]].parent;
+  bool success = runCLIK(data, ws, jointIdx, getJointTarget(linkIdx, pose),
+                         getActiveMask(activeQMask), eps, maxIter, dt, damp, false);
+  return {posP2S(ws.bestQ), success, ws.bestErr};
+}
+
+std::tuple<PinocchioModel::RowMatrixXd, Eigen::Matrix<bool, Eigen::Dynamic, 1>,
+           PinocchioModel::RowMatrixXd>
+PinocchioModel::computeInverseKinematicsMultiSeed(uint32_t linkIdx,
+                                                  std::vector<physx::PxTransform> const &poses,
+                                                  uint32_t seedCount,
+                                                  Eigen::VectorXd const &initialQpos,
+                                                  Eigen::VectorXi const &activeQMask, double eps,
+                                                  int maxIter, double dt, double damp) {
+  ASSERT(linkIdx < linkIdx2FrameIdx.size(), "link index out of bound");
+  ASSERT(seedCount > 0, "at least one seed is required");
+  uint32_t targetCount = poses.size();
+  auto jointIdx = model.frames[linkIdx2FrameIdx[linkIdx]].parent;
+  auto mask = getActiveMask(activeQMask);
+
+  // seeds are shared by all targets, random configurations are drawn on this thread since
+  // pinocchio uses the global random generator; unlimited joints are sampled in [-pi, pi]
+  Eigen::VectorXd lower = model.lowerPositionLimit.cwiseMax(-EIGEN_PI);
+  Eigen::VectorXd upper = model.upperPositionLimit.cwiseMin(EIGEN_PI);
+  std::vector<Eigen::VectorXd> seeds;
+  seeds.push_back(initialQpos.size() ? posS2P(initialQpos) : pinocchio::neutral(model));
+  {
+    std::lock_guard lock(mMutex);
+    while (seeds.size() < seedCount) {
+      seeds.push_back(pinocchio::randomConfiguration(model, lower, upper));
+    }
+  }
+  std::vector<pinocchio::SE3> targets;
+  for (auto &pose : poses) {
+    targets.push_back(getJointTarget(linkIdx, pose));
+  }
+
+  // seed-major rows, so the first seeds of all targets run first
+  uint32_t rows = targetCount * seedCount;
+  std::vector<std::atomic<bool>> solved(targetCount);
+  RowMatrixXd rowQ(rows, model.nq);
+  RowMatrixXd rowErr(rows, 6);
+  std::vector<uint8_t> rowSuccess(rows, 0);
+  parallelRows(rows, [&](BatchContext &context, uint32_t row) {
+    uint32_t target = row % targetCount;
+    uint32_t seed = row / targetCount;
+    auto &ws = context.ik;
+    if (solved[target].load(std::memory_order_relaxed)) {
+      rowErr.row(row).setConstant(std::numeric_limits<double>::infinity());
+      return;
+    }
+    ws.q = seeds[seed];
+    bool success = runCLIK(context.data, ws, jointIdx, targets[target], mask, eps, maxIter, dt,
+                           damp, true, &solved[target]);
+    if (success) {
+      solved[target].store(true, std::memory_order_relaxed);
+    }
+    rowSuccess[row] = success;
+    rowQ.row(row) = ws.bestQ.transpose();
+    rowErr.row(row) = ws.bestErr.transpose();
+  });
+
+  RowMatrixXd qpos(targetCount, model.nv);
+  Eigen::Matrix<bool, Eigen::Dynamic, 1> success(targetCount);
+  RowMatrixXd error(targetCount, 6);
+  for (uint32_t target = 0; target < targetCount; ++target) {
+    // a converged seed if any, otherwise the seed with the smallest error
+    uint32_t best = target;
+    for (uint32_t row = target; row < rows; row += targetCount) {
+      if (rowSuccess[row]) {
+        best = row;
+        break;
+      }
+      if (rowErr.row(row).norm() < rowErr.row(best).norm()) {
+        best = row;
+      }
+    }
+    qpos.row(target) = posP2S(rowQ.row(best).transpose()).transpose();
+    success[target] = rowSuccess[best];
+    error.row(target) = rowErr.row(best);
   }
-  return {posP2S(bestQ), success, bestErr};
+  return {qpos, success, error};
 }
 
 } // namespace sapien
@@ -44,80 +44,120 @@ EArticulationType SArticulation::getType() const { return EArticulationType::DYN
 
 uint32_t SArticulation::dof() const { return mPxArticulation->getDofs(); }
 
-std::vector<physx::PxReal> SArticulation::getQpos() const {
+static PxArticulationCacheFlags getCacheFlags(uint32_t fields) {
+  PxArticulationCacheFlags flags;
+  if (fields & ArticulationStateField::QPOS) {
+    flags |= PxArticulationCache::ePOSITION;
+  }
+  if (fields & ArticulationStateField::QVEL) {
+    flags |= PxArticulationCache::eVELOCITY;
+  }
+  if (fields & ArticulationStateField::QACC) {
+    flags |= PxArticulationCache::eACCELERATION;
+  }
+  if (fields & ArticulationStateField::QF) {
+    flags |= PxArticulationCache::eFORCE;
+  }
+  return flags;
+}
+
+void SArticulation::getState(uint32_t fields, PxReal *out, uint32_t stride) const {
   EASY_FUNCTION();
-  EASY_BLOCK("copy internal state")
-  mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::ePOSITION);
-  EASY_END_BLOCK;
+  mPxArticulation->copyInternalStateToCache(*mCache, getCacheFlags(fields));
+
+  // same as applying mPermutationE2I.inverse(), without the temporaries
+  PxReal const *sources[] = {mCache->jointPosition, mCache->jointVelocity,
+                             mCache->jointAcceleration, mCache->jointForce};
+  auto const &indices = mPermutationE2I.indices();
   auto n = dof();
-  std::vector<physx::PxReal> result(n);
-  Eigen::Map<Eigen::VectorXf>(result.data(), n) =
-      mPermutationE2I.inverse() * Eigen::Map<Eigen::VectorXf>(mCache->jointPosition, n);
+  stride = stride ? stride : n;
+  for (uint32_t f = 0; f < 4; ++f) {
+    if (!(fields & (1u << f))) {
+      continue;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+      out[i] = sources[f][indices[i]];
+    }
+    out += stride;
+  }
+}
+
+void SArticulation::setState(uint32_t fields, PxReal const *data, uint32_t stride) {
+  PxReal *targets[] = {mCache->jointPosition, mCache->jointVelocity, mCache->jointAcceleration,
+                       mCache->jointForce};
+  auto const &indices = mPermutationE2I.indices();
+  auto n = dof();
+  stride = stride ? stride : n;
+  for (uint32_t f = 0; f < 4; ++f) {
+    if (!(fields & (1u << f))) {
+      continue;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+      targets[f][indices[i]] = data[i];
+    }
+    data += stride;
+  }
+  mPxArticulation->applyCache(*mCache, getCacheFlags(fields));
+  if (fields & (ArticulationStateField::QPOS | ArticulationStateField::QVEL)) {
+    ++mStateVersion;
+  }
+  if (fields & ArticulationStateField::QPOS) {
+    mParentScene->markRenderDirty(this);
+  }
+}
+
+void SArticulation::getQpos(PxReal *out) const { getState(ArticulationStateField::QPOS, out); }
+void SArticulation::getQvel(PxReal *out) const { getState(ArticulationStateField::QVEL, out); }
+void SArticulation::getQacc(PxReal *out) const { getState(ArticulationStateField::QACC, out); }
+void SArticulation::getQf(PxReal *out) const { getState(ArticulationStateField::QF, out); }
+
+void SArticulation::setQpos(PxReal const *v) { setState(ArticulationStateField::QPOS, v); }
+void SArticulation::setQvel(PxReal const *v) { setState(ArticulationStateField::QVEL, v); }
+void SArticulation::setQacc(PxReal const *v) { setState(ArticulationStateField::QACC, v); }
+void SArticulation::setQf(PxReal const *v) { setState(ArticulationStateField::QF, v); }
+
+std::vector<physx::PxReal> SArticulation::getQpos() const {
+  std::vector<physx::PxReal> result(dof());
+  getQpos(result.data());
   return result;
 }
 
 void SArticulation::setQpos(std::vector<physx::PxReal> const &v) {
   CHECK_SIZE(v);
-
-  auto n = dof();
-  Eigen::Map<Eigen::VectorXf>(mCache->jointPosition, n) =
-      mPermutationE2I * Eigen::Map<Eigen::VectorXf const>(v.data(), n);
-  mPxArticulation->applyCache(*mCache, PxArticulationCache::ePOSITION);
+  setQpos(v.data());
 }
 
 std::vector<physx::PxReal> SArticulation::getQvel() const {
-  mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::eVELOCITY);
-
-  auto n = dof();
-  std::vector<physx::PxReal> result(n);
-  Eigen::Map<Eigen::VectorXf>(result.data(), n) =
-      mPermutationE2I.inverse() * Eigen::Map<Eigen::VectorXf>(mCache->jointVelocity, n);
+  std::vector<physx::PxReal> result(dof());
+  getQvel(result.data());
   return result;
 }
 
 void SArticulation::setQvel(std::vector<physx::PxReal> const &v) {
   CHECK_SIZE(v);
-
-  auto n = dof();
-  Eigen::Map<Eigen::VectorXf>(mCache->jointVelocity, n) =
-      mPermutationE2I * Eigen::Map<Eigen::VectorXf const>(v.data(), n);
-  mPxArticulation->applyCache(*mCache, PxArticulationCache::eVELOCITY);
+  setQvel(v.data());
 }
 
 std::vector<physx::PxReal> SArticulation::getQacc() const {
-  mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::eACCELERATION);
-  auto n = dof();
-  std::vector<physx::PxReal> result(n);
-  Eigen::Map<Eigen::VectorXf>(result.data(), n) =
-      mPermutationE2I.inverse() * Eigen::Map<Eigen::VectorXf>(mCache->jointAcceleration, n);
+  std::vector<physx::PxReal> result(dof());
+  getQacc(result.data());
   return result;
 }
 
 void SArticulation::setQacc(std::vector<physx::PxReal> const &v) {
   CHECK_SIZE(v);
-
-  auto n = dof();
-  Eigen::Map<Eigen::VectorXf>(mCache->jointAcceleration, n) =
-      mPermutationE2I * Eigen::Map<Eigen::VectorXf const>(v.data(), n);
-  mPxArticulation->applyCache(*mCache, PxArticulationCache::eACCELERATION);
+  setQacc(v.data());
 }
 
 std::vector<physx::PxReal> SArticulation::getQf() const {
-  mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::eFORCE);
-  auto n = dof();
-  std::vector<physx::PxReal> result(n);
-  Eigen::Map<Eigen::VectorXf>(result.data(), n) =
-      mPermutationE2I.inverse() * Eigen::Map<Eigen::VectorXf>(mCache->jointForce, n);
+  std::vector<physx::PxReal> result(dof());
+  getQf(result.data());
   return result;
 }
 
 void SArticulation::setQf(std::vector<physx::PxReal> const &v) {
   CHECK_SIZE(v);
-
-  auto n = dof();
-  Eigen::Map<Eigen::VectorXf>(mCache->jointForce, n) =
-      mPermutationE2I * Eigen::Map<Eigen::VectorXf const>(v.data(), n);
-  mPxArticulation->applyCache(*mCache, PxArticulationCache::eFORCE);
+  setQf(v.data());
 }
 
 std::vector<std::array<physx::PxReal, 2>> SArticulation::getQlimits() const {
@@ -144,14 +184,18 @@ void SArticulation::setQlimits(std::vector<std::array<physx::PxReal, 2>> const &
 
 void SArticulation::setRootPose(physx::PxTransform const &T) {
   mPxArticulation->teleportRootLink(T, true);
+  ++mStateVersion;
+  mParentScene->markRenderDirty(this);
 }
 
 void SArticulation::setRootVelocity(physx::PxVec3 const &v) {
   mRootLink->getPxActor()->setLinearVelocity(v);
+  ++mStateVersion;
 }
 
 void SArticulation::setRootAngularVelocity(physx::PxVec3 const &omega) {
   mRootLink->getPxActor()->setAngularVelocity(omega);
+  ++mStateVersion;
 }
 
 SLinkBase *SArticulation::getRootLink() const { return mRootLink; }
@@ -160,9 +204,41 @@ SArticulation::SArticulation(SScene *scene) : SArticulationDrivable(scene) {}
 
 void SArticulation::setDriveTarget(std::vector<physx::PxReal> const &v) {
   CHECK_SIZE(v);
-  auto n = dof();
+  setDriveTarget(v.data());
+}
+
+void SArticulation::setDriveTarget(PxReal const *v) {
+  SDriveCommand command;
+  command.target = v;
+  applyDriveCommand(command);
+}
+
+void SArticulation::setDriveVelocityTarget(PxReal const *v) {
+  SDriveCommand command;
+  command.velocityTarget = v;
+  applyDriveCommand(command);
+}
+
+void SArticulation::applyDriveCommand(SDriveCommand const &command) {
+  bool setProperty = command.stiffness || command.damping || command.forceLimit;
+  auto n = static_cast<uint32_t>(mActiveJoints.size());
   for (uint32_t i = 0; i < n; ++i) {
-    mActiveJoints[i]->setDriveTarget(mDriveAxes[i], v[i]);
+    auto joint = mActiveJoints[i];
+    auto axis = mDriveAxes[i];
+    if (command.target) {
+      joint->setDriveTarget(axis, command.target[i]);
+    }
+    if (command.velocityTarget) {
+      joint->setDriveVelocity(axis, command.velocityTarget[i] * mDriveMultiplier[i]);
+    }
+    if (setProperty) {
+      PxReal stiffness, damping, forceLimit;
+      PxArticulationDriveType::Enum type;
+      joint->getDrive(axis, stiffness, damping, forceLimit, type);
+      joint->setDrive(axis, command.stiffness ? command.stiffness[i] : stiffness,
+                      command.damping ? command.damping[i] : damping,
+                      command.forceLimit ? command.forceLimit[i] : forceLimit, type);
+    }
   }
   mPxArticulation->wakeUp();
 }
@@ -184,20 +260,7 @@ std::vector<PxReal> SArticulation::getDriveTarget() const {
 
 void SArticulation::setDriveVelocityTarget(std::vector<physx::PxReal> const &v) {
   CHECK_SIZE(v);
-
-  auto n = dof();
-  for (uint32_t i = 0; i < n; ++i) {
-    mActiveJoints[i]->setDriveVelocity(mDriveAxes[i], v[i] * mDriveMultiplier[i]);
-  }
-
-  // uint32_t i = 0;
-  // for (auto &j : mJoints) {
-  //   if (j->getAxes().size() == 1) {
-  //     j->setDriveVelocityTarget(v[i]);
-  //     i += 1;
-  //   }
-  // }
-  mPxArticulation->wakeUp();
+  setDriveVelocityTarget(v.data());
 }
 
 std::vector<PxReal> SArticulation::getDriveVelocityTarget() const {
@@ -250,34 +313,82 @@ bool SArticulation::isBaseFixed() const {
 void SArticulation::resetCache() {
   mPxArticulation->releaseCache(*mCache);
   mCache = mPxArticulation->createCache();
+  markKinematicsDirty();
+}
+bool SArticulation::isKinematicsCached(uint32_t entry) {
+  uint64_t step = mParentScene->getStepCount();
+  if (step != mKinematicsStep || mStateVersion != mKinematicsVersion) {
+    mKinematicsStep = step;
+    mKinematicsVersion = mStateVersion;
+    mKinematicsValid = 0;
+  }
+  return mKinematicsValid & entry;
 }
-std::vector<physx::PxReal>
-SArticulation::computePassiveForce(bool gravity, bool coriolisAndCentrifugal, bool external) {
-  mPxArticulation->commonInit();
-  auto n = dof();
 
-  std::vector<physx::PxReal> passiveForce(n, 0);
-  Eigen::Map<Eigen::VectorXf> passiveForceVector(passiveForce.data(), n);
+void SArticulation::commonInit() {
+  if (!isKinematicsCached(COMMON_INIT)) {
+    mPxArticulation->commonInit();
+    mKinematicsValid |= COMMON_INIT;
+  }
+}
 
-  if (coriolisAndCentrifugal) {
+Matrix<PxReal, Dynamic, 1> const &SArticulation::getGravityForce() {
+  if (!isKinematicsCached(GRAVITY_FORCE)) {
+    commonInit();
+    mPxArticulation->computeGeneralizedGravityForce(*mCache);
+    auto const &indices = mPermutationE2I.indices();
+    auto n = dof();
+    mGravityForce.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+      mGravityForce[i] = mCache->jointForce[indices[i]];
+    }
+    mKinematicsValid |= GRAVITY_FORCE;
+  }
+  return mGravityForce;
+}
+
+Matrix<PxReal, Dynamic, 1> const &SArticulation::getCoriolisAndCentrifugalForce() {
+  if (!isKinematicsCached(CORIOLIS_FORCE)) {
+    commonInit();
     mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::eVELOCITY);
     mPxArticulation->computeCoriolisAndCentrifugalForce(*mCache);
-    passiveForceVector += Eigen::Map<Eigen::VectorXf>(mCache->jointForce, n);
+    auto const &indices = mPermutationE2I.indices();
+    auto n = dof();
+    mCoriolisForce.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+      mCoriolisForce[i] = mCache->jointForce[indices[i]];
+    }
+    mKinematicsValid |= CORIOLIS_FORCE;
   }
+  return mCoriolisForce;
+}
+
+SKinematicsBundle const &SArticulation::getKinematicsBundle() {
+  getWorldCartesianJacobian();
+  getManipulatorInertiaMatrix();
+  if (!isKinematicsCached(PASSIVE_FORCE)) {
+    mKinematics.passiveForce = getGravityForce() + getCoriolisAndCentrifugalForce();
+    mKinematicsValid |= PASSIVE_FORCE;
+  }
+  return mKinematics;
+}
 
+std::vector<physx::PxReal>
+SArticulation::computePassiveForce(bool gravity, bool coriolisAndCentrifugal, bool external) {
+  auto n = dof();
+  std::vector<physx::PxReal> result(n, 0);
+  Eigen::Map<Eigen::VectorXf> passiveForce(result.data(), n);
+  if (coriolisAndCentrifugal) {
+    passiveForce += getCoriolisAndCentrifugalForce();
+  }
   if (gravity) {
-    mPxArticulation->computeGeneralizedGravityForce(*mCache);
-    passiveForceVector += Eigen::Map<Eigen::VectorXf>(mCache->jointForce, n);
+    passiveForce += getGravityForce();
   }
 
   if (external) {
     spdlog::get("SAPIEN")->warn(
         "external force is deprecated and ignored in passive force computation.");
   }
-
-  std::vector<physx::PxReal> result(n);
-  Eigen::Map<Eigen::VectorXf>(result.data(), n) =
-      mPermutationE2I.inverse() * Eigen::Map<Eigen::VectorXf>(passiveForce.data(), n);
   return result;
 }
 
@@ -340,173 +451,168 @@ std::vector<physx::PxReal> SArticulation::computeInverseDynamics(const std::vect
   return result;
 }
 
-Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
-SArticulation::computeManipulatorInertiaMatrix() {
-  using namespace Eigen;
-  mPxArticulation->commonInit();
-  mPxArticulation->computeGeneralizedMassMatrix(*mCache);
-
-  int mDof = dof();
-
-  Matrix<PxReal, Dynamic, Dynamic, Eigen::RowMajor> originMass =
-      Map<Matrix<PxReal, Dynamic, Dynamic, Eigen::RowMajor>>(mCache->massMatrix, mDof, mDof);
-
-  return mPermutationE2I.inverse() * originMass * mPermutationE2I;
+Matrix<PxReal, Dynamic, Dynamic, RowMajor> const &SArticulation::getManipulatorInertiaMatrix() {
+  if (!isKinematicsCached(MASS_MATRIX)) {
+    commonInit();
+    mPxArticulation->computeGeneralizedMassMatrix(*mCache);
+
+    // same as P^-1 * M * P, without the temporaries
+    auto const &indices = mPermutationE2I.indices();
+    auto n = dof();
+    Map<Matrix<PxReal, Dynamic, Dynamic, RowMajor> const> origin(mCache->massMatrix, n, n);
+    auto &mass = mKinematics.massMatrix;
+    mass.resize(n, n);
+    for (uint32_t r = 0; r < n; ++r) {
+      for (uint32_t c = 0; c < n; ++c) {
+        mass(r, c) = origin(indices[r], indices[c]);
+      }
+    }
+    mKinematicsValid |= MASS_MATRIX;
+  }
+  return mKinematics.massMatrix;
 }
 
-void SArticulation::prestep() {
-  auto time = mParentScene->getTimestep();
-  EventArticulationStep s;
-  s.articulation = this;
-  s.time = time;
-  EventEmitter<EventArticulationStep>::emit(s);
-
-  for (auto &l : mLinks) {
-    EventActorStep s;
-    s.actor = l.get();
-    s.time = time;
-    l->EventEmitter<EventActorStep>::emit(s);
+Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+SArticulation::computeManipulatorInertiaMatrix() {
+  return getManipulatorInertiaMatrix();
+}
+
+void SArticulation::prestep() {}
+
+Matrix<PxReal, Dynamic, Dynamic, RowMajor> const &SArticulation::getWorldCartesianJacobian() {
+  // NOTE: PhysX computeDenseJacobian computes Jacobian for the 6D root link motion, which we
+  // discard.
+  if (!isKinematicsCached(CARTESIAN_JACOBIAN)) {
+    PxU32 nRows;
+    PxU32 nCols;
+    mPxArticulation->computeDenseJacobian(*mCache, nRows, nCols);
+    uint32_t freeBase = (nCols == dof()) ? 0 : 6;
+    Map<Matrix<PxReal, Dynamic, Dynamic, RowMajor> const> origin(mCache->denseJacobian, nRows,
+                                                                  nCols);
+
+    // switch link (row) and joint (column) order from internal to external,
+    // same as L^-1 * J * P without the temporaries
+    auto const &rowIndices = mLinkPermutationE2I.indices();
+    auto const &colIndices = mPermutationE2I.indices();
+    uint32_t rows = nRows - freeBase;
+    uint32_t cols = nCols - freeBase;
+    auto &jacobian = mKinematics.cartesianJacobian;
+    jacobian.resize(rows, cols);
+    for (uint32_t r = 0; r < rows; ++r) {
+      for (uint32_t c = 0; c < cols; ++c) {
+        jacobian(r, c) = origin(freeBase + rowIndices[r], freeBase + colIndices[c]);
+      }
+    }
+    mKinematicsValid |= CARTESIAN_JACOBIAN;
+  }
+  return mKinematics.cartesianJacobian;
+}
+
+Matrix<PxReal, Dynamic, Dynamic, RowMajor> const &SArticulation::getSpatialTwistJacobian() {
+  // NOTE: PhysX computes the Jacobian for Cartesian velocity, the twist Jacobian adds
+  // p x omega to the linear rows of every link
+  if (!isKinematicsCached(TWIST_JACOBIAN)) {
+    auto const &jacobian = getWorldCartesianJacobian();
+    mTwistJacobian = jacobian;
+
+    std::vector<PxArticulationLink *> internalLinks(mPxArticulation->getNbLinks());
+    mPxArticulation->getLinks(internalLinks.data(), mPxArticulation->getNbLinks());
+    auto const &rowIndices = mLinkPermutationE2I.indices();
+    for (uint32_t row = 0; row < jacobian.rows(); row += 6) {
+      // internal rows 6 * (i - 1) belong to internal link i
+      auto p = internalLinks[rowIndices[row] / 6 + 1]->getGlobalPose().p;
+      mTwistJacobian.block(row, 0, 3, jacobian.cols()).noalias() +=
+          skewSymmetric({p[0], p[1], p[2]}) * jacobian.block(row + 3, 0, 3, jacobian.cols());
+    }
+    mKinematicsValid |= TWIST_JACOBIAN;
   }
+  return mTwistJacobian;
 }
 
 Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
 SArticulation::computeSpatialTwistJacobianMatrix() {
-  // NOTE: 1. PhysX computeDenseJacobian computes Jacobian for the 6D root link
-  // motion, which we discard. 2. PhysX computes the Jacobian for Cartesian
-  // velocity, for twist Jacobian, see computeSpatialTwistJacobianMatrix.
-  using namespace Eigen;
-  PxU32 nRows;
-  PxU32 nCols;
-  mPxArticulation->computeDenseJacobian(*mCache, nRows, nCols);
-  uint32_t freeBase = (nCols == dof()) ? 0 : 6;
-  Matrix<PxReal, Dynamic, Dynamic, Eigen::RowMajor> originJacobian =
-      Map<Matrix<PxReal, Dynamic, Dynamic, Eigen::RowMajor>>(mCache->denseJacobian, nRows, nCols);
-  Matrix<PxReal, Dynamic, Dynamic, Eigen::RowMajor> eliminatedJacobian(
-      originJacobian.block(freeBase, freeBase, nRows - freeBase, nCols - freeBase));
-
-  std::vector<PxArticulationLink *> internalLinks(mPxArticulation->getNbLinks());
-  mPxArticulation->getLinks(internalLinks.data(), mPxArticulation->getNbLinks());
-
-  Matrix<PxReal, Dynamic, Dynamic, Eigen::RowMajor> vel2twist =
-      Matrix<PxReal, Dynamic, Dynamic, Eigen::RowMajor>::Identity(nRows - freeBase,
-                                                                  nRows - freeBase);
-  for (size_t i = 1; i < internalLinks.size(); ++i) {
-    auto p = internalLinks[i]->getGlobalPose().p;
-    vel2twist.block<3, 3>(6 * i - 6, 6 * i - 3) = skewSymmetric({p[0], p[1], p[2]});
-  }
-
-  eliminatedJacobian = vel2twist * eliminatedJacobian;
-
-  // Switch joint(column) order from internal to external
-  eliminatedJacobian = eliminatedJacobian * mPermutationE2I;
-
-  // Switch link(row) order from internal to external
-  return mLinkPermutationE2I.inverse() * eliminatedJacobian;
+  return getSpatialTwistJacobian();
 }
 
 Eigen::Matrix<PxReal, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
 SArticulation::computeWorldCartesianJacobianMatrix() {
-  // NOTE: this function computes the Jacobian for twist motion, commonly used
-  // in robotics.
-  using namespace Eigen;
-  PxU32 nRows;
-  PxU32 nCols;
-  mPxArticulation->computeDenseJacobian(*mCache, nRows, nCols);
-  uint32_t freeBase = (nCols == dof()) ? 0 : 6;
-  Matrix<PxReal, Dynamic, Dynamic, Eigen::RowMajor> originJacobian =
-      Map<Matrix<PxReal, Dynamic, Dynamic, Eigen::RowMajor>>(mCache->denseJacobian, nRows, nCols);
-  Matrix<PxReal, Dynamic, Dynamic, Eigen::RowMajor> eliminatedJacobian(
-      originJacobian.block(freeBase, freeBase, nRows - freeBase, nCols - freeBase));
-
-  // Switch joint(column) order from internal to external
-  eliminatedJacobian = eliminatedJacobian * mPermutationE2I;
-
-  // Switch link(row) order from internal to external
-  return mLinkPermutationE2I.inverse() * eliminatedJacobian;
-}
-
-#define PUSH_QUAT(data, q)                                                                        \
+  return getWorldCartesianJacobian();
+}
+
+uint32_t SArticulation::getPackedSize() const {
+  return mPxArticulation->getDofs() * 4          // joint size
+         + mPxArticulation->getNbLinks() * 12 // link size
+         + 19;                                // root size
+}
+
+#define WRITE_VEC3(data, p, v)                                                                    \
   {                                                                                               \
-    (data).push_back((q).x);                                                                      \
-    (data).push_back((q).y);                                                                      \
-    (data).push_back((q).z);                                                                      \
-    (data).push_back((q).w);                                                                      \
+    (data)[(p)++] = (v).x;                                                                        \
+    (data)[(p)++] = (v).y;                                                                        \
+    (data)[(p)++] = (v).z;                                                                        \
   }
 
-#define PUSH_VEC3(data, v)                                                                        \
+#define WRITE_QUAT(data, p, q)                                                                    \
   {                                                                                               \
-    (data).push_back((v).x);                                                                      \
-    (data).push_back((v).y);                                                                      \
-    (data).push_back((v).z);                                                                      \
+    (data)[(p)++] = (q).x;                                                                        \
+    (data)[(p)++] = (q).y;                                                                        \
+    (data)[(p)++] = (q).z;                                                                        \
+    (data)[(p)++] = (q).w;                                                                        \
   }
 
-std::vector<PxReal> SArticulation::packData() {
-  std::vector<PxReal> data;
-
+void SArticulation::packData(PxReal *data) {
   mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::eALL);
   auto ndof = mPxArticulation->getDofs();
   auto nlinks = mPxArticulation->getNbLinks();
+  uint32_t p = 0;
 
-  data.insert(data.end(), mCache->jointPosition, mCache->jointPosition + ndof);
-  data.insert(data.end(), mCache->jointVelocity, mCache->jointVelocity + ndof);
-  data.insert(data.end(), mCache->jointAcceleration, mCache->jointAcceleration + ndof);
-  data.insert(data.end(), mCache->jointForce, mCache->jointForce + ndof);
+  std::copy(mCache->jointPosition, mCache->jointPosition + ndof, data + p);
+  p += ndof;
+  std::copy(mCache->jointVelocity, mCache->jointVelocity + ndof, data + p);
+  p += ndof;
+  std::copy(mCache->jointAcceleration, mCache->jointAcceleration + ndof, data + p);
+  p += ndof;
+  std::copy(mCache->jointForce, mCache->jointForce + ndof, data + p);
+  p += ndof;
 
   for (uint32_t i = 0; i < nlinks; ++i) {
-    auto lv = mCache->linkVelocity[i].linear;
-    auto av = mCache->linkVelocity[i].angular;
-    PUSH_VEC3(data, lv);
-    PUSH_VEC3(data, av);
+    WRITE_VEC3(data, p, mCache->linkVelocity[i].linear);
+    WRITE_VEC3(data, p, mCache->linkVelocity[i].angular);
   }
-
   for (uint32_t i = 0; i < nlinks; ++i) {
-    auto la = mCache->linkAcceleration[i].linear;
-    auto aa = mCache->linkAcceleration[i].angular;
-    PUSH_VEC3(data, la);
-    PUSH_VEC3(data, aa);
+    WRITE_VEC3(data, p, mCache->linkAcceleration[i].linear);
+    WRITE_VEC3(data, p, mCache->linkAcceleration[i].angular);
   }
 
   auto [transform, lv, av, la, aa] = *mCache->rootLinkData;
-  PUSH_VEC3(data, transform.p);
-  PUSH_QUAT(data, transform.q);
-  PUSH_VEC3(data, lv);
-  PUSH_VEC3(data, av);
-  PUSH_VEC3(data, la);
-  PUSH_VEC3(data, aa);
-
-  return data;
+  WRITE_VEC3(data, p, transform.p);
+  WRITE_QUAT(data, p, transform.q);
+  WRITE_VEC3(data, p, lv);
+  WRITE_VEC3(data, p, av);
+  WRITE_VEC3(data, p, la);
+  WRITE_VEC3(data, p, aa);
 }
 
-void SArticulation::unpackData(std::vector<PxReal> const &data) {
-  mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::eALL);
+#undef WRITE_VEC3
+#undef WRITE_QUAT
+
+void SArticulation::unpackData(PxReal const *data) {
   auto ndof = mPxArticulation->getDofs();
   auto nlinks = mPxArticulation->getNbLinks();
 
-  if (data.size() != ndof * 4          // joint size
-                         + nlinks * 12 // link size
-                         + 19          // root size
-  ) {
-    throw std::runtime_error(
-        "Failed to unpack articulation data: " + std::to_string(ndof * 4 + nlinks * 12 + 19) +
-        " numbers expected but " + std::to_string(data.size()) + " provided");
-  }
-
+  // every cache entry applied below is overwritten, no need to copy the internal state first
   mPxArticulation->zeroCache(*mCache);
   uint32_t p = 0;
 
   // restore joints
-  for (uint32_t j = 0; j < ndof; ++j) {
-    mCache->jointPosition[j] = data[p++];
-  }
-  for (uint32_t j = 0; j < ndof; ++j) {
-    mCache->jointVelocity[j] = data[p++];
-  }
-  for (uint32_t j = 0; j < ndof; ++j) {
-    mCache->jointAcceleration[j] = data[p++];
-  }
-  for (uint32_t j = 0; j < ndof; ++j) {
-    mCache->jointForce[j] = data[p++];
-  }
+  std::copy(data + p, data + p + ndof, mCache->jointPosition);
+  p += ndof;
+  std::copy(data + p, data + p + ndof, mCache->jointVelocity);
+  p += ndof;
+  std::copy(data + p, data + p + ndof, mCache->jointAcceleration);
+  p += ndof;
+  std::copy(data + p, data + p + ndof, mCache->jointForce);
+  p += ndof;
 
   // restore links
   for (uint32_t i = 0; i < nlinks; ++i) {
@@ -536,63 +642,84 @@ void SArticulation::unpackData(std::vector<PxReal> const &data) {
   p += 3;
 
   mPxArticulation->applyCache(*mCache, PxArticulationCache::eALL);
+  ++mStateVersion;
+  mParentScene->markRenderDirty(this);
 }
 
-std::vector<PxReal> SArticulation::packDrive() {
-  std::vector<PxReal> data;
-  std::vector<PxReal> driveTarget;
-  std::vector<PxReal> driveVel;
-  std::vector<PxReal> driveP;
-  std::vector<PxReal> driveD;
-  std::vector<PxReal> driveMaxForce;
+std::vector<PxReal> SArticulation::packData() {
+  std::vector<PxReal> data(getPackedSize());
+  packData(data.data());
+  return data;
+}
+
+void SArticulation::unpackData(std::vector<PxReal> const &data) {
+  if (data.size() != getPackedSize()) {
+    throw std::runtime_error("Failed to unpack articulation data: " +
+                             std::to_string(getPackedSize()) + " numbers expected but " +
+                             std::to_string(data.size()) + " provided");
+  }
+  unpackData(data.data());
+}
+
+void SArticulation::packDrive(PxReal *data) {
+  auto n = dof();
   uint32_t i = 0;
   for (auto &j : mJoints) {
     for (auto axis : j->getAxes()) {
-      driveTarget.push_back(j->getPxJoint()->getDriveTarget(axis));
-      driveVel.push_back(j->getPxJoint()->getDriveVelocity(axis));
+      data[i] = j->getPxJoint()->getDriveTarget(axis);
+      data[n + i] = j->getPxJoint()->getDriveVelocity(axis);
       PxReal stiffness, damping, maxForce;
       PxArticulationDriveType::Enum driveType;
       j->getPxJoint()->getDrive(axis, stiffness, damping, maxForce, driveType);
-      driveP.push_back(stiffness);
-      driveD.push_back(damping);
-      driveMaxForce.push_back(maxForce);
+      data[2 * n + i] = stiffness;
+      data[3 * n + i] = damping;
+      data[4 * n + i] = maxForce;
       i += 1;
     }
   }
-  data.insert(data.end(), driveTarget.begin(), driveTarget.end());
-  data.insert(data.end(), driveVel.begin(), driveVel.end());
-  data.insert(data.end(), driveP.begin(), driveP.end());
-  data.insert(data.end(), driveD.begin(), driveD.end());
-  data.insert(data.end(), driveMaxForce.begin(), driveMaxForce.end());
-  return data;
 }
 
-void SArticulation::unpackDrive(std::vector<PxReal> const &data) {
-  if (data.size() != dof() * 5) {
-    throw std::runtime_error("Invalid data passed to unpackDrive");
-  }
-  auto it = data.begin();
-  std::vector<PxReal> driveTarget(it, it + dof());
-  it += dof();
-  std::vector<PxReal> driveVel(it, it + dof());
-  it += dof();
-  std::vector<PxReal> driveP(it, it + dof());
-  it += dof();
-  std::vector<PxReal> driveD(it, it + dof());
-  it += dof();
-  std::vector<PxReal> driveMaxForce(it, it + dof());
-
+void SArticulation::unpackDrive(PxReal const *data) {
+  auto n = dof();
   uint32_t i = 0;
   for (auto &j : mJoints) {
     for (auto axis : j->getAxes()) {
-      j->getPxJoint()->setDriveTarget(axis, driveTarget[i]);
-      j->getPxJoint()->setDriveVelocity(axis, driveVel[i]);
-      j->getPxJoint()->setDrive(axis, driveP[i], driveD[i], driveMaxForce[i]);
+      j->getPxJoint()->setDriveTarget(axis, data[i]);
+      j->getPxJoint()->setDriveVelocity(axis, data[n + i]);
+      j->getPxJoint()->setDrive(axis, data[2 * n + i], data[3 * n + i], data[4 * n + i]);
       i += 1;
     }
   }
 }
 
+std::vector<PxReal> SArticulation::packDrive() {
+  std::vector<PxReal> data(getPackedDriveSize());
+  packDrive(data.data());
+  return data;
+}
+
+void SArticulation::unpackDrive(std::vector<PxReal> const &data) {
+  if (data.size() != getPackedDriveSize()) {
+    throw std::runtime_error("Invalid data passed to unpackDrive");
+  }
+  unpackDrive(data.data());
+}
+
+void SArticulation::exportState(PxReal *qpos, PxReal *qvel, PxReal *driveTarget,
+                                PxReal *driveVelocityTarget) {
+  mPxArticulation->copyInternalStateToCache(*mCache, PxArticulationCache::ePOSITION |
+                                                         PxArticulationCache::eVELOCITY);
+  // same as applying mPermutationE2I.inverse(), without the temporaries
+  auto const &indices = mPermutationE2I.indices();
+  auto n = dof();
+  for (uint32_t i = 0; i < n; ++i) {
+    qpos[i] = mCache->jointPosition[indices[i]];
+    qvel[i] = mCache->jointVelocity[indices[i]];
+    driveTarget[i] = mActiveJoints[i]->getDriveTarget(mDriveAxes[i]);
+    driveVelocityTarget[i] = mActiveJoints[i]->getDriveVelocity(mDriveAxes[i]) * mDriveMultiplier[i];
+  }
+}
+
 Matrix<PxReal, Dynamic, 1>
 SArticulation::computeTwistDiffIK(const Eigen::Matrix<PxReal, 6, 1> &spatialTwist,
                                   uint32_t commandedLinkId,
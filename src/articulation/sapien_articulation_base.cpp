@@ -15,6 +15,12 @@ namespace sapien {
 
 physx::PxTransform SArticulationBase::getRootPose() const { return getRootLink()->getPose(); }
 
+SArticulationBase::SArticulationBase(SScene *scene) : SEntity(scene) {
+  EventEmitter<EventArticulationStep>::setSubscriberObserver(this);
+}
+
+void SArticulationBase::onSubscribersChanged() { mParentScene->markStepSubscribersDirty(); }
+
 void SArticulationBase::markDestroyed() {
   if (mDestroyedState == 0) {
     mDestroyedState = 1;
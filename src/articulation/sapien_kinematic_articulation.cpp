@@ -56,6 +56,7 @@ void SKArticulation::setQpos(const std::vector<physx::PxReal> &v) {
     j->setPos({it, it + dof});
     it += dof;
   }
+  mParentScene->markRenderDirty(this);
 }
 
 std::vector<physx::PxReal> SKArticulation::getQvel() const {
@@ -89,6 +90,7 @@ void SKArticulation::setQf(const std::vector<physx::PxReal> &v) {
 }
 void SKArticulation::setRootPose(const physx::PxTransform &T) {
   mRootLink->getPxActor()->setGlobalPose(T);
+  mParentScene->markRenderDirty(this);
 }
 
 std::vector<std::array<physx::PxReal, 2>> SKArticulation::getQlimits() const {
@@ -125,19 +127,6 @@ std::vector<physx::PxReal> SKArticulation::getDriveTarget() const {
 }
 
 void SKArticulation::prestep() {
-  auto time = mParentScene->getTimestep();
-  EventArticulationStep s;
-  s.articulation = this;
-  s.time = time;
-  EventEmitter<EventArticulationStep>::emit(s);
-
-  for (auto &l : mLinks) {
-    EventActorStep s;
-    s.actor = l.get();
-    s.time = time;
-    l->EventEmitter<EventActorStep>::emit(s);
-  }
-
   std::vector<PxTransform> poses(mJoints.size());
   poses[mSortedIndices[0]] = mJoints[mSortedIndices[0]]->getChildLink()->getPose();
 
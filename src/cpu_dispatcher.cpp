@@ -0,0 +1,119 @@
+#include "sapien/cpu_dispatcher.h"
+
+namespace sapien {
+
+// PhysX submits many small tasks per step, wrappers are recycled through a lock-free free list
+// shared by all threads of the dispatcher, so a steady simulation does not allocate
+class PxTaskJob : public Job {
+public:
+  void execute() override {
+    PxBaseTask *task = mTask;
+    recycle();
+    task->run();
+    task->release();
+  }
+
+  void cancel() override { recycle(); }
+
+  PxBaseTask *mTask{};
+  // null for overflow wrappers that are deleted instead of recycled
+  SapienCpuDispatcher *mDispatcher{};
+  uint32_t mIndex{};
+  std::atomic<uint32_t> mNext{0};
+
+private:
+  void recycle() {
+    mTask = nullptr;
+    if (mDispatcher) {
+      mDispatcher->releaseJob(this);
+    } else {
+      delete this;
+    }
+  }
+};
+
+static constexpr uint64_t kSlotMask = 0xffffffffull;
+static constexpr uint64_t kTagOne = 1ull << 32;
+
+SapienCpuDispatcher::SapienCpuDispatcher(std::shared_ptr<JobSystem> jobSystem)
+    : mJobSystem(jobSystem) {}
+
+SapienCpuDispatcher::~SapienCpuDispatcher() {
+  for (auto &chunk : mJobChunks) {
+    delete[] chunk.load();
+  }
+}
+
+PxTaskJob *SapienCpuDispatcher::getJob(uint32_t index) const {
+  return mJobChunks[index / kJobChunkSize].load(std::memory_order_acquire) +
+         index % kJobChunkSize;
+}
+
+PxTaskJob *SapienCpuDispatcher::acquireJob(PxBaseTask &task) {
+  PxTaskJob *job = nullptr;
+
+  uint64_t head = mFreeJobs.load(std::memory_order_acquire);
+  while (uint32_t slot = head & kSlotMask) {
+    PxTaskJob *first = getJob(slot - 1);
+    // a stale next is harmless, the tag makes the exchange fail if the head was reused
+    uint64_t next = ((head & ~kSlotMask) + kTagOne) | first->mNext.load(std::memory_order_relaxed);
+    if (mFreeJobs.compare_exchange_weak(head, next, std::memory_order_acquire,
+                                        std::memory_order_acquire)) {
+      job = first;
+      break;
+    }
+  }
+
+  if (!job) {
+    uint32_t index = mJobCount.load(std::memory_order_relaxed);
+    while (index < kJobChunkSize * kMaxJobChunks &&
+           !mJobCount.compare_exchange_weak(index, index + 1, std::memory_order_relaxed)) {
+    }
+    if (index >= kJobChunkSize * kMaxJobChunks) {
+      // more tasks in flight than the pool holds
+      job = new PxTaskJob;
+    } else {
+      auto &chunk = mJobChunks[index / kJobChunkSize];
+      if (!chunk.load(std::memory_order_acquire)) {
+        std::lock_guard lock(mChunkMutex);
+        if (!chunk.load(std::memory_order_relaxed)) {
+          PxTaskJob *jobs = new PxTaskJob[kJobChunkSize];
+          uint32_t begin = index / kJobChunkSize * kJobChunkSize;
+          for (uint32_t i = 0; i < kJobChunkSize; ++i) {
+            jobs[i].mDispatcher = this;
+            jobs[i].mIndex = begin + i;
+          }
+          chunk.store(jobs, std::memory_order_release);
+        }
+      }
+      job = getJob(index);
+    }
+  }
+
+  job->mTask = &task;
+  return job;
+}
+
+void SapienCpuDispatcher::releaseJob(PxTaskJob *job) {
+  uint64_t head = mFreeJobs.load(std::memory_order_relaxed);
+  uint64_t next;
+  do {
+    job->mNext.store(head & kSlotMask, std::memory_order_relaxed);
+    next = ((head & ~kSlotMask) + kTagOne) | (job->mIndex + 1);
+  } while (!mFreeJobs.compare_exchange_weak(head, next, std::memory_order_release,
+                                            std::memory_order_relaxed));
+}
+
+void SapienCpuDispatcher::submitTask(PxBaseTask &task) {
+  if (mJobSystem->getThreadCount() == 0) {
+    // same as PxDefaultCpuDispatcher with 0 threads: run on the submitting thread
+    task.run();
+    task.release();
+    return;
+  }
+  mJobSystem->submit(acquireJob(task));
+}
+
+uint32_t SapienCpuDispatcher::getWorkerCount() const { return mJobSystem->getThreadCount(); }
+
+} // namespace sapien
@@ -0,0 +1,351 @@
+#include "sapien/job_system.h"
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace sapien {
+
+static thread_local JobSystem const *gCurrentSystem = nullptr;
+static thread_local uint32_t gCurrentWorkerIndex = 0;
+
+// number of failed job searches before a worker goes to sleep
+static constexpr int kIdleSpinCount = 64;
+
+namespace {
+struct ForLatch {
+  std::mutex mutex;
+  std::condition_variable condition;
+  uint32_t remaining;
+};
+
+class ForJob : public Job {
+public:
+  std::function<void(uint32_t)> const *fn{};
+  uint32_t index{};
+  ForLatch *latch{};
+  std::exception_ptr error{};
+
+  void execute() override {
+    try {
+      (*fn)(index);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    finish();
+  }
+
+  void cancel() override {
+    error = std::make_exception_ptr(std::runtime_error("job cancelled"));
+    finish();
+  }
+
+private:
+  void finish() {
+    // notify while holding the lock, the latch lives on the waiting thread's stack
+    std::lock_guard lock(latch->mutex);
+    if (--latch->remaining == 0) {
+      latch->condition.notify_all();
+    }
+  }
+};
+} // namespace
+
+/************************************************
+ * Work-stealing queue
+ ***********************************************/
+bool WorkStealingQueue::push(Job *job) {
+  int64_t b = mBottom.load(std::memory_order_relaxed);
+  int64_t t = mTop.load(std::memory_order_acquire);
+  if (b - t >= kCapacity) {
+    return false;
+  }
+  mBuffer[b & (kCapacity - 1)].store(job, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  mBottom.store(b + 1, std::memory_order_relaxed);
+  return true;
+}
+
+Job *WorkStealingQueue::pop() {
+  int64_t b = mBottom.load(std::memory_order_relaxed) - 1;
+  mBottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t t = mTop.load(std::memory_order_relaxed);
+
+  if (t > b) {
+    // empty
+    mBottom.store(b + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  Job *job = mBuffer[b & (kCapacity - 1)].load(std::memory_order_relaxed);
+  if (t == b) {
+    // last item, race against thieves
+    if (!mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      job = nullptr;
+    }
+    mBottom.store(b + 1, std::memory_order_relaxed);
+  }
+  return job;
+}
+
+Job *WorkStealingQueue::steal() {
+  int64_t t = mTop.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t b = mBottom.load(std::memory_order_acquire);
+  if (t >= b) {
+    return nullptr;
+  }
+  Job *job = mBuffer[t & (kCapacity - 1)].load(std::memory_order_relaxed);
+  if (!mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                    std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  return job;
+}
+
+bool WorkStealingQueue::empty() const {
+  int64_t b = mBottom.load(std::memory_order_acquire);
+  int64_t t = mTop.load(std::memory_order_acquire);
+  return b <= t;
+}
+
+/************************************************
+ * Job system
+ ***********************************************/
+JobSystem::JobSystem(uint32_t threadCount, uint64_t affinityMask) : mAffinityMask(affinityMask) {
+  mWorkers.reserve(threadCount);
+  for (uint32_t i = 0; i < threadCount; ++i) {
+    auto worker = std::make_unique<Worker>();
+    worker->system = this;
+    worker->index = i;
+    mWorkers.push_back(std::move(worker));
+  }
+  // start threads after all queues exist so workers can steal from each other
+  for (auto &worker : mWorkers) {
+    worker->thread = std::thread(&JobSystem::workerMain, this, worker.get());
+  }
+}
+
+JobSystem::~JobSystem() { shutdown(); }
+
+void JobSystem::shutdown() {
+  if (mShutdown.exchange(true)) {
+    return;
+  }
+  {
+    std::lock_guard lock(mSleepMutex);
+    ++mWakeEpoch;
+  }
+  mSleepCondition.notify_all();
+
+  for (auto &worker : mWorkers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+
+  // all workers have exited, so it is safe to drain their queues from here
+  for (auto &worker : mWorkers) {
+    while (Job *job = worker->queue.pop()) {
+      job->cancel();
+    }
+  }
+  std::lock_guard lock(mInjectionMutex);
+  for (Job *job : mInjectionQueue) {
+    job->cancel();
+  }
+  mInjectionQueue.clear();
+  mInjectionSize.store(0);
+}
+
+bool JobSystem::isWorkerThread() const { return gCurrentSystem == this; }
+
+void JobSystem::submit(Job *job) {
+  if (mShutdown.load(std::memory_order_acquire)) {
+    job->cancel();
+    return;
+  }
+  if (mWorkers.empty()) {
+    job->execute();
+    return;
+  }
+  if (!isWorkerThread() || !mWorkers[gCurrentWorkerIndex]->queue.push(job)) {
+    std::lock_guard lock(mInjectionMutex);
+    mInjectionQueue.push_back(job);
+    mInjectionSize.fetch_add(1, std::memory_order_release);
+  }
+  notifyWorker();
+}
+
+bool JobSystem::runPendingJob() {
+  if (mWorkers.empty()) {
+    return false;
+  }
+  Worker *worker = isWorkerThread() ? mWorkers[gCurrentWorkerIndex].get() : nullptr;
+  if (Job *job = findJob(worker)) {
+    job->execute();
+    return true;
+  }
+  return false;
+}
+
+void JobSystem::parallelFor(uint32_t count, std::function<void(uint32_t)> const &fn) {
+  if (mWorkers.empty() || count == 1) {
+    for (uint32_t i = 0; i < count; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  ForLatch latch;
+  latch.remaining = count;
+  std::vector<ForJob> jobs(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    jobs[i].fn = &fn;
+    jobs[i].index = i;
+    jobs[i].latch = &latch;
+  }
+  for (auto &job : jobs) {
+    submit(&job);
+  }
+
+  // help with the pending jobs, then sleep until the last one finishes
+  while (true) {
+    {
+      std::lock_guard lock(latch.mutex);
+      if (latch.remaining == 0) {
+        break;
+      }
+    }
+    if (!runPendingJob()) {
+      std::unique_lock lock(latch.mutex);
+      latch.condition.wait(lock, [&] { return latch.remaining == 0; });
+    }
+  }
+
+  for (auto &job : jobs) {
+    if (job.error) {
+      std::rethrow_exception(job.error);
+    }
+  }
+}
+
+Job *JobSystem::popInjected() {
+  if (mInjectionSize.load(std::memory_order_acquire) == 0) {
+    return nullptr;
+  }
+  std::lock_guard lock(mInjectionMutex);
+  if (mInjectionQueue.empty()) {
+    return nullptr;
+  }
+  Job *job = mInjectionQueue.front();
+  mInjectionQueue.pop_front();
+  mInjectionSize.fetch_sub(1, std::memory_order_relaxed);
+  return job;
+}
+
+Job *JobSystem::findJob(Worker *worker) {
+  if (worker) {
+    if (Job *job = worker->queue.pop()) {
+      return job;
+    }
+  }
+  if (Job *job = popInjected()) {
+    return job;
+  }
+
+  uint32_t count = getThreadCount();
+  uint32_t start = worker ? worker->index + 1 : 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    Worker *victim = mWorkers[(start + i) % count].get();
+    if (victim == worker) {
+      continue;
+    }
+    if (Job *job = victim->queue.steal()) {
+      return job;
+    }
+  }
+  return nullptr;
+}
+
+bool JobSystem::hasPendingJob() const {
+  if (mInjectionSize.load(std::memory_order_acquire)) {
+    return true;
+  }
+  for (auto &worker : mWorkers) {
+    if (!worker->queue.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void JobSystem::notifyWorker() {
+  // pairs with the fence in workerMain: either the sleeper sees the new job or we see the sleeper
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (mSleeping.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  {
+    std::lock_guard lock(mSleepMutex);
+    ++mWakeEpoch;
+  }
+  mSleepCondition.notify_one();
+}
+
+void JobSystem::workerMain(Worker *worker) {
+  gCurrentSystem = this;
+  gCurrentWorkerIndex = worker->index;
+
+#ifdef __linux__
+  if (mAffinityMask) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (uint32_t cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+      if (mAffinityMask & (uint64_t(1) << cpu)) {
+        CPU_SET(cpu, &cpus);
+      }
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+#endif
+
+  int idle = 0;
+  while (!mShutdown.load(std::memory_order_acquire)) {
+    if (Job *job = findJob(worker)) {
+      idle = 0;
+      job->execute();
+      continue;
+    }
+    if (++idle < kIdleSpinCount) {
+      std::this_thread::yield();
+      continue;
+    }
+    idle = 0;
+
+    std::unique_lock lock(mSleepMutex);
+    uint64_t epoch = mWakeEpoch;
+    mSleeping.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!hasPendingJob()) {
+      mSleepCondition.wait(lock, [&] {
+        return mWakeEpoch != epoch || mShutdown.load(std::memory_order_acquire);
+      });
+    }
+    mSleeping.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  gCurrentSystem = nullptr;
+}
+
+JobSystem &getProcessJobSystem() {
+  static JobSystem system(std::max(1u, std::thread::hardware_concurrency()) - 1);
+  return system;
+}
+
+} // namespace sapien
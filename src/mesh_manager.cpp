@@ -1,15 +1,24 @@
 #include "sapien/mesh_manager.h"
+#include "sapien/job_system.h"
 #include "sapien/simulation.h"
 #include <assimp/Exporter.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <set>
 #include <spdlog/spdlog.h>
 #include <sstream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 namespace sapien {
@@ -214,7 +223,267 @@ getVerticesAndTrianglesFromMeshFile(const std::string &filename) {
   return {vertices, triangles};
 }
 
-MeshManager::MeshManager(Simulation *simulation) : mSimulation(simulation) {}
+/************************************************
+ * Cooked mesh cache
+ * file layout: CookedCacheHeader | payload: (uint64 size, cooked bytes) * count
+ ***********************************************/
+static constexpr uint32_t kCookedCacheMagic = 0x4d435053; // "SPCM"
+static constexpr uint32_t kCookedCacheVersion = 2;
+
+struct CookedCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t sourceHash;
+  uint64_t paramsHash;
+  uint64_t count;
+  // a truncated or corrupted payload is cooked again
+  uint64_t payloadSize;
+  uint64_t payloadHash;
+};
+
+// FNV-1a
+static constexpr uint64_t kHashSeed = 14695981039346656037ull;
+static uint64_t hashBytes(void const *data, size_t size, uint64_t hash = kHashSeed) {
+  auto bytes = static_cast<uint8_t const *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+  }
+  return hash;
+}
+
+template <typename T> static uint64_t hashValue(T value, uint64_t hash) {
+  static_assert(std::is_arithmetic_v<T>);
+  return hashBytes(&value, sizeof(T), hash);
+}
+
+static bool readFile(std::string const &filename, std::vector<uint8_t> &data) {
+  std::ifstream s(filename, std::ios::binary | std::ios::ate);
+  if (!s) {
+    return false;
+  }
+  auto size = s.tellg();
+  if (size < 0) {
+    return false;
+  }
+  data.resize(size);
+  s.seekg(0);
+  return static_cast<bool>(s.read(reinterpret_cast<char *>(data.data()), size));
+}
+
+static uint64_t hashSourceFile(std::string const &filename) {
+  std::vector<uint8_t> data;
+  if (!readFile(filename, data)) {
+    return 0;
+  }
+  return hashBytes(data.data(), data.size());
+}
+
+/** hash everything that changes the cooked output, including the PhysX version */
+static uint64_t hashCookingParams(PxCookingParams const &params, uint32_t meshType,
+                                  uint32_t convexFlags, uint32_t vertexLimit) {
+  uint64_t h = hashValue<uint32_t>(PX_PHYSICS_VERSION, kHashSeed);
+  h = hashValue(meshType, h);
+  h = hashValue(convexFlags, h);
+  h = hashValue(vertexLimit, h);
+  h = hashValue(params.areaTestEpsilon, h);
+  h = hashValue(params.planeTolerance, h);
+  h = hashValue<uint32_t>(params.convexMeshCookingType, h);
+  h = hashValue(params.suppressTriangleMeshRemapTable, h);
+  h = hashValue(params.buildTriangleAdjacencies, h);
+  h = hashValue(params.buildGPUData, h);
+  h = hashValue(params.scale.length, h);
+  h = hashValue(params.scale.speed, h);
+  h = hashValue<uint32_t>(params.meshPreprocessParams, h);
+  h = hashValue(params.meshWeldTolerance, h);
+  h = hashValue<uint32_t>(params.midphaseDesc.getType(), h);
+  h = hashValue(params.gaussMapLimit, h);
+  return h;
+}
+
+/** read a cooked cache, return the cooked blobs pointing into data, empty if stale or invalid */
+static std::vector<std::pair<uint8_t const *, size_t>>
+readCookedCache(std::string const &filename, uint64_t sourceHash, uint64_t paramsHash,
+                std::vector<uint8_t> &data) {
+  if (!readFile(filename, data) || data.size() < sizeof(CookedCacheHeader)) {
+    return {};
+  }
+  CookedCacheHeader header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (header.magic != kCookedCacheMagic || header.version != kCookedCacheVersion ||
+      header.sourceHash != sourceHash || header.paramsHash != paramsHash) {
+    return {};
+  }
+  uint8_t const *payload = data.data() + sizeof(CookedCacheHeader);
+  if (header.payloadSize != data.size() - sizeof(CookedCacheHeader) ||
+      header.payloadHash != hashBytes(payload, header.payloadSize)) {
+    spdlog::get("SAPIEN")->warn("Ignored corrupted cooked mesh cache: {}", filename);
+    return {};
+  }
+
+  std::vector<std::pair<uint8_t const *, size_t>> blobs;
+  size_t p = sizeof(CookedCacheHeader);
+  for (uint64_t i = 0; i < header.count; ++i) {
+    uint64_t size;
+    if (p + sizeof(size) > data.size()) {
+      return {};
+    }
+    std::memcpy(&size, data.data() + p, sizeof(size));
+    p += sizeof(size);
+    if (size > data.size() - p) {
+      return {};
+    }
+    blobs.push_back({data.data() + p, size});
+    p += size;
+  }
+  if (p != data.size()) {
+    return {};
+  }
+  return blobs;
+}
+
+static void writeCookedCache(std::string const &filename, uint64_t sourceHash,
+                             uint64_t paramsHash,
+                             std::vector<PxDefaultMemoryOutputStream const *> const &blobs) {
+  CookedCacheHeader header{kCookedCacheMagic, kCookedCacheVersion, sourceHash, paramsHash,
+                           blobs.size(), 0, kHashSeed};
+  for (auto blob : blobs) {
+    uint64_t size = blob->getSize();
+    header.payloadSize += sizeof(size) + size;
+    header.payloadHash = hashBytes(&size, sizeof(size), header.payloadHash);
+    header.payloadHash = hashBytes(blob->getData(), size, header.payloadHash);
+  }
+
+  // write to a unique temporary file first so concurrent readers never see a partial cache,
+  // mkstemp keeps writers in different processes apart
+  std::string tmpFilename = filename + ".XXXXXX";
+  int fd = mkstemp(tmpFilename.data());
+  if (fd < 0) {
+    spdlog::get("SAPIEN")->warn("Failed to write cooked mesh cache: {}", filename);
+    return;
+  }
+  fchmod(fd, 0644);
+  auto writeAll = [fd](void const *data, size_t size) {
+    auto bytes = static_cast<char const *>(data);
+    while (size) {
+      ssize_t n = ::write(fd, bytes, size);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      bytes += n;
+      size -= n;
+    }
+    return true;
+  };
+  bool ok = writeAll(&header, sizeof(header));
+  for (auto blob : blobs) {
+    uint64_t size = blob->getSize();
+    ok = ok && writeAll(&size, sizeof(size)) && writeAll(blob->getData(), size);
+  }
+  ok = (::close(fd) == 0) && ok;
+  std::error_code ec;
+  if (!ok) {
+    spdlog::get("SAPIEN")->warn("Failed to write cooked mesh cache: {}", filename);
+    fs::remove(tmpFilename, ec);
+    return;
+  }
+  fs::rename(tmpFilename, filename, ec);
+  if (ec) {
+    spdlog::get("SAPIEN")->warn("Failed to write cooked mesh cache: {}", filename);
+    fs::remove(tmpFilename, ec);
+  }
+}
+
+enum CookedMeshType : uint32_t { eCONVEX = 0, eNONCONVEX = 1, eGROUP = 2 };
+
+MeshManager::MeshManager(Simulation *simulation)
+    : mSimulation(simulation), mLoaderThreadCount(std::thread::hardware_concurrency()) {}
+
+void MeshManager::setLoaderThreadCount(uint32_t count) { mLoaderThreadCount = count; }
+
+void MeshManager::preloadMeshes(std::vector<std::pair<MeshLoadType, std::string>> const &meshes) {
+  // loading the same file twice in parallel would waste the work of one of them
+  std::vector<std::pair<MeshLoadType, std::string>> unique;
+  {
+    std::set<std::pair<MeshLoadType, std::string>> seen;
+    for (auto &m : meshes) {
+      if (seen.insert(m).second) {
+        unique.push_back(m);
+      }
+    }
+  }
+
+  auto load = [&](uint32_t i) {
+    auto &[type, filename] = unique[i];
+    switch (type) {
+    case MeshLoadType::CONVEX:
+      loadMesh(filename);
+      break;
+    case MeshLoadType::NON_CONVEX:
+      loadNonConvexMesh(filename);
+      break;
+    case MeshLoadType::GROUP:
+      loadMeshGroup(filename);
+      break;
+    }
+  };
+
+  if (unique.size() <= 1 || mLoaderThreadCount == 0) {
+    for (uint32_t i = 0; i < unique.size(); ++i) {
+      load(i);
+    }
+    return;
+  }
+
+  // the calling thread helps in parallelFor, so it gets a chunk as well
+  auto &jobs = getProcessJobSystem();
+  uint32_t count = unique.size();
+  uint32_t chunks = std::min(count, std::min(mLoaderThreadCount, jobs.getThreadCount()) + 1);
+  std::atomic<uint32_t> next{0};
+  jobs.parallelFor(chunks, [&](uint32_t) {
+    for (uint32_t i = next++; i < count; i = next++) {
+      load(i);
+    }
+  });
+}
+
+PxTriangleMesh *MeshManager::registerNonConvexMesh(NonConvexMeshRecord const &record) {
+  std::lock_guard lock(mRegistryMutex);
+  auto [it, inserted] = mNonConvexMeshRegistry.insert({record.filename, record});
+  if (!inserted) {
+    record.mesh->release();
+  }
+  return it->second.mesh;
+}
+
+PxConvexMesh *MeshManager::registerMesh(MeshRecord const &record) {
+  std::lock_guard lock(mRegistryMutex);
+  auto [it, inserted] = mMeshRegistry.insert({record.filename, record});
+  if (!inserted) {
+    record.mesh->release();
+  }
+  return it->second.mesh;
+}
+
+std::vector<PxConvexMesh *> MeshManager::registerMeshGroup(MeshGroupRecord const &record) {
+  std::lock_guard lock(mRegistryMutex);
+  auto [it, inserted] = mMeshGroupRegistry.insert({record.filename, record});
+  if (!inserted) {
+    for (auto mesh : record.meshes) {
+      if (mesh) {
+        mesh->release();
+      }
+    }
+  }
+  return it->second.meshes;
+}
+
+uint32_t MeshManager::getLoadedMeshCount() {
+  std::lock_guard lock(mRegistryMutex);
+  return mNonConvexMeshRegistry.size() + mMeshRegistry.size() + mMeshGroupRegistry.size();
+}
 
 void MeshManager::setCacheSuffix(const std::string &filename) {
   if (filename.empty()) {
@@ -231,6 +500,18 @@ std::string MeshManager::getCachedFilename(const std::string &filename) {
   return filename + mCacheSuffix;
 }
 
+std::string MeshManager::getCookedCacheFilename(const std::string &filename) {
+  return filename + mCookedCacheSuffix;
+}
+
+std::string MeshManager::getCookedCacheFilenameNonConvex(const std::string &filename) {
+  return filename + mCookedCacheSuffixNonConvex;
+}
+
+std::string MeshManager::getCookedCacheFilenameGroup(const std::string &filename) {
+  return filename + mCookedCacheSuffixGroup;
+}
+
 physx::PxTriangleMesh *MeshManager::loadNonConvexMesh(const std::string &filename, bool useCache,
                                                       bool saveCache) {
 
@@ -240,10 +521,34 @@ physx::PxTriangleMesh *MeshManager::loadNonConvexMesh(const std::string &filenam
   }
 
   std::string fullPath = fs::canonical(filename);
-  auto it = mNonConvexMeshRegistry.find(fullPath);
-  if (it != mNonConvexMeshRegistry.end()) {
-    spdlog::get("SAPIEN")->info("Using loaded mesh: {}", filename);
-    return it->second.mesh;
+  {
+    std::lock_guard lock(mRegistryMutex);
+    auto it = mNonConvexMeshRegistry.find(fullPath);
+    if (it != mNonConvexMeshRegistry.end()) {
+      spdlog::get("SAPIEN")->info("Using loaded mesh: {}", filename);
+      return it->second.mesh;
+    }
+  }
+
+  uint64_t sourceHash = 0;
+  uint64_t paramsHash = 0;
+  bool useCooked = useCache && mCookedCacheEnabled;
+  // a stale or corrupted cooked cache is replaced even when the mesh comes from the file cache
+  bool saveCooked = useCooked && saveCache;
+  if (useCooked) {
+    sourceHash = hashSourceFile(filename);
+    paramsHash = hashCookingParams(mSimulation->mCooking->getParams(), eNONCONVEX, 0, 0);
+    std::vector<uint8_t> data;
+    auto blobs =
+        readCookedCache(getCookedCacheFilenameNonConvex(filename), sourceHash, paramsHash, data);
+    if (blobs.size() == 1) {
+      PxDefaultMemoryInputData input(const_cast<uint8_t *>(blobs[0].first), blobs[0].second);
+      if (PxTriangleMesh *mesh = mSimulation->mPhysicsSDK->createTriangleMesh(input)) {
+        spdlog::get("SAPIEN")->info("Loaded cooked non-convex mesh: {}", filename);
+        return registerNonConvexMesh({/* cached */ true, /* filename */ fullPath,
+                                      /* mesh */ mesh});
+      }
+    }
   }
 
   bool cacheDidLoad = false;
@@ -276,6 +581,11 @@ physx::PxTriangleMesh *MeshManager::loadNonConvexMesh(const std::string &filenam
   PxDefaultMemoryInputData readBuffer(writeBuffer.getData(), writeBuffer.getSize());
   PxTriangleMesh *mesh = mSimulation->mPhysicsSDK->createTriangleMesh(readBuffer);
 
+  if (saveCooked) {
+    writeCookedCache(getCookedCacheFilenameNonConvex(filename), sourceHash, paramsHash,
+                     {&writeBuffer});
+  }
+
   spdlog::get("SAPIEN")->info("Created {} vertices and {} faces from: {}", mesh->getNbVertices(),
                               mesh->getNbTriangles(), filename);
 
@@ -285,11 +595,9 @@ physx::PxTriangleMesh *MeshManager::loadNonConvexMesh(const std::string &filenam
     spdlog::get("SAPIEN")->info("Saved non-convex cache file: {}", cachedFilename);
   }
 
-  mNonConvexMeshRegistry[fullPath] = {/* cached */ cacheDidLoad || saveCache,
-                                      /* filename */ fullPath,
-                                      /* mesh */ mesh};
-
-  return mesh;
+  return registerNonConvexMesh({/* cached */ cacheDidLoad || saveCache,
+                                /* filename */ fullPath,
+                                /* mesh */ mesh});
 }
 
 physx::PxConvexMesh *MeshManager::loadMesh(const std::string &filename, bool useCache,
@@ -301,10 +609,34 @@ physx::PxConvexMesh *MeshManager::loadMesh(const std::string &filename, bool use
   }
 
   std::string fullPath = fs::canonical(filename);
-  auto it = mMeshRegistry.find(fullPath);
-  if (it != mMeshRegistry.end()) {
-    spdlog::get("SAPIEN")->info("Using loaded mesh: {}", filename);
-    return it->second.mesh;
+  {
+    std::lock_guard lock(mRegistryMutex);
+    auto it = mMeshRegistry.find(fullPath);
+    if (it != mMeshRegistry.end()) {
+      spdlog::get("SAPIEN")->info("Using loaded mesh: {}", filename);
+      return it->second.mesh;
+    }
+  }
+
+  uint64_t sourceHash = 0;
+  uint64_t paramsHash = 0;
+  bool useCooked = useCache && mCookedCacheEnabled;
+  // a stale or corrupted cooked cache is replaced even when the mesh comes from the file cache
+  bool saveCooked = useCooked && saveCache;
+  if (useCooked) {
+    sourceHash = hashSourceFile(filename);
+    paramsHash = hashCookingParams(mSimulation->mCooking->getParams(), eCONVEX,
+                                   PxConvexFlag::eCOMPUTE_CONVEX, 256);
+    std::vector<uint8_t> data;
+    auto blobs = readCookedCache(getCookedCacheFilename(filename), sourceHash, paramsHash, data);
+    if (blobs.size() == 1) {
+      PxDefaultMemoryInputData input(const_cast<uint8_t *>(blobs[0].first), blobs[0].second);
+      if (PxConvexMesh *convexMesh = mSimulation->mPhysicsSDK->createConvexMesh(input)) {
+        spdlog::get("SAPIEN")->info("Loaded cooked mesh: {}", filename);
+        return registerMesh({/* cached */ true, /* filename */ fullPath,
+                             /* mesh */ convexMesh});
+      }
+    }
   }
 
   bool cacheDidLoad = false;
@@ -335,6 +667,10 @@ physx::PxConvexMesh *MeshManager::loadMesh(const std::string &filename, bool use
   PxDefaultMemoryInputData input(buf.getData(), buf.getSize());
   PxConvexMesh *convexMesh = mSimulation->mPhysicsSDK->createConvexMesh(input);
 
+  if (saveCooked) {
+    writeCookedCache(getCookedCacheFilename(filename), sourceHash, paramsHash, {&buf});
+  }
+
   spdlog::get("SAPIEN")->info("Created {} vertices from: {}",
                               std::to_string(convexMesh->getNbVertices()), filename);
 
@@ -344,10 +680,8 @@ physx::PxConvexMesh *MeshManager::loadMesh(const std::string &filename, bool use
     spdlog::get("SAPIEN")->info("Saved cache file: {}", cachedFilename);
   }
 
-  mMeshRegistry[fullPath] = {/* cached */ cacheDidLoad || saveCache, /* filename */ fullPath,
-                             /* mesh */ convexMesh};
-
-  return convexMesh;
+  return registerMesh({/* cached */ cacheDidLoad || saveCache, /* filename */ fullPath,
+                       /* mesh */ convexMesh});
 }
 
 std::vector<std::vector<int>> splitMesh(aiMesh *mesh) {
@@ -403,13 +737,43 @@ std::vector<PxConvexMesh *> MeshManager::loadMeshGroup(const std::string &filena
   }
 
   std::string fullPath = fs::canonical(filename);
-  auto it = mMeshGroupRegistry.find(fullPath);
-  if (it != mMeshGroupRegistry.end()) {
-    spdlog::get("SAPIEN")->info("Using loaded mesh group: {}", filename);
-    for (PxConvexMesh *mesh : it->second.meshes) {
-      meshes.push_back(mesh);
+  {
+    std::lock_guard lock(mRegistryMutex);
+    auto it = mMeshGroupRegistry.find(fullPath);
+    if (it != mMeshGroupRegistry.end()) {
+      spdlog::get("SAPIEN")->info("Using loaded mesh group: {}", filename);
+      for (PxConvexMesh *mesh : it->second.meshes) {
+        meshes.push_back(mesh);
+      }
+      return meshes;
+    }
+  }
+
+  uint64_t sourceHash = 0;
+  uint64_t paramsHash = 0;
+  if (mCookedCacheEnabled) {
+    sourceHash = hashSourceFile(filename);
+    paramsHash = hashCookingParams(mSimulation->mCooking->getParams(), eGROUP,
+                                   PxConvexFlag::eCOMPUTE_CONVEX, 256);
+    std::vector<uint8_t> data;
+    auto blobs =
+        readCookedCache(getCookedCacheFilenameGroup(filename), sourceHash, paramsHash, data);
+    for (auto [ptr, size] : blobs) {
+      PxDefaultMemoryInputData input(const_cast<uint8_t *>(ptr), size);
+      PxConvexMesh *convexMesh = mSimulation->mPhysicsSDK->createConvexMesh(input);
+      if (!convexMesh) {
+        for (auto mesh : meshes) {
+          mesh->release();
+        }
+        meshes.clear();
+        break;
+      }
+      meshes.push_back(convexMesh);
+    }
+    if (!meshes.empty()) {
+      spdlog::get("SAPIEN")->info("Loaded {} cooked meshes: {}", meshes.size(), filename);
+      return registerMeshGroup({fullPath, meshes});
     }
-    return meshes;
   }
 
   // import obj using assimp
@@ -428,6 +792,8 @@ std::vector<PxConvexMesh *> MeshManager::loadMeshGroup(const std::string &filena
     return meshes;
   }
 
+  // streams own their memory and cannot be moved, deque keeps them in place
+  std::deque<PxDefaultMemoryOutputStream> cooked;
   spdlog::get("SAPIEN")->info("Found {} meshes", scene->mNumMeshes);
   for (uint32_t i = 0; i < scene->mNumMeshes; ++i) {
     auto mesh = scene->mMeshes[i];
@@ -449,7 +815,7 @@ std::vector<PxConvexMesh *> MeshManager::loadMeshGroup(const std::string &filena
       convexDesc.flags = PxConvexFlag::eCOMPUTE_CONVEX; // | PxConvexFlag::eSHIFT_VERTICES;
       convexDesc.vertexLimit = 256;
 
-      PxDefaultMemoryOutputStream buf;
+      auto &buf = cooked.emplace_back();
       PxConvexMeshCookingResult::Enum result;
       if (!mSimulation->mCooking->cookConvexMesh(convexDesc, buf, &result)) {
         spdlog::get("SAPIEN")->error("Failed to cook a mesh from file: {}", filename);
@@ -460,8 +826,16 @@ std::vector<PxConvexMesh *> MeshManager::loadMeshGroup(const std::string &filena
     }
   }
 
-  mMeshGroupRegistry[fullPath] = {fullPath, meshes};
-  return meshes;
+  bool allCooked = std::all_of(meshes.begin(), meshes.end(), [](auto m) { return m; });
+  if (mCookedCacheEnabled && allCooked && !meshes.empty()) {
+    std::vector<PxDefaultMemoryOutputStream const *> blobs;
+    for (auto &buf : cooked) {
+      blobs.push_back(&buf);
+    }
+    writeCookedCache(getCookedCacheFilenameGroup(filename), sourceHash, paramsHash, blobs);
+  }
+
+  return registerMeshGroup({fullPath, meshes});
 }
 
 } // namespace sapien
@@ -0,0 +1,286 @@
+#include "sapien/renderer/null_renderer.h"
+#include <algorithm>
+
+namespace sapien {
+namespace Renderer {
+
+//========== Body ==========//
+NullRigidbody::NullRigidbody(NullScene *scene, uint32_t index, physx::PxGeometryType::Enum type,
+                             physx::PxVec3 const &scale,
+                             std::vector<std::shared_ptr<IPxrRenderShape>> shapes)
+    : mScene(scene), mIndex(index), mType(type), mScale(scale), mShapes(std::move(shapes)) {}
+
+void NullRigidbody::setUniqueId(uint32_t uniqueId) { mScene->getBodyIds()[2 * mIndex] = uniqueId; }
+uint32_t NullRigidbody::getUniqueId() const { return mScene->getBodyIds()[2 * mIndex]; }
+
+void NullRigidbody::setSegmentationId(uint32_t segmentationId) {
+  mScene->getBodyIds()[2 * mIndex + 1] = segmentationId;
+}
+uint32_t NullRigidbody::getSegmentationId() const {
+  return mScene->getBodyIds()[2 * mIndex + 1];
+}
+
+void NullRigidbody::update(const physx::PxTransform &transform) {
+  mScene->setBodyPose(mIndex, transform * mInitialPose);
+}
+
+void NullRigidbody::destroy() { mScene->removeRigidbody(this); }
+
+//========== Camera ==========//
+NullCamera::NullCamera(NullScene *scene, uint32_t width, uint32_t height, float fovy, float near,
+                       float far)
+    : mScene(scene), mWidth(width), mHeight(height), mCx(width / 2.f), mCy(height / 2.f),
+      mFx(height / 2.f / std::tan(fovy / 2.f)), mFy(height / 2.f / std::tan(fovy / 2.f)),
+      mNear(near), mFar(far) {}
+
+IPxrScene *NullCamera::getScene() { return mScene; }
+
+void NullCamera::setPerspectiveCameraParameters(float near, float far, float fx, float fy,
+                                                float cx, float cy, float skew) {
+  mNear = near;
+  mFar = far;
+  mFx = fx;
+  mFy = fy;
+  mCx = cx;
+  mCy = cy;
+  mSkew = skew;
+}
+
+std::string NullCamera::getImageFormat(std::string const &name) {
+  return name == "Segmentation" ? "i4" : "f4";
+}
+
+std::vector<float> NullCamera::getFloatImage(std::string const &name) {
+  if (getImageFormat(name) != "f4") {
+    throw std::runtime_error("failed to get image: " + name + " is not a float image");
+  }
+  return std::vector<float>(mWidth * mHeight * 4);
+}
+
+std::vector<uint32_t> NullCamera::getUintImage(std::string const &name) {
+  if (getImageFormat(name) != "i4") {
+    throw std::runtime_error("failed to get image: " + name + " is not a uint32 image");
+  }
+  return std::vector<uint32_t>(mWidth * mHeight * 4);
+}
+
+//========== Scene ==========//
+NullScene::NullScene(NullRenderer *parent, std::string const &name)
+    : mParentRenderer(parent), mName(name) {}
+
+NullRigidbody *NullScene::addBody(physx::PxGeometryType::Enum type, physx::PxVec3 const &scale,
+                                  std::vector<std::shared_ptr<IPxrRenderShape>> shapes) {
+  uint32_t index = mBodies.size();
+  mBodies.push_back(std::make_unique<NullRigidbody>(this, index, type, scale, std::move(shapes)));
+  mBodyPoses.insert(mBodyPoses.end(), {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f});
+  mBodyIds.insert(mBodyIds.end(), {0, 0});
+  return mBodies.back().get();
+}
+
+IPxrRigidbody *NullScene::addRigidbody(const std::string &meshFile, const physx::PxVec3 &scale) {
+  // mesh files are not loaded, the body has no shapes
+  return addBody(physx::PxGeometryType::eTRIANGLEMESH, scale, {});
+}
+
+IPxrRigidbody *NullScene::addRigidbody(std::shared_ptr<IRenderMesh> mesh,
+                                       const physx::PxVec3 &scale,
+                                       std::shared_ptr<IPxrMaterial> material) {
+  if (!material) {
+    material = std::make_shared<NullMaterial>();
+  }
+  return addBody(physx::PxGeometryType::eTRIANGLEMESH, scale,
+                 {std::make_shared<NullRenderShape>(mesh, material)});
+}
+
+IPxrRigidbody *NullScene::addRigidbody(physx::PxGeometryType::Enum type,
+                                       const physx::PxVec3 &scale,
+                                       std::shared_ptr<IPxrMaterial> material) {
+  switch (type) {
+  case physx::PxGeometryType::eBOX:
+  case physx::PxGeometryType::eCAPSULE:
+  case physx::PxGeometryType::eSPHERE:
+  case physx::PxGeometryType::ePLANE:
+    break;
+  default:
+    throw std::runtime_error("Failed to add rigidbody: unsupported render body type");
+  }
+  if (!material) {
+    material = std::make_shared<NullMaterial>();
+  }
+  return addBody(type, scale, {std::make_shared<NullRenderShape>(nullptr, material)});
+}
+
+IPxrRigidbody *NullScene::addRigidbody(physx::PxGeometryType::Enum type,
+                                       const physx::PxVec3 &scale, const physx::PxVec3 &color) {
+  auto material = std::make_shared<NullMaterial>();
+  material->setBaseColor({color.x, color.y, color.z, 1.f});
+  return addRigidbody(type, scale, material);
+}
+
+IPxrRigidbody *NullScene::addRigidbody(std::vector<physx::PxVec3> const &vertices,
+                                       std::vector<physx::PxVec3> const &normals,
+                                       std::vector<uint32_t> const &indices,
+                                       const physx::PxVec3 &scale,
+                                       std::shared_ptr<IPxrMaterial> material) {
+  std::vector<float> flatVertices;
+  flatVertices.reserve(vertices.size() * 3);
+  for (auto const &v : vertices) {
+    flatVertices.insert(flatVertices.end(), {v.x, v.y, v.z});
+  }
+  std::vector<float> flatNormals;
+  flatNormals.reserve(normals.size() * 3);
+  for (auto const &n : normals) {
+    flatNormals.insert(flatNormals.end(), {n.x, n.y, n.z});
+  }
+  auto mesh = std::make_shared<NullRenderMesh>(flatVertices, indices);
+  mesh->setNormals(flatNormals);
+  return addRigidbody(mesh, scale, material);
+}
+
+IPxrRigidbody *NullScene::addRigidbody(std::vector<physx::PxVec3> const &vertices,
+                                       std::vector<physx::PxVec3> const &normals,
+                                       std::vector<uint32_t> const &indices,
+                                       const physx::PxVec3 &scale, const physx::PxVec3 &color) {
+  auto material = std::make_shared<NullMaterial>();
+  material->setBaseColor({color.x, color.y, color.z, 1.f});
+  return addRigidbody(vertices, normals, indices, scale, material);
+}
+
+void NullScene::removeRigidbody(IPxrRigidbody *body) {
+  // a body knows its slot, checking that the slot holds it is enough to prove ownership
+  auto nullBody = dynamic_cast<NullRigidbody *>(body);
+  if (!nullBody || nullBody->getIndex() >= mBodies.size() ||
+      mBodies[nullBody->getIndex()].get() != nullBody) {
+    throw std::runtime_error("failed to remove body: invalid body");
+  }
+
+  // move the last body into the hole so the flat arrays stay dense
+  uint32_t index = nullBody->getIndex();
+  uint32_t last = mBodies.size() - 1;
+  if (index != last) {
+    std::copy_n(mBodyPoses.begin() + last * kPoseSize, kPoseSize,
+                mBodyPoses.begin() + index * kPoseSize);
+    std::copy_n(mBodyIds.begin() + last * 2, 2, mBodyIds.begin() + index * 2);
+    mBodies[last]->setIndex(index);
+    std::swap(mBodies[index], mBodies[last]);
+  }
+  mBodies.pop_back();
+  mBodyPoses.resize(last * kPoseSize);
+  mBodyIds.resize(last * 2);
+}
+
+void NullScene::setBodyPose(uint32_t index, physx::PxTransform const &pose) {
+  float *out = mBodyPoses.data() + index * kPoseSize;
+  out[0] = pose.p.x;
+  out[1] = pose.p.y;
+  out[2] = pose.p.z;
+  out[3] = pose.q.w;
+  out[4] = pose.q.x;
+  out[5] = pose.q.y;
+  out[6] = pose.q.z;
+}
+
+ICamera *NullScene::addCamera(uint32_t width, uint32_t height, float fovy, float near, float far,
+                              std::string const &shaderDir) {
+  if (!shaderDir.empty()) {
+    spdlog::get("SAPIEN")->warn("shader directory is ignored by the null renderer");
+  }
+  mCameras.push_back(std::make_unique<NullCamera>(this, width, height, fovy, near, far));
+  return mCameras.back().get();
+}
+
+void NullScene::removeCamera(ICamera *camera) {
+  std::erase_if(mCameras, [=](auto const &c) { return c.get() == camera; });
+}
+
+std::vector<ICamera *> NullScene::getCameras() {
+  std::vector<ICamera *> cams;
+  for (auto &cam : mCameras) {
+    cams.push_back(cam.get());
+  }
+  return cams;
+}
+
+IPointLight *NullScene::addPointLight(std::array<float, 3> const &position,
+                                      std::array<float, 3> const &color, bool enableShadow,
+                                      float shadowNear, float shadowFar, uint32_t shadowMapSize) {
+  auto light = std::make_unique<NullPointLight>();
+  light->setPosition({position[0], position[1], position[2]});
+  light->setColor({color[0], color[1], color[2]});
+  light->setShadowEnabled(enableShadow);
+  light->setShadowParameters(shadowNear, shadowFar);
+  auto result = light.get();
+  mLights.push_back(std::move(light));
+  return result;
+}
+
+IDirectionalLight *NullScene::addDirectionalLight(std::array<float, 3> const &direction,
+                                                  std::array<float, 3> const &color,
+                                                  bool enableShadow,
+                                                  std::array<float, 3> const &position,
+                                                  float shadowScale, float shadowNear,
+                                                  float shadowFar, uint32_t shadowMapSize) {
+  auto light = std::make_unique<NullDirectionalLight>();
+  light->setPose({{position[0], position[1], position[2]}, physx::PxQuat(physx::PxIdentity)});
+  light->setDirection({direction[0], direction[1], direction[2]});
+  light->setColor({color[0], color[1], color[2]});
+  light->setShadowEnabled(enableShadow);
+  light->setShadowParameters(shadowScale, shadowNear, shadowFar);
+  auto result = light.get();
+  mLights.push_back(std::move(light));
+  return result;
+}
+
+ISpotLight *NullScene::addSpotLight(std::array<float, 3> const &position,
+                                    std::array<float, 3> const &direction, float fovInner,
+                                    float fovOuter, std::array<float, 3> const &color,
+                                    bool enableShadow, float shadowNear, float shadowFar,
+                                    uint32_t shadowMapSize) {
+  auto light = std::make_unique<NullSpotLight>();
+  light->setPosition({position[0], position[1], position[2]});
+  light->setDirection({direction[0], direction[1], direction[2]});
+  light->setFov(fovOuter);
+  light->setColor({color[0], color[1], color[2]});
+  light->setShadowEnabled(enableShadow);
+  light->setShadowParameters(shadowNear, shadowFar);
+  auto result = light.get();
+  mLights.push_back(std::move(light));
+  return result;
+}
+
+void NullScene::removeLight(ILight *light) {
+  std::erase_if(mLights, [=](auto const &l) { return l.get() == light; });
+}
+
+void NullScene::updateRender() { ++mUpdateCount; }
+
+void NullScene::updateRenderAndTakePictures(std::vector<ICamera *> const &cameras) {
+  updateRender();
+  for (auto cam : cameras) {
+    cam->takePicture();
+  }
+}
+
+void NullScene::destroy() { mParentRenderer->removeScene(this); }
+
+//========== Renderer ==========//
+IPxrScene *NullRenderer::createScene(std::string const &name) {
+  mScenes.push_back(std::make_unique<NullScene>(this, name));
+  return mScenes.back().get();
+}
+
+void NullRenderer::removeScene(IPxrScene *scene) {
+  std::erase_if(mScenes, [=](auto const &s) { return s.get() == scene; });
+}
+
+std::shared_ptr<IPxrMaterial> NullRenderer::createMaterial() {
+  return std::make_shared<NullMaterial>();
+}
+
+std::shared_ptr<IRenderMesh> NullRenderer::createMesh(std::vector<float> const &vertices,
+                                                      std::vector<uint32_t> const &indices) {
+  return std::make_shared<NullRenderMesh>(vertices, indices);
+}
+
+} // namespace Renderer
+} // namespace sapien
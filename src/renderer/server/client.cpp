@@ -1,4 +1,7 @@
 #include "sapien/renderer/server/client.h"
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
 #include <spdlog/spdlog.h>
 
 namespace sapien {
@@ -13,69 +16,43 @@ ClientMaterial::ClientMaterial(std::shared_ptr<ClientRenderer> renderer, rs_id_t
     : mRenderer(renderer), mId(id){};
 
 void ClientMaterial::setBaseColor(std::array<float, 4> color) {
-  ClientContext context;
-  proto::IdVec4 req;
-  proto::Empty res;
-  proto::Vec4 data;
-
-  req.set_id(mId);
-  req.mutable_data()->set_x(color[0]);
-  req.mutable_data()->set_y(color[1]);
-  req.mutable_data()->set_z(color[2]);
-  req.mutable_data()->set_w(color[3]);
-
-  Status status = mRenderer->getStub().SetBaseColor(&context, req, &res);
-  if (!status.ok()) {
-    throw std::runtime_error(status.error_message());
-  }
+  proto::SceneBatchOp op;
+  auto req = op.mutable_set_base_color();
+  req->set_id(mId);
+  req->mutable_data()->set_x(color[0]);
+  req->mutable_data()->set_y(color[1]);
+  req->mutable_data()->set_z(color[2]);
+  req->mutable_data()->set_w(color[3]);
+  mRenderer->enqueue(std::move(op));
 }
 
 void ClientMaterial::setRoughness(float roughness) {
-  ClientContext context;
-  proto::IdFloat req;
-  proto::Empty res;
-  req.set_id(mId);
-  req.set_data(roughness);
-
-  Status status = mRenderer->getStub().SetRoughness(&context, req, &res);
-  if (!status.ok()) {
-    throw std::runtime_error(status.error_message());
-  }
+  proto::SceneBatchOp op;
+  op.mutable_set_roughness()->set_id(mId);
+  op.mutable_set_roughness()->set_data(roughness);
+  mRenderer->enqueue(std::move(op));
 }
 
 void ClientMaterial::setSpecular(float specular) {
-  ClientContext context;
-  proto::IdFloat req;
-  proto::Empty res;
-  req.set_id(mId);
-  req.set_data(specular);
-
-  Status status = mRenderer->getStub().SetSpecular(&context, req, &res);
-  if (!status.ok()) {
-    throw std::runtime_error(status.error_message());
-  }
+  proto::SceneBatchOp op;
+  op.mutable_set_specular()->set_id(mId);
+  op.mutable_set_specular()->set_data(specular);
+  mRenderer->enqueue(std::move(op));
 }
 
 void ClientMaterial::setMetallic(float metallic) {
-  ClientContext context;
-  proto::IdFloat req;
-  proto::Empty res;
-  req.set_id(mId);
-  req.set_data(metallic);
-
-  Status status = mRenderer->getStub().SetMetallic(&context, req, &res);
-  if (!status.ok()) {
-    throw std::runtime_error(status.error_message());
-  }
+  proto::SceneBatchOp op;
+  op.mutable_set_metallic()->set_id(mId);
+  op.mutable_set_metallic()->set_data(metallic);
+  mRenderer->enqueue(std::move(op));
 }
 
 ClientMaterial::~ClientMaterial() {
-  ClientContext context;
-  proto::Id req;
-  proto::Empty res;
-  req.set_id(mId);
-  Status status = mRenderer->getStub().RemoveMaterial(&context, req, &res);
-  if (!status.ok()) {
+  proto::SceneBatchOp op;
+  op.mutable_remove_material()->set_id(mId);
+  try {
+    mRenderer->enqueue(std::move(op));
+  } catch (std::runtime_error const &) {
     spdlog::get("SAPIEN")->error("remove client material failed. Is the server closed?");
   }
 }
@@ -88,46 +65,37 @@ ClientCamera::ClientCamera(ClientScene *scene, rs_id_t id, uint32_t width, uint3
     : mScene(scene), mId(id), mWidth(width), mHeight(height), mCx(cx), mCy(cy), mFx(fy), mFy(fy),
       mNear(near), mFar(far), mSkew(skew) {}
 void ClientCamera::takePicture() {
-  ClientContext context;
-  proto::TakePictureReq req;
-  proto::Empty res;
-  req.set_scene_id(mScene->getId());
-  req.set_camera_id(mId);
+  proto::SceneBatchOp op;
+  op.mutable_take_picture()->set_scene_id(mScene->getId());
+  op.mutable_take_picture()->set_camera_id(mId);
 
-  Status status = mScene->getRenderer()->getStub().TakePicture(&context, req, &res);
-  if (!status.ok()) {
-    throw std::runtime_error(status.error_message());
-  }
+  // the picture is expected once this returns
+  mScene->getRenderer()->enqueue(std::move(op));
+  mScene->getRenderer()->flush();
 }
 
 void ClientCamera::setPerspectiveCameraParameters(float near, float far, float fx, float fy,
                                                   float cx, float cy, float skew) {
-  ClientContext context;
-  proto::CameraParamsReq req;
-  proto::Empty res;
-
-  req.set_scene_id(mScene->getId());
-  req.set_camera_id(mId);
-  req.set_near(near);
-  req.set_far(far);
-  req.set_fx(fx);
-  req.set_fy(fy);
-  req.set_cx(cx);
-  req.set_cy(cy);
-  req.set_skew(skew);
-
-  Status status = mScene->getRenderer()->getStub().SetCameraParameters(&context, req, &res);
-  if (status.ok()) {
-    mNear = near;
-    mFar = far;
-    mFx = fx;
-    mFy = fy;
-    mCx = cx;
-    mCy = cy;
-    mSkew = skew;
-    return;
-  }
-  throw std::runtime_error(status.error_message());
+  proto::SceneBatchOp op;
+  auto req = op.mutable_set_camera_parameters();
+  req->set_scene_id(mScene->getId());
+  req->set_camera_id(mId);
+  req->set_near(near);
+  req->set_far(far);
+  req->set_fx(fx);
+  req->set_fy(fy);
+  req->set_cx(cx);
+  req->set_cy(cy);
+  req->set_skew(skew);
+  mScene->getRenderer()->enqueue(std::move(op));
+
+  mNear = near;
+  mFar = far;
+  mFx = fx;
+  mFy = fy;
+  mCx = cx;
+  mCy = cy;
+  mSkew = skew;
 }
 
 //========== Shape ==========//
@@ -135,6 +103,9 @@ void ClientCamera::setPerspectiveCameraParameters(float near, float far, float f
 ClientShape::ClientShape(ClientRigidbody *body, uint32_t index) : mBody(body), mIndex(index) {}
 
 std::shared_ptr<IPxrMaterial> ClientShape::getMaterial() const {
+  auto renderer = mBody->getScene()->getRenderer();
+  renderer->flush();
+
   ClientContext context;
   proto::BodyUint32Req req;
   proto::Id res;
@@ -142,13 +113,11 @@ std::shared_ptr<IPxrMaterial> ClientShape::getMaterial() const {
   req.set_body_id(mBody->getId());
   req.set_id(mIndex);
 
-  Status status =
-      mBody->getScene()->getRenderer()->getStub().GetShapeMaterial(&context, req, &res);
+  Status status = renderer->getStub().GetShapeMaterial(&context, req, &res);
   if (!status.ok()) {
     throw std::runtime_error(status.error_message());
   }
-  return std::make_shared<ClientMaterial>(mBody->getScene()->getRenderer()->shared_from_this(),
-                                          res.id());
+  return std::make_shared<ClientMaterial>(renderer->shared_from_this(), res.id());
 }
 
 //========== Body ==========//
@@ -156,33 +125,24 @@ ClientRigidbody::ClientRigidbody(ClientScene *scene, rs_id_t id) : mScene(scene)
 
 void ClientRigidbody::setUniqueId(uint32_t uniqueId) {
   mUniqueId = uniqueId;
-  ClientContext context;
-  proto::BodyIdReq req;
-  proto::Empty res;
-  req.set_scene_id(mScene->getId());
-  req.set_body_id(mId);
-  req.set_id(uniqueId);
 
-  Status status = mScene->getRenderer()->getStub().SetUniqueId(&context, req, &res);
-  if (!status.ok()) {
-    throw std::runtime_error(status.error_message());
-  }
+  proto::SceneBatchOp op;
+  auto req = op.mutable_set_unique_id();
+  req->set_scene_id(mScene->getId());
+  req->set_body_id(mId);
+  req->set_id(uniqueId);
+  mScene->getRenderer()->enqueue(std::move(op));
 }
 uint32_t ClientRigidbody::getUniqueId() const { return mUniqueId; }
 void ClientRigidbody::setSegmentationId(uint32_t segmentationId) {
   mSegmentationId = segmentationId;
 
-  ClientContext context;
-  proto::BodyIdReq req;
-  proto::Empty res;
-  req.set_scene_id(mScene->getId());
-  req.set_body_id(mId);
-  req.set_id(segmentationId);
-
-  Status status = mScene->getRenderer()->getStub().SetSegmentationId(&context, req, &res);
-  if (!status.ok()) {
-    throw std::runtime_error(status.error_message());
-  }
+  proto::SceneBatchOp op;
+  auto req = op.mutable_set_segmentation_id();
+  req->set_scene_id(mScene->getId());
+  req->set_body_id(mId);
+  req->set_id(segmentationId);
+  mScene->getRenderer()->enqueue(std::move(op));
 }
 uint32_t ClientRigidbody::getSegmentationId() const { return mSegmentationId; }
 
@@ -195,22 +155,19 @@ void ClientRigidbody::update(const physx::PxTransform &transform) {
 }
 
 void ClientRigidbody::setVisibility(float visibility) {
-  ClientContext context;
-  proto::BodyFloat32Req req;
-  proto::Empty res;
-
-  req.set_scene_id(mScene->getId());
-  req.set_body_id(mId);
-  req.set_value(visibility);
-  Status status = mScene->getRenderer()->getStub().SetVisibility(&context, req, &res);
-  if (!status.ok()) {
-    throw std::runtime_error(status.error_message());
-  }
+  proto::SceneBatchOp op;
+  auto req = op.mutable_set_visibility();
+  req->set_scene_id(mScene->getId());
+  req->set_body_id(mId);
+  req->set_value(visibility);
+  mScene->getRenderer()->enqueue(std::move(op));
 }
 
 void ClientRigidbody::destroy() { mScene->removeRigidbody(this); }
 
 std::vector<std::shared_ptr<IPxrRenderShape>> ClientRigidbody::getRenderShapes() {
+  mScene->getRenderer()->flush();
+
   ClientContext context;
   proto::BodyReq req;
   proto::Uint32 res;
@@ -241,23 +198,21 @@ IPxrRigidbody *ClientScene::addRigidbody(physx::PxGeometryType::Enum type,
 }
 
 IPxrRigidbody *ClientScene::addRigidbody(const std::string &meshFile, const physx::PxVec3 &scale) {
-  mIdSynced = false;
-  ClientContext context;
-  proto::AddBodyMeshReq req;
-  proto::Id res;
-
-  req.set_scene_id(mId);
-  req.set_filename(meshFile);
-  req.mutable_scale()->set_x(scale.x);
-  req.mutable_scale()->set_y(scale.y);
-  req.mutable_scale()->set_z(scale.z);
+  rs_id_t id = mRenderer->reserveId();
+
+  proto::SceneBatchOp op;
+  auto req = op.mutable_add_body_mesh();
+  req->set_scene_id(mId);
+  req->set_filename(meshFile);
+  req->mutable_scale()->set_x(scale.x);
+  req->mutable_scale()->set_y(scale.y);
+  req->mutable_scale()->set_z(scale.z);
+  req->set_id(id);
+  mRenderer->enqueue(std::move(op));
 
-  Status status = mRenderer->getStub().AddBodyMesh(&context, req, &res);
-  if (status.ok()) {
-    mBodies.push_back(std::make_unique<ClientRigidbody>(this, res.id()));
-    return mBodies.back().get();
-  }
-  throw std::runtime_error(status.error_message());
+  mIdSynced = false;
+  mBodies.push_back(std::make_unique<ClientRigidbody>(this, id));
+  return mBodies.back().get();
 }
 IPxrRigidbody *ClientScene::addRigidbody(physx::PxGeometryType::Enum type,
                                          const physx::PxVec3 &scale,
@@ -266,92 +221,86 @@ IPxrRigidbody *ClientScene::addRigidbody(physx::PxGeometryType::Enum type,
     material = mRenderer->createMaterial();
   }
 
-  mIdSynced = false;
-  ClientContext context;
-  proto::AddBodyPrimitiveReq req;
-  proto::Id res;
-
-  req.set_scene_id(mId);
-  req.mutable_scale()->set_x(scale.x);
-  req.mutable_scale()->set_y(scale.y);
-  req.mutable_scale()->set_z(scale.z);
+  proto::SceneBatchOp op;
+  auto req = op.mutable_add_body_primitive();
+  req->set_scene_id(mId);
+  req->mutable_scale()->set_x(scale.x);
+  req->mutable_scale()->set_y(scale.y);
+  req->mutable_scale()->set_z(scale.z);
 
   switch (type) {
   case physx::PxGeometryType::eBOX:
-    req.set_type(proto::PrimitiveType::BOX);
+    req->set_type(proto::PrimitiveType::BOX);
     break;
   case physx::PxGeometryType::eCAPSULE:
-    req.set_type(proto::PrimitiveType::CAPSULE);
+    req->set_type(proto::PrimitiveType::CAPSULE);
     break;
   case physx::PxGeometryType::eSPHERE:
-    req.set_type(proto::PrimitiveType::SPHERE);
+    req->set_type(proto::PrimitiveType::SPHERE);
     break;
   case physx::PxGeometryType::ePLANE:
-    req.set_type(proto::PrimitiveType::PLANE);
+    req->set_type(proto::PrimitiveType::PLANE);
     break;
   default:
     throw std::runtime_error("failed to add primitive body: invalid primitve type");
   }
 
   if (auto mat = std::dynamic_pointer_cast<ClientMaterial>(material)) {
-    req.set_material(mat->getId());
+    req->set_material(mat->getId());
   } else {
     throw std::runtime_error("failed to add primitive body: invalid material");
   }
 
-  Status status = mRenderer->getStub().AddBodyPrimitive(&context, req, &res);
-  if (status.ok()) {
-    mBodies.push_back(std::make_unique<ClientRigidbody>(this, res.id()));
-    return mBodies.back().get();
-  }
-  throw std::runtime_error(status.error_message());
-}
+  rs_id_t id = mRenderer->reserveId();
+  req->set_id(id);
+  mRenderer->enqueue(std::move(op));
 
-void ClientScene::removeRigidbody(IPxrRigidbody *body) {
   mIdSynced = false;
-  if (ClientRigidbody *b = dynamic_cast<ClientRigidbody *>(body)) {
-    ClientContext context;
-    proto::RemoveBodyReq req;
-    proto::Empty res;
-    req.set_scene_id(mId);
-    req.set_body_id(b->getId());
+  mBodies.push_back(std::make_unique<ClientRigidbody>(this, id));
+  return mBodies.back().get();
+}
 
-    Status status = mRenderer->getStub().RemoveBody(&context, req, &res);
-    if (!status.ok()) {
-      throw std::runtime_error(status.error_message());
-    }
+void ClientScene::removeRigidbody(IPxrRigidbody *body) {
+  auto it = std::find_if(mBodies.begin(), mBodies.end(),
+                         [=](auto const &b) { return b.get() == body; });
+  if (it == mBodies.end()) {
+    throw std::runtime_error("failed to remove body: invalid body");
   }
-  throw std::runtime_error("failed to remove body: invalid body");
+
+  proto::SceneBatchOp op;
+  op.mutable_remove_body()->set_scene_id(mId);
+  op.mutable_remove_body()->set_body_id((*it)->getId());
+  mRenderer->enqueue(std::move(op));
+
+  mIdSynced = false;
+  mBodies.erase(it);
 }
 
 ClientCamera *ClientScene::addCamera(uint32_t width, uint32_t height, float fovy, float near,
                                      float far, std::string const &shaderDir) {
-  mIdSynced = false;
-  ClientContext context;
-  proto::AddCameraReq req;
-  proto::Id res;
+  rs_id_t id = mRenderer->reserveId();
+
+  proto::SceneBatchOp op;
+  auto req = op.mutable_add_camera();
+  req->set_scene_id(mId);
+  req->set_width(width);
+  req->set_height(height);
+  req->set_fovy(fovy);
+  req->set_near(near);
+  req->set_far(far);
+  req->set_shader(shaderDir);
+  req->set_id(id);
+  mRenderer->enqueue(std::move(op));
 
-  req.set_scene_id(mId);
-  req.set_width(width);
-  req.set_height(height);
-  req.set_fovy(fovy);
-  req.set_near(near);
-  req.set_far(far);
-  req.set_shader(shaderDir);
-
-  Status status = mRenderer->getStub().AddCamera(&context, req, &res);
-  if (status.ok()) {
-    float cx = width / 2.f;
-    float cy = height / 2.f;
-    float fy = width / 2.f / std::tan(fovy / 2.f);
-    float fx = fy;
-    float skew = 0.f;
-    mCameras.push_back(std::make_unique<ClientCamera>(this, res.id(), width, height, cx, cy, fx,
-                                                      fy, near, far, skew));
-
-    return mCameras.back().get();
-  }
-  throw std::runtime_error(status.error_message());
+  mIdSynced = false;
+  float cx = width / 2.f;
+  float cy = height / 2.f;
+  float fy = width / 2.f / std::tan(fovy / 2.f);
+  float fx = fy;
+  float skew = 0.f;
+  mCameras.push_back(
+      std::make_unique<ClientCamera>(this, id, width, height, cx, cy, fx, fy, near, far, skew));
+  return mCameras.back().get();
 };
 
 std::vector<ICamera *> ClientScene::getCameras() {
@@ -363,51 +312,43 @@ std::vector<ICamera *> ClientScene::getCameras() {
 }
 
 void ClientScene::setAmbientLight(std::array<float, 3> const &color) {
-  ClientContext context;
-  proto::IdVec3 req;
-  proto::Empty res;
-
-  req.set_id(mId);
-  req.mutable_data()->set_x(color[0]);
-  req.mutable_data()->set_y(color[1]);
-  req.mutable_data()->set_z(color[2]);
-
-  Status status = mRenderer->getStub().SetAmbientLight(&context, req, &res);
-  if (!status.ok()) {
-    throw std::runtime_error(status.error_message());
-  }
+  proto::SceneBatchOp op;
+  auto req = op.mutable_set_ambient_light();
+  req->set_id(mId);
+  req->mutable_data()->set_x(color[0]);
+  req->mutable_data()->set_y(color[1]);
+  req->mutable_data()->set_z(color[2]);
+  mRenderer->enqueue(std::move(op));
 }
 
 IPointLight *ClientScene::addPointLight(std::array<float, 3> const &position,
                                         std::array<float, 3> const &color, bool enableShadow,
                                         float shadowNear, float shadowFar,
                                         uint32_t shadowMapSize) {
-  ClientContext context;
-  proto::AddPointLightReq req;
-  proto::Id res;
-
-  req.set_scene_id(mId);
-  req.mutable_position()->set_x(position[0]);
-  req.mutable_position()->set_y(position[1]);
-  req.mutable_position()->set_z(position[2]);
-
-  req.mutable_color()->set_x(color[0]);
-  req.mutable_color()->set_y(color[1]);
-  req.mutable_color()->set_z(color[2]);
-
-  req.set_shadow(enableShadow);
-  req.set_shadow_near(shadowNear);
-  req.set_shadow_far(shadowFar);
-  req.set_shadow_map_size(shadowMapSize);
-
-  Status status = mRenderer->getStub().AddPointLight(&context, req, &res);
-  if (status.ok()) {
-    auto light = std::make_unique<ClientPointLight>(res.id());
-    auto result = light.get();
-    mLights.push_back(std::move(light));
-    return result;
-  }
-  throw std::runtime_error(status.error_message());
+  rs_id_t id = mRenderer->reserveId();
+
+  proto::SceneBatchOp op;
+  auto req = op.mutable_add_point_light();
+  req->set_scene_id(mId);
+  req->mutable_position()->set_x(position[0]);
+  req->mutable_position()->set_y(position[1]);
+  req->mutable_position()->set_z(position[2]);
+
+  req->mutable_color()->set_x(color[0]);
+  req->mutable_color()->set_y(color[1]);
+  req->mutable_color()->set_z(color[2]);
+
+  req->set_shadow(enableShadow);
+  req->set_shadow_near(shadowNear);
+  req->set_shadow_far(shadowFar);
+  req->set_shadow_map_size(shadowMapSize);
+  req->set_id(id);
+  mRenderer->enqueue(std::move(op));
+
+  auto light = std::make_unique<ClientPointLight>(id);
+  auto result = light.get();
+  mLights.push_back(std::move(light));
+  return result;
 }
 
 IDirectionalLight *ClientScene::addDirectionalLight(std::array<float, 3> const &direction,
@@ -416,124 +357,207 @@ IDirectionalLight *ClientScene::addDirectionalLight(std::array<float, 3> const &
                                                     std::array<float, 3> const &position,
                                                     float shadowScale, float shadowNear,
                                                     float shadowFar, uint32_t shadowMapSize) {
-  ClientContext context;
-  proto::AddDirectionalLightReq req;
-  proto::Id res;
-
-  req.set_scene_id(mId);
-  req.mutable_direction()->set_x(direction[0]);
-  req.mutable_direction()->set_y(direction[1]);
-  req.mutable_direction()->set_z(direction[2]);
+  rs_id_t id = mRenderer->reserveId();
+
+  proto::SceneBatchOp op;
+  auto req = op.mutable_add_directional_light();
+  req->set_scene_id(mId);
+  req->mutable_direction()->set_x(direction[0]);
+  req->mutable_direction()->set_y(direction[1]);
+  req->mutable_direction()->set_z(direction[2]);
+
+  req->mutable_color()->set_x(color[0]);
+  req->mutable_color()->set_y(color[1]);
+  req->mutable_color()->set_z(color[2]);
+
+  req->mutable_position()->set_x(position[0]);
+  req->mutable_position()->set_y(position[1]);
+  req->mutable_position()->set_z(position[2]);
+
+  req->set_shadow(enableShadow);
+  req->set_shadow_scale(shadowScale);
+  req->set_shadow_near(shadowNear);
+  req->set_shadow_far(shadowFar);
+  req->set_shadow_map_size(shadowMapSize);
+  req->set_id(id);
+  mRenderer->enqueue(std::move(op));
+
+  auto light = std::make_unique<ClientDirectionalLight>(id);
+  auto result = light.get();
+  mLights.push_back(std::move(light));
+  return result;
+}
 
-  req.mutable_color()->set_x(color[0]);
-  req.mutable_color()->set_y(color[1]);
-  req.mutable_color()->set_z(color[2]);
+// size of the shared memory ring of a scene
+static constexpr uint64_t kSharedRingCapacity = 4 << 20;
+// how long to wait for the server before checking the connection
+static constexpr std::chrono::seconds kSharedRingTimeout{1};
+// number of queued calls that triggers sending a batch
+static constexpr int kSceneBatchSize = 256;
+// number of ids reserved from the server at once
+static constexpr uint32_t kIdBlockSize = 1024;
+
+static void packPose(physx::PxTransform const &pose, float *out) {
+  out[0] = pose.p.x;
+  out[1] = pose.p.y;
+  out[2] = pose.p.z;
+  out[3] = pose.q.w;
+  out[4] = pose.q.x;
+  out[5] = pose.q.y;
+  out[6] = pose.q.z;
+}
 
-  req.mutable_position()->set_x(position[0]);
-  req.mutable_position()->set_y(position[1]);
-  req.mutable_position()->set_z(position[2]);
+void ClientScene::updateRender() { streamRender({}); }
 
-  req.set_shadow(enableShadow);
-  req.set_shadow_scale(shadowScale);
-  req.set_shadow_near(shadowNear);
-  req.set_shadow_far(shadowFar);
-  req.set_shadow_map_size(shadowMapSize);
+void ClientScene::updateRenderAndTakePictures(std::vector<ICamera *> const &cameras) {
+  streamRender(cameras);
+}
 
-  Status status = mRenderer->getStub().AddDirectionalLight(&context, req, &res);
-  if (status.ok()) {
-    auto light = std::make_unique<ClientDirectionalLight>(res.id());
-    auto result = light.get();
-    mLights.push_back(std::move(light));
-    return result;
+void ClientScene::openSharedRing() {
+  mSharedRingOpened = true;
+  if (!mRenderer->isSharedMemoryEnabled()) {
+    return;
   }
-  throw std::runtime_error(status.error_message());
-}
 
-void ClientScene::updateRender() {
-  syncId();
+  std::string name = "/sapien_render_" + std::to_string(getpid()) + "_" + std::to_string(mId);
+  try {
+    mSharedRing = SharedFrameRing::create(name, kSharedRingCapacity);
+  } catch (std::runtime_error const &e) {
+    spdlog::get("SAPIEN")->warn("{}, render frames go through gRPC", e.what());
+    return;
+  }
 
   ClientContext context;
-  proto::UpdateRenderReq req;
+  proto::SharedRingReq req;
   proto::Empty res;
-
   req.set_scene_id(mId);
-  for (auto &body : mBodies) {
-    auto &pose = body->getCurrentPose();
-    auto p = req.add_body_poses();
-    p->mutable_p()->set_x(pose.p.x);
-    p->mutable_p()->set_y(pose.p.y);
-    p->mutable_p()->set_z(pose.p.z);
+  req.set_name(name);
+  Status status = mRenderer->getStub().OpenSharedRing(&context, req, &res);
 
-    p->mutable_q()->set_w(pose.q.w);
-    p->mutable_q()->set_x(pose.q.x);
-    p->mutable_q()->set_y(pose.q.y);
-    p->mutable_q()->set_z(pose.q.z);
+  // both sides have mapped the ring or given up, the name is no longer needed
+  mSharedRing->unlink();
+  if (!status.ok()) {
+    spdlog::get("SAPIEN")->info("render server cannot share memory ({}), render frames go "
+                                "through gRPC",
+                                status.error_message());
+    mSharedRing.reset();
   }
+}
 
-  for (auto &cam : mCameras) {
-    auto pose = cam->getPose();
-    auto p = req.add_camera_poses();
-    p->mutable_p()->set_x(pose.p.x);
-    p->mutable_p()->set_y(pose.p.y);
-    p->mutable_p()->set_z(pose.p.z);
+bool ClientScene::sendSharedFrame(PackedFrame &frame) {
+  frame.frame = mSharedFrameCount + 1;
+  if (!mSharedRing->push(frame, kSharedRingTimeout)) {
+    return false;
+  }
+  mSharedFrameCount = frame.frame;
+  uint32_t maxInFlight = mRenderer->getMaxFramesInFlight();
+  if (mSharedFrameCount - mSharedFrameAcked >= maxInFlight) {
+    waitSharedAck(mSharedFrameCount - maxInFlight + 1);
+  }
+  return true;
+}
 
-    p->mutable_q()->set_w(pose.q.w);
-    p->mutable_q()->set_x(pose.q.x);
-    p->mutable_q()->set_y(pose.q.y);
-    p->mutable_q()->set_z(pose.q.z);
+void ClientScene::waitSharedAck(uint64_t frame) {
+  try {
+    while (!mSharedRing->waitAck(frame, kSharedRingTimeout)) {
+      if (!mRenderer->isConnected()) {
+        throw std::runtime_error("failed to render frame: render server is not responding");
+      }
+    }
+  } catch (std::runtime_error const &e) {
+    // the server may or may not have applied the frames in flight
+    if (mSharedRing->isClosed()) {
+      dropSharedRing(e.what());
+    } else {
+      mSharedFrameAcked = mSharedFrameCount;
+      invalidateFrames();
+    }
+    throw;
   }
+  mSharedFrameAcked = frame;
+}
 
-  Status status = mRenderer->getStub().UpdateRender(&context, req, &res);
-  if (!status.ok()) {
-    throw std::runtime_error(status.error_message());
+void ClientScene::dropSharedRing(std::string const &reason) {
+  spdlog::get("SAPIEN")->warn("{}, render frames go through gRPC", reason);
+  mSharedRing.reset();
+  mSharedFrameAcked = mSharedFrameCount;
+  invalidateFrames();
+}
+
+void ClientScene::waitFrames() {
+  if (mSharedRing && mSharedFrameAcked < mSharedFrameCount) {
+    waitSharedAck(mSharedFrameCount);
   }
-};
+}
 
-void ClientScene::updateRenderAndTakePictures(std::vector<ICamera *> const &cameras) {
+void ClientScene::streamRender(std::vector<ICamera *> const &cameras) {
   syncId();
+  // queued calls are applied before the frame
+  mRenderer->flush();
+  if (!mSharedRingOpened) {
+    openSharedRing();
+  }
 
-  ClientContext context;
-  proto::UpdateRenderAndTakePicturesReq req;
-  proto::Empty res;
-
-  req.set_scene_id(mId);
-  for (auto &body : mBodies) {
-    auto &pose = body->getCurrentPose();
-    auto p = req.add_body_poses();
-    p->mutable_p()->set_x(pose.p.x);
-    p->mutable_p()->set_y(pose.p.y);
-    p->mutable_p()->set_z(pose.p.z);
+  PackedFrame frame;
 
-    p->mutable_q()->set_w(pose.q.w);
-    p->mutable_q()->set_x(pose.q.x);
-    p->mutable_q()->set_y(pose.q.y);
-    p->mutable_q()->set_z(pose.q.z);
+  mBodyPoses.resize(mBodies.size() * kPackedPoseSize);
+  for (size_t i = 0; i < mBodies.size(); ++i) {
+    packPose(mBodies[i]->getCurrentPose(), mBodyPoses.data() + i * kPackedPoseSize);
   }
 
-  for (auto &cam : mCameras) {
-    auto pose = cam->getPose();
-    auto p = req.add_camera_poses();
-    p->mutable_p()->set_x(pose.p.x);
-    p->mutable_p()->set_y(pose.p.y);
-    p->mutable_p()->set_z(pose.p.z);
+  encodeBodyPoses(mBodyPoses, mSentBodyPoses, mChangedBodies, mChangedPoses, frame);
 
-    p->mutable_q()->set_w(pose.q.w);
-    p->mutable_q()->set_x(pose.q.x);
-    p->mutable_q()->set_y(pose.q.y);
-    p->mutable_q()->set_z(pose.q.z);
+  mCameraPoses.resize(mCameras.size() * kPackedPoseSize);
+  for (size_t i = 0; i < mCameras.size(); ++i) {
+    packPose(mCameras[i]->getPose(), mCameraPoses.data() + i * kPackedPoseSize);
   }
+  frame.cameraPoses = reinterpret_cast<char const *>(mCameraPoses.data());
+  frame.cameraCount = mCameras.size();
 
+  mPictureCameras.clear();
   for (auto cam : cameras) {
     if (auto c = dynamic_cast<ClientCamera *>(cam)) {
-      req.add_camera_ids(c->getId());
+      mPictureCameras.push_back(c->getId());
     } else {
       throw std::runtime_error("invalid camera");
     }
   }
-  Status status = mRenderer->getStub().UpdateRenderAndTakePictures(&context, req, &res);
-  if (!status.ok()) {
-    throw std::runtime_error(status.error_message());
+  frame.cameraIds = mPictureCameras.data();
+  frame.cameraIdCount = mPictureCameras.size();
+
+  try {
+    // frames too large for the ring go through gRPC, the frames in flight on the other path are
+    // acknowledged before switching so the two paths never reorder
+    bool sent = false;
+    if (mSharedRing) {
+      mRenderer->waitStreamFrames();
+      try {
+        sent = sendSharedFrame(frame);
+      } catch (std::runtime_error const &e) {
+        if (mSharedRing && !mSharedRing->isClosed()) {
+          throw;
+        }
+        // the server dropped the ring, maybe without applying the frames in flight
+        if (mSharedRing) {
+          dropSharedRing(e.what());
+        }
+        frame.full = true;
+        frame.bodyIndices = nullptr;
+        frame.bodyIndexCount = 0;
+        frame.bodyPoses = reinterpret_cast<char const *>(mBodyPoses.data());
+        frame.bodyCount = mBodies.size();
+      }
+    }
+    if (!sent) {
+      waitFrames();
+      mRenderer->sendFrame(mId, frame);
+    }
+  } catch (std::runtime_error const &) {
+    // the server may or may not have applied the frame
+    invalidateFrames();
+    throw;
   }
+  mSentBodyPoses.swap(mBodyPoses);
 }
 
 void ClientScene::destroy() { getRenderer()->removeScene(this); }
@@ -542,35 +566,204 @@ void ClientScene::syncId() {
   if (mIdSynced) {
     return;
   }
-  ClientContext context;
-  proto::EntityOrderReq req;
-  proto::Empty res;
-
-  req.set_scene_id(mId);
+  proto::SceneBatchOp op;
+  auto req = op.mutable_set_entity_order();
+  req->set_scene_id(mId);
   for (auto &body : mBodies) {
-    req.add_body_ids(body->getId());
+    req->add_body_ids(body->getId());
   }
-
   for (auto &cam : mCameras) {
-    req.add_camera_ids(cam->getId());
+    req->add_camera_ids(cam->getId());
   }
+  mRenderer->enqueue(std::move(op));
 
-  Status status = mRenderer->getStub().SetEntityOrder(&context, req, &res);
-  if (!status.ok()) {
-    throw std::runtime_error(status.error_message());
-  }
   mIdSynced = true;
+  invalidateFrames();
 }
 
 //========== Renderer ==========//
-ClientRenderer::ClientRenderer(std::string const &address, uint64_t processIndex)
-    : mProcessIndex(processIndex) {
+ClientRenderer::ClientRenderer(std::string const &address, uint64_t processIndex,
+                               bool sharedMemory, uint32_t maxFramesInFlight)
+    : mProcessIndex(processIndex), mSharedMemory(sharedMemory),
+      mMaxFramesInFlight(maxFramesInFlight) {
+  if (maxFramesInFlight == 0) {
+    throw std::runtime_error("failed to create render client: max frames in flight must be "
+                             "positive");
+  }
   grpc::ChannelArguments args;
   args.SetLoadBalancingPolicyName("round_robin");
   mChannel = grpc::CreateCustomChannel(address, grpc::InsecureChannelCredentials(), args);
   mStub = proto::RenderService::NewStub(mChannel);
 }
 
+ClientRenderer::~ClientRenderer() {
+  try {
+    synchronize();
+  } catch (std::runtime_error const &e) {
+    spdlog::get("SAPIEN")->error("failed to finish render calls: {}", e.what());
+  }
+  closeStream();
+
+  mBatchQueue.Shutdown();
+  void *tag;
+  bool ok;
+  while (mBatchQueue.Next(&tag, &ok)) {
+  }
+}
+
+rs_id_t ClientRenderer::reserveId() {
+  std::lock_guard lock(mBatchMutex);
+  if (mNextId == mEndId) {
+    ClientContext context;
+    proto::Uint32 req;
+    proto::Id res;
+    req.set_value(kIdBlockSize);
+    Status status = mStub->ReserveIds(&context, req, &res);
+    if (!status.ok()) {
+      throw std::runtime_error(status.error_message());
+    }
+    mNextId = res.id();
+    mEndId = mNextId + kIdBlockSize;
+  }
+  return mNextId++;
+}
+
+void ClientRenderer::enqueue(proto::SceneBatchOp &&op) {
+  std::lock_guard lock(mBatchMutex);
+  *mBatch.add_ops() = std::move(op);
+  if (mBatch.ops_size() >= kSceneBatchSize) {
+    sendBatch();
+  }
+}
+
+void ClientRenderer::flush() {
+  std::lock_guard lock(mBatchMutex);
+  sendBatch();
+  waitBatch();
+}
+
+void ClientRenderer::synchronize() {
+  for (auto &scene : mScenes) {
+    scene->waitFrames();
+  }
+  waitStreamFrames();
+  flush();
+}
+
+void ClientRenderer::sendBatch() {
+  if (mBatch.ops_size() == 0) {
+    return;
+  }
+  waitBatch();
+  // the server applies frames and batches on different threads
+  for (auto &scene : mScenes) {
+    scene->waitFrames();
+  }
+  waitStreamFrames();
+
+  mBatchCall = std::make_unique<SceneBatchCall>();
+  mBatchCall->req.Swap(&mBatch);
+  mBatchCall->reader =
+      mStub->PrepareAsyncBuildSceneBatch(&mBatchCall->context, mBatchCall->req, &mBatchQueue);
+  mBatchCall->reader->StartCall();
+  mBatchCall->reader->Finish(&mBatchCall->res, &mBatchCall->status, mBatchCall.get());
+}
+
+void ClientRenderer::waitBatch() {
+  if (!mBatchCall) {
+    return;
+  }
+  void *tag;
+  bool ok;
+  mBatchQueue.Next(&tag, &ok);
+  auto call = std::move(mBatchCall);
+  if (!call->status.ok()) {
+    throw std::runtime_error(call->status.error_message());
+  }
+}
+
+bool ClientRenderer::isConnected() const {
+  auto state = mChannel->GetState(true);
+  return state != GRPC_CHANNEL_TRANSIENT_FAILURE && state != GRPC_CHANNEL_SHUTDOWN;
+}
+
+void ClientRenderer::sendFrame(rs_id_t sceneId, PackedFrame const &frame) {
+  constexpr size_t poseBytes = kPackedPoseSize * sizeof(float);
+
+  proto::RenderFrame msg;
+  msg.set_scene_id(sceneId);
+  msg.set_full(frame.full);
+  msg.mutable_body_indices()->Add(frame.bodyIndices, frame.bodyIndices + frame.bodyIndexCount);
+  msg.set_body_poses(frame.bodyPoses, frame.bodyCount * poseBytes);
+  msg.set_camera_poses(frame.cameraPoses, frame.cameraCount * poseBytes);
+  msg.mutable_camera_ids()->Add(frame.cameraIds, frame.cameraIds + frame.cameraIdCount);
+
+  std::lock_guard lock(mStreamMutex);
+  if (!mStream) {
+    mStreamContext = std::make_unique<ClientContext>();
+    mStream = mStub->StreamRender(mStreamContext.get());
+  }
+  msg.set_frame(++mFrameCount);
+
+  if (!mStream->Write(msg)) {
+    failStream();
+  }
+  ++mStreamFramesInFlight;
+  while (mStreamFramesInFlight >= mMaxFramesInFlight) {
+    readAck();
+  }
+}
+
+void ClientRenderer::waitStreamFrames() {
+  std::lock_guard lock(mStreamMutex);
+  while (mStreamFramesInFlight) {
+    readAck();
+  }
+}
+
+void ClientRenderer::readAck() {
+  proto::RenderFrameAck ack;
+  if (!mStream->Read(&ack)) {
+    failStream();
+  }
+  --mStreamFramesInFlight;
+}
+
+void ClientRenderer::failStream() {
+  // the server ended the stream, report its status and reconnect on the next frame
+  proto::RenderFrameAck ack;
+  while (mStream->Read(&ack)) {
+  }
+  Status status = mStream->Finish();
+  mStream.reset();
+  mStreamContext.reset();
+
+  // the frames in flight may or may not have been applied
+  mStreamFramesInFlight = 0;
+  for (auto &scene : mScenes) {
+    scene->invalidateFrames();
+  }
+  throw std::runtime_error(status.ok() ? "render stream closed by server"
+                                       : status.error_message());
+}
+
+void ClientRenderer::closeStream() {
+  std::lock_guard lock(mStreamMutex);
+  if (mStream) {
+    mStream->WritesDone();
+    proto::RenderFrameAck ack;
+    while (mStream->Read(&ack)) {
+    }
+    mStreamFramesInFlight = 0;
+    Status status = mStream->Finish();
+    if (!status.ok()) {
+      spdlog::get("SAPIEN")->error("close render stream failed: {}", status.error_message());
+    }
+    mStream.reset();
+    mStreamContext.reset();
+  }
+}
+
 ClientScene *ClientRenderer::createScene(std::string const &name) {
   ClientContext context;
   proto::Index req;
@@ -588,6 +781,8 @@ ClientScene *ClientRenderer::createScene(std::string const &name) {
 
 void ClientRenderer::removeScene(IPxrScene *scene) {
   if (ClientScene *clientScene = dynamic_cast<ClientScene *>(scene)) {
+    synchronize();
+
     ClientContext context;
     proto::Id req;
     proto::Empty res;
@@ -603,16 +798,13 @@ void ClientRenderer::removeScene(IPxrScene *scene) {
 }
 
 std::shared_ptr<IPxrMaterial> ClientRenderer::createMaterial() {
-  ClientContext context;
-  proto::Empty req;
-  proto::Id res;
+  rs_id_t id = reserveId();
 
-  Status status = mStub->CreateMaterial(&context, req, &res);
-  if (status.ok()) {
-    auto mat = std::make_shared<ClientMaterial>(shared_from_this(), res.id());
-    return mat;
-  }
-  throw std::runtime_error(status.error_message());
+  proto::SceneBatchOp op;
+  op.mutable_create_material()->set_id(id);
+  enqueue(std::move(op));
+
+  return std::make_shared<ClientMaterial>(shared_from_this(), id);
 };
 
 } // namespace server
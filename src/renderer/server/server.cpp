@@ -1,5 +1,6 @@
 #include "sapien/renderer/server/server.h"
 #include <algorithm>
+#include <cstring>
 #include <easy/profiler.h>
 #include <spdlog/spdlog.h>
 #include <string>
@@ -122,17 +123,19 @@ Status RenderServiceImpl::CreateMaterial(ServerContext *c, const proto::Empty *r
                                          proto::Id *res) {
   log::info("CreateMaterial");
   rs_id_t id = generateId();
-
-  auto mat = std::make_shared<svulkan2::resource::SVMetallicMaterial>();
-  mat->setBaseColor({1.0, 1.0, 1.0, 1.0});
-
-  mMaterialMap.set(id, mat);
+  createMaterial(id);
 
   res->set_id(id);
   log::info("Material Created {}", res->id());
   return Status::OK;
 }
 
+void RenderServiceImpl::createMaterial(rs_id_t id) {
+  auto mat = std::make_shared<svulkan2::resource::SVMetallicMaterial>();
+  mat->setBaseColor({1.0, 1.0, 1.0, 1.0});
+  mMaterialMap.set(id, mat);
+}
+
 Status RenderServiceImpl::RemoveMaterial(ServerContext *c, const proto::Id *req,
                                          proto::Empty *res) {
   log::info("RemoveMaterial {}", req->id());
@@ -144,7 +147,7 @@ Status RenderServiceImpl::RemoveMaterial(ServerContext *c, const proto::Id *req,
 Status RenderServiceImpl::AddBodyMesh(ServerContext *c, const proto::AddBodyMeshReq *req,
                                       proto::Id *res) {
   log::info("AddBodyMesh");
-  rs_id_t id = generateId();
+  rs_id_t id = req->id() ? req->id() : generateId();
 
   auto info = mSceneMap.get(req->scene_id());
   svulkan2::scene::Object *object =
@@ -171,7 +174,7 @@ Status RenderServiceImpl::AddBodyMesh(ServerContext *c, const proto::AddBodyMesh
 Status RenderServiceImpl::AddBodyPrimitive(ServerContext *c, const proto::AddBodyPrimitiveReq *req,
                                            proto::Id *res) {
   log::info("AddBodyPrimitive");
-  rs_id_t id = generateId();
+  rs_id_t id = req->id() ? req->id() : generateId();
   rs_id_t mat_id = req->material();
 
   glm::vec3 scale{req->scale().x(), req->scale().y(), req->scale().z()};
@@ -250,7 +253,7 @@ Status RenderServiceImpl::AddCamera(ServerContext *c, const proto::AddCameraReq
   log::info("AddCamera");
   try {
 
-    rs_id_t id = generateId();
+    rs_id_t id = req->id() ? req->id() : generateId();
 
     auto sceneInfo = mSceneMap.get(req->scene_id());
 
@@ -300,7 +303,7 @@ Status RenderServiceImpl::SetAmbientLight(ServerContext *c, const proto::IdVec3
 
 Status RenderServiceImpl::AddPointLight(ServerContext *c, const proto::AddPointLightReq *req,
                                         proto::Id *res) {
-  rs_id_t id = generateId(); // TODO: implement remove light
+  rs_id_t id = req->id() ? req->id() : generateId(); // TODO: implement remove light
   auto info = mSceneMap.get(req->scene_id());
   auto &light = info->scene->addPointLight();
 
@@ -318,7 +321,7 @@ Status RenderServiceImpl::AddPointLight(ServerContext *c, const proto::AddPointL
 Status RenderServiceImpl::AddDirectionalLight(ServerContext *c,
                                               const proto::AddDirectionalLightReq *req,
                                               proto::Id *res) {
-  rs_id_t id = generateId(); // TODO: implement remove light
+  rs_id_t id = req->id() ? req->id() : generateId(); // TODO: implement remove light
 
   auto info = mSceneMap.get(req->scene_id());
   auto &light = info->scene->addDirectionalLight();
@@ -414,41 +417,250 @@ Status RenderServiceImpl::UpdateRenderAndTakePictures(
   sceneInfo->scene->getRootNode().updateGlobalModelMatrixRecursive(); // TODO: check this
 
   for (int i = 0; i < req->camera_ids_size(); ++i) {
-    uint64_t camera_id = req->camera_ids(i);
-    auto camInfo = sceneInfo->cameraMap.at(camera_id);
-    camInfo->frameCounter++;
-
-    sceneInfo->threadRunner->submit(
-        [context = mContext, sem = camInfo->semaphore.get(), cb = camInfo->commandBuffer.get(),
-         renderer = camInfo->renderer.get(), cam = camInfo->camera, fillInfo = camInfo->fillInfo,
-         frame = camInfo->frameCounter]() {
-          uint64_t waitFrame = frame - 1;
-          auto result = context->getDevice().waitSemaphores(
-              vk::SemaphoreWaitInfo({}, sem, waitFrame), UINT64_MAX);
-          if (result != vk::Result::eSuccess) {
-            throw std::runtime_error("take picture failed: wait failed");
-          }
-          cb.reset();
-          cb.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
-          try {
-            renderer->render(*cam, {}, {}, {}, {});
-          } catch (std::exception const &e) {
-            log::critical("rendering failed");
-          }
-
-          for (auto &entry : fillInfo) {
-            auto [name, buffer, offset] = entry;
-            auto target = renderer->getRenderTarget(name);
-            auto extent = target->getImage().getExtent();
-            vk::Format format = target->getFormat();
-            vk::DeviceSize size =
-                extent.width * extent.height * extent.depth * svulkan2::getFormatSize(format);
-            target->getImage().recordCopyToBuffer(cb, buffer, offset, size, vk::Offset3D{0, 0, 0},
-                                                  extent);
-          }
-          cb.end();
-          context->getQueue().submit(cb, {}, {}, {}, sem, frame, {});
-        });
+    takePicture(*sceneInfo, req->camera_ids(i));
+  }
+  return Status::OK;
+}
+
+void RenderServiceImpl::takePicture(SceneInfo &info, rs_id_t cameraId) {
+  auto camInfo = info.cameraMap.at(cameraId);
+  camInfo->frameCounter++;
+
+  info.threadRunner->submit(
+      [context = mContext, sem = camInfo->semaphore.get(), cb = camInfo->commandBuffer.get(),
+       renderer = camInfo->renderer.get(), cam = camInfo->camera, fillInfo = camInfo->fillInfo,
+       frame = camInfo->frameCounter]() {
+        uint64_t waitFrame = frame - 1;
+        auto result = context->getDevice().waitSemaphores(
+            vk::SemaphoreWaitInfo({}, sem, waitFrame), UINT64_MAX);
+        if (result != vk::Result::eSuccess) {
+          throw std::runtime_error("take picture failed: wait failed");
+        }
+        cb.reset();
+        cb.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+        try {
+          renderer->render(*cam, {}, {}, {}, {});
+        } catch (std::exception const &e) {
+          log::critical("rendering failed");
+        }
+
+        for (auto &entry : fillInfo) {
+          auto [name, buffer, offset] = entry;
+          auto target = renderer->getRenderTarget(name);
+          auto extent = target->getImage().getExtent();
+          vk::Format format = target->getFormat();
+          vk::DeviceSize size =
+              extent.width * extent.height * extent.depth * svulkan2::getFormatSize(format);
+          target->getImage().recordCopyToBuffer(cb, buffer, offset, size, vk::Offset3D{0, 0, 0},
+                                                extent);
+        }
+        cb.end();
+        context->getQueue().submit(cb, {}, {}, {}, sem, frame, {});
+      });
+}
+
+static void setPackedPose(svulkan2::scene::Node &node, char const *data) {
+  float pose[kPackedPoseSize];
+  std::memcpy(pose, data, sizeof(pose));
+  glm::vec3 p{pose[0], pose[1], pose[2]};
+  glm::quat q{pose[3], pose[4], pose[5], pose[6]};
+  node.setPosition(p);
+  node.setRotation(q);
+}
+
+Status RenderServiceImpl::renderFrame(SceneInfo &info, PackedFrame const &frame) {
+  constexpr size_t poseBytes = kPackedPoseSize * sizeof(float);
+
+  // a rejected frame changes nothing
+  auto error = checkBodyPoses(frame, info.orderedObjects.size());
+  if (!error.empty()) {
+    return Status(grpc::StatusCode::INVALID_ARGUMENT, error);
+  }
+  if (frame.cameraCount != info.orderedCameras.size()) {
+    return Status(grpc::StatusCode::INVALID_ARGUMENT, "render frame: invalid camera poses");
+  }
+  for (uint32_t i = 0; i < frame.cameraIdCount; ++i) {
+    if (!info.cameraMap.contains(frame.cameraIds[i])) {
+      return Status(grpc::StatusCode::INVALID_ARGUMENT, "render frame: invalid camera");
+    }
+  }
+  for (uint32_t i = 0; i < frame.bodyCount; ++i) {
+    setPackedPose(*info.orderedObjects[getBodyIndex(frame, i)], frame.bodyPoses + i * poseBytes);
+  }
+  for (uint32_t i = 0; i < frame.cameraCount; ++i) {
+    setPackedPose(*info.orderedCameras[i], frame.cameraPoses + i * poseBytes);
+  }
+
+  info.scene->getRootNode().updateGlobalModelMatrixRecursive();
+
+  for (uint32_t i = 0; i < frame.cameraIdCount; ++i) {
+    takePicture(info, frame.cameraIds[i]);
+  }
+  return Status::OK;
+}
+
+Status RenderServiceImpl::StreamRender(
+    ServerContext *c,
+    grpc::ServerReaderWriter<proto::RenderFrameAck, proto::RenderFrame> *stream) {
+  constexpr size_t poseBytes = kPackedPoseSize * sizeof(float);
+
+  proto::RenderFrame msg;
+  proto::RenderFrameAck ack;
+  while (stream->Read(&msg)) {
+    EASY_BLOCK("Render Frame");
+    auto info = mSceneMap.get(msg.scene_id(), nullptr);
+    if (!info) {
+      return Status(grpc::StatusCode::NOT_FOUND, "render frame: invalid scene");
+    }
+    if (msg.body_poses().size() % poseBytes || msg.camera_poses().size() % poseBytes) {
+      return Status(grpc::StatusCode::INVALID_ARGUMENT, "render frame: invalid poses");
+    }
+
+    PackedFrame frame;
+    frame.frame = msg.frame();
+    frame.full = msg.full();
+    frame.bodyIndices = msg.body_indices().data();
+    frame.bodyIndexCount = msg.body_indices_size();
+    frame.bodyPoses = msg.body_poses().data();
+    frame.bodyCount = msg.body_poses().size() / poseBytes;
+    frame.cameraPoses = msg.camera_poses().data();
+    frame.cameraCount = msg.camera_poses().size() / poseBytes;
+    frame.cameraIds = reinterpret_cast<uint64_t const *>(msg.camera_ids().data());
+    frame.cameraIdCount = msg.camera_ids_size();
+
+    Status status = renderFrame(*info, frame);
+    if (!status.ok()) {
+      return status;
+    }
+    ack.set_frame(msg.frame());
+    if (!stream->Write(ack)) {
+      break;
+    }
+  }
+  return Status::OK;
+}
+
+Status RenderServiceImpl::OpenSharedRing(ServerContext *c, const proto::SharedRingReq *req,
+                                         proto::Empty *res) {
+  auto info = mSceneMap.get(req->scene_id(), nullptr);
+  if (!info) {
+    return Status(grpc::StatusCode::NOT_FOUND, "open shared ring failed: invalid scene");
+  }
+  if (info->ring) {
+    return Status(grpc::StatusCode::ALREADY_EXISTS, "open shared ring failed: ring exists");
+  }
+  try {
+    info->ring = SharedFrameRing::open(req->name());
+  } catch (std::runtime_error const &e) {
+    // usually the client is on another host
+    return Status(grpc::StatusCode::UNAVAILABLE, e.what());
+  }
+  info->ringThread = std::thread(&RenderServiceImpl::runSharedRing, this, info.get());
+  return Status::OK;
+}
+
+void RenderServiceImpl::runSharedRing(SceneInfo *info) {
+  PackedFrame frame;
+  while (!info->ring->isClosed()) {
+    try {
+      if (!info->ring->pop(frame, std::chrono::milliseconds(100))) {
+        continue;
+      }
+    } catch (std::runtime_error const &e) {
+      // the ring is closed, the client sends the next frames through gRPC
+      log::warn("{}, shared memory ring of scene {} dropped", e.what(), info->sceneIndex);
+      return;
+    }
+    EASY_BLOCK("Render Frame");
+    Status status = renderFrame(*info, frame);
+    info->ring->release(status.error_message());
+  }
+}
+
+Status RenderServiceImpl::ReserveIds(ServerContext *c, const proto::Uint32 *req, proto::Id *res) {
+  res->set_id(mIdGenerator.fetch_add(req->value()));
+  return Status::OK;
+}
+
+Status RenderServiceImpl::BuildSceneBatch(ServerContext *c, const proto::SceneBatchReq *req,
+                                          proto::Empty *res) {
+  EASY_FUNCTION();
+  proto::Id id;
+  proto::Empty empty;
+
+  for (int i = 0; i < req->ops_size(); ++i) {
+    auto const &op = req->ops(i);
+    Status status;
+    try {
+      switch (op.op_case()) {
+      case proto::SceneBatchOp::kCreateMaterial:
+        createMaterial(op.create_material().id());
+        break;
+      case proto::SceneBatchOp::kRemoveMaterial:
+        status = RemoveMaterial(c, &op.remove_material(), &empty);
+        break;
+      case proto::SceneBatchOp::kSetBaseColor:
+        status = SetBaseColor(c, &op.set_base_color(), &empty);
+        break;
+      case proto::SceneBatchOp::kSetRoughness:
+        status = SetRoughness(c, &op.set_roughness(), &empty);
+        break;
+      case proto::SceneBatchOp::kSetSpecular:
+        status = SetSpecular(c, &op.set_specular(), &empty);
+        break;
+      case proto::SceneBatchOp::kSetMetallic:
+        status = SetMetallic(c, &op.set_metallic(), &empty);
+        break;
+      case proto::SceneBatchOp::kAddBodyMesh:
+        status = AddBodyMesh(c, &op.add_body_mesh(), &id);
+        break;
+      case proto::SceneBatchOp::kAddBodyPrimitive:
+        status = AddBodyPrimitive(c, &op.add_body_primitive(), &id);
+        break;
+      case proto::SceneBatchOp::kRemoveBody:
+        status = RemoveBody(c, &op.remove_body(), &empty);
+        break;
+      case proto::SceneBatchOp::kAddCamera:
+        status = AddCamera(c, &op.add_camera(), &id);
+        break;
+      case proto::SceneBatchOp::kSetAmbientLight:
+        status = SetAmbientLight(c, &op.set_ambient_light(), &empty);
+        break;
+      case proto::SceneBatchOp::kAddPointLight:
+        status = AddPointLight(c, &op.add_point_light(), &id);
+        break;
+      case proto::SceneBatchOp::kAddDirectionalLight:
+        status = AddDirectionalLight(c, &op.add_directional_light(), &id);
+        break;
+      case proto::SceneBatchOp::kSetEntityOrder:
+        status = SetEntityOrder(c, &op.set_entity_order(), &empty);
+        break;
+      case proto::SceneBatchOp::kSetUniqueId:
+        status = SetUniqueId(c, &op.set_unique_id(), &empty);
+        break;
+      case proto::SceneBatchOp::kSetSegmentationId:
+        status = SetSegmentationId(c, &op.set_segmentation_id(), &empty);
+        break;
+      case proto::SceneBatchOp::kSetVisibility:
+        status = SetVisibility(c, &op.set_visibility(), &empty);
+        break;
+      case proto::SceneBatchOp::kTakePicture:
+        status = TakePicture(c, &op.take_picture(), &empty);
+        break;
+      case proto::SceneBatchOp::kSetCameraParameters:
+        status = SetCameraParameters(c, &op.set_camera_parameters(), &empty);
+        break;
+      default:
+        status = Status(grpc::StatusCode::INVALID_ARGUMENT, "unknown operation");
+      }
+    } catch (std::exception const &e) {
+      status = Status(grpc::StatusCode::INTERNAL, e.what());
+    }
+    // later operations may depend on the failed one, stop here
+    if (!status.ok()) {
+      return Status(status.error_code(), "scene batch failed at operation " + std::to_string(i) +
+                                             ": " + status.error_message());
+    }
   }
   return Status::OK;
 }
@@ -0,0 +1,449 @@
+#include "sapien/renderer/server/shared_memory.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace sapien {
+namespace Renderer {
+namespace server {
+
+static constexpr uint32_t kRingMagic = 0x474e5253; // SRNG
+static constexpr uint32_t kRingVersion = 1;
+
+// number of checks before a waiter goes to sleep
+static constexpr int kSpinCount = 1024;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+struct SharedRingHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t capacity;
+
+  alignas(64) std::atomic<uint64_t> writeOffset;
+  alignas(64) std::atomic<uint64_t> readOffset;
+  std::atomic<uint64_t> ackedFrame;
+  std::atomic<uint32_t> rejected;
+  std::atomic<uint32_t> closed;
+  char error[256];
+
+  // rung by the producer after a write, and by the consumer after a release
+  alignas(64) SharedDoorbell frameBell;
+  alignas(64) SharedDoorbell ackBell;
+};
+
+enum RecordKind : uint32_t { ePadding = 0, eFrame = 1 };
+
+// a frame record is followed by body indices, body poses, camera poses and camera ids,
+// each section padded to 8 bytes; a padding record only has size and kind
+struct RecordHeader {
+  uint32_t size;
+  uint32_t kind;
+  uint64_t frame;
+  uint32_t full;
+  uint32_t bodyIndexCount;
+  uint32_t bodyCount;
+  uint32_t cameraCount;
+  uint32_t cameraIdCount;
+  uint32_t reserved;
+};
+static_assert(sizeof(RecordHeader) % 8 == 0);
+
+static constexpr uint64_t align8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+static constexpr uint64_t kRingOffset = (sizeof(SharedRingHeader) + 63) & ~uint64_t(63);
+static constexpr uint64_t kPoseBytes = kPackedPoseSize * sizeof(float);
+
+static void futexWait(std::atomic<uint32_t> *word, uint32_t expected,
+                      std::chrono::microseconds timeout) {
+#ifdef __linux__
+  timespec ts{static_cast<time_t>(timeout.count() / 1000000),
+              static_cast<long>(timeout.count() % 1000000) * 1000};
+  // not FUTEX_PRIVATE, the word is shared between processes
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+#else
+  std::this_thread::sleep_for(std::min(timeout, std::chrono::microseconds(50)));
+#endif
+}
+
+static void futexWake(std::atomic<uint32_t> *word) {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#endif
+}
+
+void encodeBodyPoses(std::vector<float> const &poses, std::vector<float> const &sentPoses,
+                     std::vector<uint32_t> &changedIndices, std::vector<float> &changedPoses,
+                     PackedFrame &frame) {
+  uint32_t count = poses.size() / kPackedPoseSize;
+  changedIndices.clear();
+  changedPoses.clear();
+  frame.full = sentPoses.size() != poses.size();
+  if (frame.full) {
+    frame.bodyIndices = nullptr;
+    frame.bodyIndexCount = 0;
+    frame.bodyPoses = reinterpret_cast<char const *>(poses.data());
+    frame.bodyCount = count;
+    return;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    float const *pose = poses.data() + i * kPackedPoseSize;
+    if (std::memcmp(pose, sentPoses.data() + i * kPackedPoseSize, kPoseBytes)) {
+      changedIndices.push_back(i);
+      changedPoses.insert(changedPoses.end(), pose, pose + kPackedPoseSize);
+    }
+  }
+  frame.bodyIndices = changedIndices.data();
+  frame.bodyIndexCount = changedIndices.size();
+  frame.bodyPoses = reinterpret_cast<char const *>(changedPoses.data());
+  frame.bodyCount = changedIndices.size();
+}
+
+std::string checkBodyPoses(PackedFrame const &frame, uint32_t bodyCount) {
+  if (frame.full ? frame.bodyCount != bodyCount : frame.bodyCount != frame.bodyIndexCount) {
+    return "render frame: invalid body poses";
+  }
+  if (!frame.full) {
+    for (uint32_t i = 0; i < frame.bodyIndexCount; ++i) {
+      if (frame.bodyIndices[i] >= bodyCount) {
+        return "render frame: invalid body index";
+      }
+    }
+  }
+  return "";
+}
+
+void SharedDoorbell::ring() {
+  sequence.fetch_add(1, std::memory_order_seq_cst);
+  if (waiting.load(std::memory_order_seq_cst)) {
+    futexWake(&sequence);
+  }
+}
+
+bool SharedDoorbell::wait(uint32_t seen, std::chrono::microseconds timeout) {
+  for (int i = 0; i < kSpinCount; ++i) {
+    if (sequence.load(std::memory_order_acquire) != seen) {
+      return true;
+    }
+  }
+  // pairs with ring: either the ringer sees the waiter or the waiter sees the new sequence
+  waiting.fetch_add(1, std::memory_order_seq_cst);
+  if (sequence.load(std::memory_order_seq_cst) == seen) {
+    futexWait(&sequence, seen, timeout);
+  }
+  waiting.fetch_sub(1, std::memory_order_relaxed);
+  return sequence.load(std::memory_order_acquire) != seen;
+}
+
+SharedFrameRing::SharedFrameRing(std::string name, int fd, void *data, size_t size)
+    : mName(std::move(name)), mFd(fd), mData(data), mSize(size),
+      mHeader(static_cast<SharedRingHeader *>(data)),
+      mRing(static_cast<char *>(data) + kRingOffset), mCapacity(size - kRingOffset) {}
+
+std::unique_ptr<SharedFrameRing> SharedFrameRing::create(std::string const &name,
+                                                         uint64_t capacity) {
+  capacity = align8(capacity);
+  size_t size = kRingOffset + capacity;
+
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    throw std::runtime_error("failed to create shared memory " + name + ": " +
+                             std::strerror(errno));
+  }
+  if (ftruncate(fd, size) != 0) {
+    int error = errno;
+    ::close(fd);
+    shm_unlink(name.c_str());
+    throw std::runtime_error("failed to create shared memory " + name + ": " +
+                             std::strerror(error));
+  }
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    int error = errno;
+    ::close(fd);
+    shm_unlink(name.c_str());
+    throw std::runtime_error("failed to map shared memory " + name + ": " +
+                             std::strerror(error));
+  }
+
+  auto header = new (data) SharedRingHeader{};
+  header->magic = kRingMagic;
+  header->version = kRingVersion;
+  header->capacity = capacity;
+  return std::unique_ptr<SharedFrameRing>(new SharedFrameRing(name, fd, data, size));
+}
+
+std::unique_ptr<SharedFrameRing> SharedFrameRing::open(std::string const &name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    throw std::runtime_error("failed to open shared memory " + name + ": " +
+                             std::strerror(errno));
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < kRingOffset) {
+    ::close(fd);
+    throw std::runtime_error("failed to open shared memory " + name + ": invalid size");
+  }
+  size_t size = st.st_size;
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    int error = errno;
+    ::close(fd);
+    throw std::runtime_error("failed to map shared memory " + name + ": " +
+                             std::strerror(error));
+  }
+
+  auto header = static_cast<SharedRingHeader *>(data);
+  if (header->magic != kRingMagic || header->version != kRingVersion ||
+      kRingOffset + header->capacity != size) {
+    munmap(data, size);
+    ::close(fd);
+    throw std::runtime_error("failed to open shared memory " + name + ": invalid ring");
+  }
+  return std::unique_ptr<SharedFrameRing>(new SharedFrameRing(name, fd, data, size));
+}
+
+SharedFrameRing::~SharedFrameRing() {
+  munmap(mData, mSize);
+  ::close(mFd);
+}
+
+void SharedFrameRing::unlink() { shm_unlink(mName.c_str()); }
+
+uint64_t SharedFrameRing::getDataOffset() { return kRingOffset; }
+
+bool SharedFrameRing::push(PackedFrame const &frame, std::chrono::microseconds timeout) {
+  uint64_t indexBytes = align8(uint64_t(frame.bodyIndexCount) * sizeof(uint32_t));
+  uint64_t bodyBytes = align8(frame.bodyCount * kPoseBytes);
+  uint64_t cameraBytes = align8(frame.cameraCount * kPoseBytes);
+  uint64_t idBytes = uint64_t(frame.cameraIdCount) * sizeof(uint64_t);
+  uint64_t size = sizeof(RecordHeader) + indexBytes + bodyBytes + cameraBytes + idBytes;
+
+  uint64_t capacity = mCapacity;
+  if (size > capacity || size > UINT32_MAX) {
+    return false;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  auto waitForRoom = [&](uint64_t end) {
+    while (true) {
+      uint32_t seen = mHeader->ackBell.sequence.load(std::memory_order_acquire);
+      if (end - mHeader->readOffset.load(std::memory_order_acquire) <= capacity) {
+        return;
+      }
+      if (isClosed()) {
+        throw std::runtime_error("failed to send render frame: shared memory is closed");
+      }
+      auto now = std::chrono::steady_clock::now();
+      if (now >= deadline) {
+        throw std::runtime_error("failed to send render frame: shared memory is full");
+      }
+      mHeader->ackBell.wait(
+          seen, std::chrono::duration_cast<std::chrono::microseconds>(deadline - now));
+    }
+  };
+
+  // only the producer moves the write offset
+  uint64_t write = mHeader->writeOffset.load(std::memory_order_relaxed);
+  uint64_t pos = write % capacity;
+  if (pos + size > capacity) {
+    // skip the end of the ring, published first so the consumer can free it
+    uint64_t padding = capacity - pos;
+    waitForRoom(write + padding);
+    uint32_t record[2] = {static_cast<uint32_t>(padding), ePadding};
+    std::memcpy(mRing + pos, record, sizeof(record));
+    write += padding;
+    pos = 0;
+    mHeader->writeOffset.store(write, std::memory_order_release);
+    mHeader->frameBell.ring();
+  }
+  waitForRoom(write + size);
+
+  auto record = reinterpret_cast<RecordHeader *>(mRing + pos);
+  record->size = static_cast<uint32_t>(size);
+  record->kind = eFrame;
+  record->frame = frame.frame;
+  record->full = frame.full;
+  record->bodyIndexCount = frame.bodyIndexCount;
+  record->bodyCount = frame.bodyCount;
+  record->cameraCount = frame.cameraCount;
+  record->cameraIdCount = frame.cameraIdCount;
+  record->reserved = 0;
+
+  char *data = reinterpret_cast<char *>(record + 1);
+  if (frame.bodyIndexCount) {
+    std::memcpy(data, frame.bodyIndices, frame.bodyIndexCount * sizeof(uint32_t));
+  }
+  data += indexBytes;
+  if (frame.bodyCount) {
+    std::memcpy(data, frame.bodyPoses, frame.bodyCount * kPoseBytes);
+  }
+  data += bodyBytes;
+  if (frame.cameraCount) {
+    std::memcpy(data, frame.cameraPoses, frame.cameraCount * kPoseBytes);
+  }
+  data += cameraBytes;
+  if (frame.cameraIdCount) {
+    std::memcpy(data, frame.cameraIds, idBytes);
+  }
+
+  mHeader->writeOffset.store(write + size, std::memory_order_release);
+  mHeader->frameBell.ring();
+  return true;
+}
+
+bool SharedFrameRing::waitAck(uint64_t frame, std::chrono::microseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (true) {
+    uint32_t seen = mHeader->ackBell.sequence.load(std::memory_order_acquire);
+    // the rejection is published before the acknowledgement
+    bool acked = mHeader->ackedFrame.load(std::memory_order_acquire) >= frame;
+    if (mHeader->rejected.exchange(0, std::memory_order_acq_rel)) {
+      throw std::runtime_error("render frame rejected: " + std::string(mHeader->error));
+    }
+    if (acked) {
+      return true;
+    }
+    if (isClosed()) {
+      throw std::runtime_error("failed to send render frame: shared memory is closed");
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      return false;
+    }
+    mHeader->ackBell.wait(
+        seen, std::chrono::duration_cast<std::chrono::microseconds>(deadline - now));
+  }
+}
+
+void SharedFrameRing::fail(std::string const &error) {
+  size_t n = std::min(error.size(), sizeof(mHeader->error) - 1);
+  std::memcpy(mHeader->error, error.data(), n);
+  mHeader->error[n] = '\0';
+  mHeader->rejected.store(1, std::memory_order_release);
+  close();
+  throw std::runtime_error("failed to read render frame: " + error);
+}
+
+bool SharedFrameRing::pop(PackedFrame &frame, std::chrono::microseconds timeout) {
+  // capacity is read once at open, the producer may overwrite the header
+  uint64_t capacity = mCapacity;
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (true) {
+    uint32_t seen = mHeader->frameBell.sequence.load(std::memory_order_acquire);
+    if (isClosed()) {
+      return false;
+    }
+
+    // only the consumer moves the read offset
+    uint64_t read = mHeader->readOffset.load(std::memory_order_relaxed);
+    uint64_t write = mHeader->writeOffset.load(std::memory_order_acquire);
+    if (read != write) {
+      // the ring is shared with another process, nothing in it is trusted: the record header
+      // is copied before it is checked and every section must lie inside the record
+      uint64_t pos = read % capacity;
+      uint64_t available = write - read;
+      if (read % 8 != 0 || available > capacity || available < 2 * sizeof(uint32_t)) {
+        fail("invalid ring offsets");
+      }
+      char const *data = mRing + pos;
+      RecordHeader record{};
+      std::memcpy(&record, data, std::min<uint64_t>(sizeof(record), capacity - pos));
+      if (record.kind == ePadding) {
+        if (record.size != capacity - pos || record.size > available) {
+          fail("invalid padding record");
+        }
+        // the producer may be waiting for this room
+        mHeader->readOffset.store(read + record.size, std::memory_order_release);
+        mHeader->ackBell.ring();
+        continue;
+      }
+
+      uint64_t indexBytes = align8(uint64_t(record.bodyIndexCount) * sizeof(uint32_t));
+      uint64_t bodyBytes = align8(uint64_t(record.bodyCount) * kPoseBytes);
+      uint64_t cameraBytes = align8(uint64_t(record.cameraCount) * kPoseBytes);
+      uint64_t idBytes = uint64_t(record.cameraIdCount) * sizeof(uint64_t);
+      if (record.kind != eFrame || record.size < sizeof(RecordHeader) ||
+          record.size % 8 != 0 || record.size > capacity - pos || record.size > available ||
+          sizeof(RecordHeader) + indexBytes + bodyBytes + cameraBytes + idBytes > record.size ||
+          (!record.full && record.bodyIndexCount != record.bodyCount)) {
+        fail("invalid frame record");
+      }
+
+      data += sizeof(RecordHeader);
+      frame.frame = record.frame;
+      frame.full = record.full;
+      // indices are checked and then used to index server arrays, copy them out of reach of
+      // the producer first
+      mPoppedIndices.resize(record.bodyIndexCount);
+      std::memcpy(mPoppedIndices.data(), data, uint64_t(record.bodyIndexCount) * sizeof(uint32_t));
+      frame.bodyIndices = mPoppedIndices.data();
+      frame.bodyIndexCount = record.bodyIndexCount;
+      data += indexBytes;
+      frame.bodyPoses = data;
+      frame.bodyCount = record.bodyCount;
+      data += bodyBytes;
+      frame.cameraPoses = data;
+      frame.cameraCount = record.cameraCount;
+      data += cameraBytes;
+      mPoppedCameraIds.resize(record.cameraIdCount);
+      std::memcpy(mPoppedCameraIds.data(), data, idBytes);
+      frame.cameraIds = mPoppedCameraIds.data();
+      frame.cameraIdCount = record.cameraIdCount;
+
+      mPoppedFrame = record.frame;
+      mPoppedSize = record.size;
+      return true;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      return false;
+    }
+    mHeader->frameBell.wait(
+        seen, std::chrono::duration_cast<std::chrono::microseconds>(deadline - now));
+  }
+}
+
+void SharedFrameRing::release(std::string const &error) {
+  if (!error.empty()) {
+    size_t n = std::min(error.size(), sizeof(mHeader->error) - 1);
+    std::memcpy(mHeader->error, error.data(), n);
+    mHeader->error[n] = '\0';
+    mHeader->rejected.store(1, std::memory_order_release);
+  }
+  if (mPoppedSize == 0) {
+    return;
+  }
+  uint64_t read = mHeader->readOffset.load(std::memory_order_relaxed);
+  mHeader->readOffset.store(read + mPoppedSize, std::memory_order_release);
+  mHeader->ackedFrame.store(mPoppedFrame, std::memory_order_release);
+  mHeader->ackBell.ring();
+  mPoppedSize = 0;
+}
+
+void SharedFrameRing::close() {
+  mHeader->closed.store(1, std::memory_order_release);
+  mHeader->frameBell.ring();
+  mHeader->ackBell.ring();
+}
+
+bool SharedFrameRing::isClosed() const {
+  return mHeader->closed.load(std::memory_order_acquire);
+}
+
+} // namespace server
+} // namespace Renderer
+} // namespace sapien
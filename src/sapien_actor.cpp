@@ -21,7 +21,10 @@ EActorType SActor::getType() const {
                                                                         : EActorType::DYNAMIC;
 }
 
-void SActor::setPose(PxTransform const &pose) { getPxActor()->setGlobalPose(pose); }
+void SActor::setPose(PxTransform const &pose) {
+  getPxActor()->setGlobalPose(pose);
+  mParentScene->markRenderDirty(this);
+}
 
 void SActor::setKinematicTarget(PxTransform const &pose) { mActor->setKinematicTarget(pose); }
 PxTransform SActor::getKinematicTarget() const {
@@ -34,7 +37,10 @@ PxTransform SActor::getKinematicTarget() const {
 }
 
 void SActor::setVelocity(PxVec3 const &v) { getPxActor()->setLinearVelocity(v); }
-void SActor::setAngularVelocity(PxVec3 const &v) { getPxActor()->setAngularVelocity(v); }
+void SActor::setAngularVelocity(PxVec3 const &v) {
+  getPxActor()->setAngularVelocity(v);
+  mParentScene->markVelocityChanged(this);
+}
 void SActor::lockMotion(bool x, bool y, bool z, bool ax, bool ay, bool az) {
   auto flags = PxRigidDynamicLockFlags();
   if (x) {
@@ -73,53 +79,57 @@ void SActor::prestep() {
   }
 }
 
-std::vector<PxReal> SActor::packData() {
-  std::vector<PxReal> data;
+uint32_t SActor::getPackedSize() const {
+  return getType() == EActorType::DYNAMIC ? 13 : 7;
+}
+
+void SActor::packData(PxReal *data) {
   auto pose = getPose();
-  data.push_back(pose.p.x);
-  data.push_back(pose.p.y);
-  data.push_back(pose.p.z);
-  data.push_back(pose.q.x);
-  data.push_back(pose.q.y);
-  data.push_back(pose.q.z);
-  data.push_back(pose.q.w);
+  data[0] = pose.p.x;
+  data[1] = pose.p.y;
+  data[2] = pose.p.z;
+  data[3] = pose.q.x;
+  data[4] = pose.q.y;
+  data[5] = pose.q.z;
+  data[6] = pose.q.w;
 
   if (getType() == EActorType::DYNAMIC) {
     auto lv = getVelocity();
     auto av = getAngularVelocity();
-    data.push_back(lv.x);
-    data.push_back(lv.y);
-    data.push_back(lv.z);
-    data.push_back(av.x);
-    data.push_back(av.y);
-    data.push_back(av.z);
+    data[7] = lv.x;
+    data[8] = lv.y;
+    data[9] = lv.z;
+    data[10] = av.x;
+    data[11] = av.y;
+    data[12] = av.z;
   }
-
-  return data;
 }
 
-void SActor::unpackData(std::vector<PxReal> const &data) {
+void SActor::unpackData(PxReal const *data) {
+  getPxActor()->setGlobalPose({{data[0], data[1], data[2]}, {data[3], data[4], data[5], data[6]}});
+  mParentScene->markRenderDirty(this);
   if (getType() == EActorType::DYNAMIC) {
-    if (data.size() != 13) {
-      spdlog::get("SAPIEN")->error("Failed to unpack actor: {} numbers expected but {} provided",
-                                   13, data.size());
-      return;
-    }
-    getPxActor()->setGlobalPose(
-        {{data[0], data[1], data[2]}, {data[3], data[4], data[5], data[6]}});
     getPxActor()->setLinearVelocity({data[7], data[8], data[9]});
     getPxActor()->setAngularVelocity({data[10], data[11], data[12]});
-  } else {
-    if (data.size() != 7) {
-      spdlog::get("SAPIEN")->error("Failed to unpack actor: {} numbers expected but {} provided",
-                                   7, data.size());
-      return;
-    }
-    getPxActor()->setGlobalPose(
-        {{data[0], data[1], data[2]}, {data[3], data[4], data[5], data[6]}});
+    mParentScene->markVelocityChanged(this);
   }
 }
 
+std::vector<PxReal> SActor::packData() {
+  std::vector<PxReal> data(getPackedSize());
+  packData(data.data());
+  return data;
+}
+
+void SActor::unpackData(std::vector<PxReal> const &data) {
+  if (data.size() != getPackedSize()) {
+    spdlog::get("SAPIEN")->error("Failed to unpack actor: {} numbers expected but {} provided",
+                                 getPackedSize(), data.size());
+    return;
+  }
+  unpackData(data.data());
+}
+
 SActorStatic::SActorStatic(PxRigidStatic *actor, physx_id_t id, SScene *scene,
                            std::vector<Renderer::IPxrRigidbody *> renderBodies,
                            std::vector<Renderer::IPxrRigidbody *> collisionBodies)
@@ -131,29 +141,42 @@ PxRigidActor *SActorStatic::getPxActor() const { return mActor; }
 
 void SActorStatic::destroy() { mParentScene->removeActor(this); }
 
-void SActorStatic::setPose(PxTransform const &pose) { getPxActor()->setGlobalPose(pose); }
+void SActorStatic::setPose(PxTransform const &pose) {
+  getPxActor()->setGlobalPose(pose);
+  mParentScene->markRenderDirty(this);
+}
 
-std::vector<PxReal> SActorStatic::packData() {
-  std::vector<PxReal> data;
+uint32_t SActorStatic::getPackedSize() const { return 7; }
+
+void SActorStatic::packData(PxReal *data) {
   auto pose = getPose();
-  data.push_back(pose.p.x);
-  data.push_back(pose.p.y);
-  data.push_back(pose.p.z);
-  data.push_back(pose.q.x);
-  data.push_back(pose.q.y);
-  data.push_back(pose.q.z);
-  data.push_back(pose.q.w);
+  data[0] = pose.p.x;
+  data[1] = pose.p.y;
+  data[2] = pose.p.z;
+  data[3] = pose.q.x;
+  data[4] = pose.q.y;
+  data[5] = pose.q.z;
+  data[6] = pose.q.w;
+}
+
+void SActorStatic::unpackData(PxReal const *data) {
+  getPxActor()->setGlobalPose({{data[0], data[1], data[2]}, {data[3], data[4], data[5], data[6]}});
+  mParentScene->markRenderDirty(this);
+}
 
+std::vector<PxReal> SActorStatic::packData() {
+  std::vector<PxReal> data(getPackedSize());
+  packData(data.data());
   return data;
 }
 
 void SActorStatic::unpackData(std::vector<PxReal> const &data) {
-  if (data.size() != 7) {
-    spdlog::get("SAPIEN")->error("Failed to unpack actor: {} numbers expected but {} provided", 13,
-                                 data.size());
+  if (data.size() != getPackedSize()) {
+    spdlog::get("SAPIEN")->error("Failed to unpack actor: {} numbers expected but {} provided",
+                                 getPackedSize(), data.size());
     return;
   }
-  getPxActor()->setGlobalPose({{data[0], data[1], data[2]}, {data[3], data[4], data[5], data[6]}});
+  unpackData(data.data());
 }
 
 } // namespace sapien
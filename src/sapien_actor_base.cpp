@@ -49,12 +49,9 @@ void SActorBase::unhideVisual() {
 }
 bool SActorBase::isHidingVisual() const { return mHidden; }
 
-void SActorBase::prestep() {
-  EventActorStep s;
-  s.actor = this;
-  s.time = mParentScene->getTimestep();
-  EventEmitter<EventActorStep>::emit(s);
-}
+void SActorBase::prestep() {}
+
+void SActorBase::onSubscribersChanged() { mParentScene->markStepSubscribersDirty(); }
 
 void SActorBase::updateRender(PxTransform const &pose) {
   for (auto body : mRenderBodies) {
@@ -65,6 +62,29 @@ void SActorBase::updateRender(PxTransform const &pose) {
   }
 }
 
+void SActorBase::resetForReuse(physx_id_t id) {
+  mId = id;
+  for (auto body : mRenderBodies) {
+    body->setSegmentationId(id);
+  }
+  for (auto body : mCollisionBodies) {
+    body->setSegmentationId(id);
+  }
+  EventEmitter<EventActorPreDestroy>::clearSubscriptions();
+  EventEmitter<EventActorStep>::clearSubscriptions();
+  EventEmitter<EventActorContact>::clearSubscriptions();
+  EventEmitter<EventActorTrigger>::clearSubscriptions();
+  mOnStepCallback.clear();
+  mOnContactCallback.clear();
+  mOnTriggerCallback.clear();
+  if (mContactReportLevel) {
+    setContactReportLevel(std::nullopt);
+  }
+  collisionRender = false;
+  mHidden = false;
+  mDisplayVisibility = 1.f;
+}
+
 void SActorBase::onContact(ContactCallback callback) {
   EventEmitter<EventActorContact>::registerCallback(
       [=](EventActorContact &event) { callback(event.self, event.other, event.contact); });
@@ -84,9 +104,26 @@ void SActorBase::onTrigger(TriggerCallback callback) {
 void SActorBase::attachShape(std::unique_ptr<SCollisionShape> shape) {
   getPxActor()->attachShape(*shape->getPxShape());
   shape->setActor(this);
+  if (mContactReportLevel) {
+    shape->setContactReportLevel(mContactReportLevel);
+  }
   mCollisionShapes.push_back(std::move(shape));
 }
 
+void SActorBase::setContactReportLevel(std::optional<ContactReportLevel> level) {
+  if (mParentScene->isStepping()) {
+    throw std::runtime_error("failed to change contact report level: scene is stepping");
+  }
+  // the pairs of this actor are filtered again and report touch found again
+  mParentScene->getContactBuffer().removeIf([this](SContact const &contact) {
+    return contact.actors[0] == this || contact.actors[1] == this;
+  });
+  mContactReportLevel = level;
+  for (auto &shape : mCollisionShapes) {
+    shape->setContactReportLevel(level);
+  }
+}
+
 std::vector<SCollisionShape *> SActorBase::getCollisionShapes() const {
   std::vector<SCollisionShape *> result;
   for (auto &shape : mCollisionShapes) {
@@ -99,9 +136,17 @@ SActorBase::SActorBase(physx_id_t id, SScene *scene,
                        std::vector<Renderer::IPxrRigidbody *> renderBodies,
                        std::vector<Renderer::IPxrRigidbody *> collisionBodies)
     : SEntity(scene), mId(id), mParentScene(scene), mRenderBodies(renderBodies),
-      mCollisionBodies(collisionBodies) {}
+      mCollisionBodies(collisionBodies) {
+  EventEmitter<EventActorStep>::setSubscriberObserver(this);
+}
 
-PxTransform SActorBase::getPose() const { return getPxActor()->getGlobalPose(); }
+PxTransform SActorBase::getPose() const {
+  // PhysX state must not be read while the simulation is running
+  if (mParentScene->isStepping()) {
+    return mCachedPose;
+  }
+  return getPxActor()->getGlobalPose();
+}
 
 PxVec3 SActorDynamicBase::getVelocity() { return getPxActor()->getLinearVelocity(); }
 
@@ -0,0 +1,98 @@
+#include "sapien/sapien_contact.h"
+#include "sapien/sapien_actor_base.h"
+#include "sapien/sapien_shape.h"
+#include <spdlog/spdlog.h>
+
+namespace sapien {
+
+SContactBuffer::ShapePair SContactBuffer::keyOf(SContact const &contact) {
+  return {contact.collisionShapes[0]->getPxShape(), contact.collisionShapes[1]->getPxShape()};
+}
+
+void SContactBuffer::beginStep() {
+  // the previous arrays are kept until endStep to carry over unreported pairs
+  std::swap(mActive, mPrevActive);
+  std::swap(mPoints, mPrevPoints);
+  mActive.clear();
+  mPoints.clear();
+  mReported.clear();
+}
+
+void SContactBuffer::addContact(PxContactPairHeader const &header, PxContactPair const &pair) {
+  SContact &contact = mReported.emplace_back();
+  contact.actors[0] = static_cast<SActorBase *>(header.actors[0]->userData);
+  contact.actors[1] = static_cast<SActorBase *>(header.actors[1]->userData);
+  contact.collisionShapes[0] = static_cast<SCollisionShape *>(pair.shapes[0]->userData);
+  contact.collisionShapes[1] = static_cast<SCollisionShape *>(pair.shapes[1]->userData);
+  contact.actorIds[0] = contact.actors[0]->getId();
+  contact.actorIds[1] = contact.actors[1]->getId();
+
+  contact.starts = pair.events & PxPairFlag::eNOTIFY_TOUCH_FOUND;
+  contact.ends = pair.events & PxPairFlag::eNOTIFY_TOUCH_LOST;
+  contact.persists = pair.events & PxPairFlag::eNOTIFY_TOUCH_PERSISTS;
+
+  // pointers are filled in by endStep, the point array may still grow
+  contact.pointOffset = mPoints.size();
+  contact.points = {nullptr, 0};
+  if (pair.contactCount) {
+    if (mExtractBuffer.size() < pair.contactCount) {
+      mExtractBuffer.resize(pair.contactCount);
+    }
+    uint32_t count = pair.extractContacts(mExtractBuffer.data(), pair.contactCount);
+    for (uint32_t i = 0; i < count; ++i) {
+      auto &p = mExtractBuffer[i];
+      mPoints.push_back({p.position, p.normal, p.impulse, p.separation});
+    }
+    contact.points.count = count;
+  }
+}
+
+std::vector<SContact> const &SContactBuffer::endStep() {
+  // apply the reports in order, the last report of a pair wins
+  for (uint32_t i = 0; i < mReported.size(); ++i) {
+    auto &contact = mReported[i];
+    if (contact.starts || contact.persists) {
+      // NOTE: contact actually can start twice
+      if (contact.persists && !contact.starts && !mIndex.find(keyOf(contact))) {
+        spdlog::get("SAPIEN")->error("Error updating contact pair: it has not started");
+        continue;
+      }
+      mIndex.insert_or_assign(keyOf(contact), i | kReportedTag);
+    } else if (contact.ends) {
+      if (!mIndex.erase(keyOf(contact))) {
+        spdlog::get("SAPIEN")->error("Error ending contact pair: it has not started");
+      }
+    }
+  }
+
+  // pairs active in the previous step and not reported again are still in contact
+  for (uint32_t i = 0; i < mPrevActive.size(); ++i) {
+    auto &prev = mPrevActive[i];
+    auto index = mIndex.find(keyOf(prev));
+    if (!index || *index != i) {
+      continue;
+    }
+    SContact &contact = mActive.emplace_back(prev);
+    contact.pointOffset = mPoints.size();
+    mPoints.insert(mPoints.end(), mPrevPoints.begin() + prev.pointOffset,
+                   mPrevPoints.begin() + prev.pointOffset + prev.points.count);
+  }
+  for (uint32_t i = 0; i < mReported.size(); ++i) {
+    auto index = mIndex.find(keyOf(mReported[i]));
+    if (index && *index == (i | kReportedTag)) {
+      mActive.push_back(mReported[i]);
+    }
+  }
+
+  // the arrays are final, hand out pointers
+  for (uint32_t i = 0; i < mActive.size(); ++i) {
+    mIndex.insert_or_assign(keyOf(mActive[i]), i);
+    mActive[i].points.data = mPoints.data() + mActive[i].pointOffset;
+  }
+  for (auto &contact : mReported) {
+    contact.points.data = mPoints.data() + contact.pointOffset;
+  }
+  return mReported;
+}
+
+} // namespace sapien
@@ -16,6 +16,9 @@
 #include "sapien/sapien_gear.h"
 #include "sapien/simulation.h"
 #include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <utility>
 #include <spdlog/spdlog.h>
 
 #include <easy/profiler.h>
@@ -31,6 +34,9 @@ SScene::SScene(std::shared_ptr<Simulation> sim, SceneConfig const &config)
   PxSceneDesc sceneDesc(sim->mPhysicsSDK->getTolerancesScale());
   sceneDesc.gravity = PxVec3({config.gravity.x(), config.gravity.y(), config.gravity.z()});
   sceneDesc.filterShader = TypeAffinityIgnoreFilterShader;
+  mContactReportFilter.sceneLevel = static_cast<uint32_t>(config.contactReportLevel);
+  sceneDesc.filterShaderData = &mContactReportFilter;
+  sceneDesc.filterShaderDataSize = sizeof(mContactReportFilter);
   sceneDesc.solverType = config.enableTGS ? PxSolverType::eTGS : PxSolverType::ePGS;
   sceneDesc.bounceThresholdVelocity = config.bounceThreshold;
 
@@ -41,6 +47,8 @@ SScene::SScene(std::shared_ptr<Simulation> sim, SceneConfig const &config)
   if (config.enablePCM) {
     sceneFlags |= PxSceneFlag::eENABLE_PCM;
   }
+  // moved bodies are reported after every step, see updateRender
+  sceneFlags |= PxSceneFlag::eENABLE_ACTIVE_ACTORS;
   if (config.enableCCD) {
     sceneFlags |= PxSceneFlag::eENABLE_CCD;
   }
@@ -52,12 +60,15 @@ SScene::SScene(std::shared_ptr<Simulation> sim, SceneConfig const &config)
   }
   sceneDesc.flags = sceneFlags;
 
-  mCpuDispatcher = PxDefaultCpuDispatcherCreate(0);
-  if (!mCpuDispatcher) {
-    spdlog::get("SAPIEN")->critical("Failed to create PhysX CPU dispatcher");
-    throw std::runtime_error("Scene Creation Failed");
+  std::shared_ptr<JobSystem> jobSystem;
+  if (config.shareThreadPool) {
+    jobSystem = sim->getSharedJobSystem();
+  } else {
+    uint32_t threadCount = config.threadCount ? config.threadCount : sim->getThreadCount();
+    jobSystem = std::make_shared<JobSystem>(threadCount, config.threadAffinityMask);
   }
-  sceneDesc.cpuDispatcher = mCpuDispatcher;
+  mCpuDispatcher = std::make_unique<SapienCpuDispatcher>(jobSystem);
+  sceneDesc.cpuDispatcher = mCpuDispatcher.get();
 
   mPxScene = mSimulationShared->mPhysicsSDK->createScene(sceneDesc);
 
@@ -92,6 +103,12 @@ SScene::~SScene() {
       link->getPxActor()->release();
     }
   }
+  for (auto &actor : mInactiveActors) {
+    actor->getPxActor()->release();
+  }
+  for (auto &articulation : mInactiveArticulations) {
+    articulation->getPxArticulation()->release();
+  }
   for (auto &drive : mDrives) {
     drive->getPxJoint()->release();
   }
@@ -104,16 +121,48 @@ SScene::~SScene() {
   mActors.clear();
   mArticulations.clear();
   mKinematicArticulations.clear();
+  mInactiveActors.clear();
+  mInactiveArticulations.clear();
 
   if (mRendererScene) {
     mSimulationShared->getRenderer()->removeScene(mRendererScene);
   }
 
-  mCpuDispatcher->release();
+  mCpuDispatcher.reset();
   // Finally, release the shared pointer to simulation
   mSimulationShared.reset();
 }
 
+/** remove item from list in O(1) by moving the last element into its slot */
+template <typename T>
+static void swapAndPop(std::vector<std::unique_ptr<T>> &list,
+                       std::unordered_map<T *, uint32_t> &index, T *item) {
+  auto it = index.find(item);
+  if (it == index.end()) {
+    return;
+  }
+  uint32_t i = it->second;
+  index.erase(it);
+  if (i + 1 != list.size()) {
+    list[i] = std::move(list.back());
+    index[list[i].get()] = i;
+  }
+  list.pop_back();
+}
+
+template <typename T>
+static void eraseAdjacency(std::unordered_map<SActorBase *, std::vector<T *>> &adjacency,
+                           SActorBase *actor, T *item) {
+  auto it = adjacency.find(actor);
+  if (it == adjacency.end()) {
+    return;
+  }
+  std::erase(it->second, item);
+  if (it->second.empty()) {
+    adjacency.erase(it);
+  }
+}
+
 /************************************************
  * Create objects
  ***********************************************/
@@ -139,6 +188,13 @@ SDrive6D *SScene::createDrive(SActorBase *actor1, PxTransform const &pose1, SAct
                               PxTransform const &pose2) {
   mDrives.push_back(std::unique_ptr<SDrive6D>(new SDrive6D(this, actor1, pose1, actor2, pose2)));
   auto drive = mDrives.back().get();
+  mDriveIndex[drive] = mDrives.size() - 1;
+  for (auto actor : {actor1, actor2}) {
+    if (actor) {
+      eraseAdjacency(mActorDrives, actor, drive);
+      mActorDrives[actor].push_back(drive);
+    }
+  }
   wakeUpActor(actor1);
   wakeUpActor(actor2);
   return static_cast<SDrive6D *>(drive);
@@ -147,29 +203,49 @@ SDrive6D *SScene::createDrive(SActorBase *actor1, PxTransform const &pose1, SAct
 SGear *SScene::createGear(SActorDynamicBase *actor1, PxTransform const &pose1,
                           SActorDynamicBase *actor2, PxTransform const &pose2) {
   mGears.push_back(std::make_unique<SGear>(this, actor1, pose1, actor2, pose2));
-  return mGears.back().get();
+  auto gear = mGears.back().get();
+  mGearIndex[gear] = mGears.size() - 1;
+  for (SActorBase *actor : {actor1, actor2}) {
+    if (actor) {
+      eraseAdjacency(mActorGears, actor, gear);
+      mActorGears[actor].push_back(gear);
+    }
+  }
+  return gear;
 }
 
 void SScene::addActor(std::unique_ptr<SActorBase> actor) {
   mPxScene->addActor(*actor->getPxActor());
-  mActorId2Actor[actor->getId()] = actor.get();
+  mActorId2Actor.set(actor->getId(), actor.get());
+  mActorIndex[actor.get()] = mActors.size();
+  markRenderDirty(actor.get());
   mActors.push_back(std::move(actor));
+  mStateBufferLayoutDirty = true;
+  mRenderId2VisualNameDirty = true;
 }
 
 void SScene::addArticulation(std::unique_ptr<SArticulation> articulation) {
   for (auto link : articulation->getBaseLinks()) {
-    mActorId2Link[link->getId()] = link;
+    mActorId2Link.set(link->getId(), link);
   }
   mPxScene->addArticulation(*articulation->getPxArticulation());
+  mArticulationIndex[articulation.get()] = mArticulations.size();
+  markRenderDirty(articulation.get());
   mArticulations.push_back(std::move(articulation));
+  mStateBufferLayoutDirty = true;
+  mRenderId2VisualNameDirty = true;
 }
 
 void SScene::addKinematicArticulation(std::unique_ptr<SKArticulation> articulation) {
   for (auto link : articulation->getBaseLinks()) {
-    mActorId2Link[link->getId()] = link;
+    mActorId2Link.set(link->getId(), link);
     mPxScene->addActor(*link->getPxActor());
   }
+  mKinematicArticulationIndex[articulation.get()] = mKinematicArticulations.size();
+  markRenderDirty(articulation.get());
   mKinematicArticulations.push_back(std::move(articulation));
+  mStateBufferLayoutDirty = true;
+  mRenderId2VisualNameDirty = true;
 }
 
 void SScene::removeCleanUp() {
@@ -179,60 +255,73 @@ void SScene::removeCleanUp() {
     mRequiresRemoveCleanUp = false;
 
     // clear contacts
-    std::erase_if(mContacts, [](const auto &item) {
-      auto const &[key, value] = item;
-      return value->actors[0]->isBeingDestroyed() || value->actors[1]->isBeingDestroyed();
+    mContactBuffer.removeIf([](SContact const &contact) {
+      return contact.actors[0]->isBeingDestroyed() || contact.actors[1]->isBeingDestroyed();
     });
 
+    // drop queued render updates of removed bodies
+    {
+      std::lock_guard lock(mRenderDirtyMutex);
+      std::erase_if(mRenderDirtyActors, [](SActorBase *actor) {
+        return actor->getDestroyedState() == 1;
+      });
+    }
+
     // release actors
-    for (auto &a : mActors) {
-      if (a->getDestroyedState() == 1) {
-        a->getPxActor()->userData = nullptr;
+    for (auto a : mRemovedActors) {
+      bool inactive = mInactiveActorIndex.contains(a);
+      a->getPxActor()->userData = nullptr;
+      if (!inactive) {
         mPxScene->removeActor(*a->getPxActor());
-        // a->setDestroyedState(2);
-        a->getPxActor()->release();
+      }
+      // a->setDestroyedState(2);
+      a->getPxActor()->release();
+      if (inactive) {
+        swapAndPop(mInactiveActors, mInactiveActorIndex, a);
+      } else {
+        swapAndPop(mActors, mActorIndex, a);
       }
     }
 
     // release articulation
-    for (auto &a : mArticulations) {
-      if (a->getDestroyedState() == 1) {
-
-        for (auto l : a->getSLinks()) {
-          l->getPxActor()->userData = nullptr;
-        }
-        a->getPxArticulation()->userData = nullptr;
+    for (auto a : mRemovedArticulations) {
+      bool inactive = mInactiveArticulationIndex.contains(a);
+      for (auto l : a->getSLinks()) {
+        l->getPxActor()->userData = nullptr;
+      }
+      a->getPxArticulation()->userData = nullptr;
 
+      if (!inactive) {
         mPxScene->removeArticulation(*a->getPxArticulation());
-        // a->setDestroyedState(2);
+      }
+      // a->setDestroyedState(2);
 
-        a->getPxArticulation()->release();
+      a->getPxArticulation()->release();
+      if (inactive) {
+        swapAndPop(mInactiveArticulations, mInactiveArticulationIndex, a);
+      } else {
+        swapAndPop(mArticulations, mArticulationIndex, a);
       }
     }
 
     // release kinematic articulation
-    for (auto &a : mKinematicArticulations) {
-      if (a->getDestroyedState() == 1) {
-        for (auto l : a->getBaseLinks()) {
-          l->getPxActor()->userData = nullptr;
-          mPxScene->removeActor(*l->getPxActor());
-          // l->setDestroyedState(2);
-
-          l->getPxActor()->release();
-        }
+    for (auto a : mRemovedKinematicArticulations) {
+      for (auto l : a->getBaseLinks()) {
+        l->getPxActor()->userData = nullptr;
+        mPxScene->removeActor(*l->getPxActor());
+        // l->setDestroyedState(2);
+
+        l->getPxActor()->release();
       }
+      swapAndPop(mKinematicArticulations, mKinematicArticulationIndex, a);
     }
 
-    mActors.erase(std::remove_if(mActors.begin(), mActors.end(),
-                                 [](auto &a) { return a->isBeingDestroyed(); }),
-                  mActors.end());
-    mArticulations.erase(std::remove_if(mArticulations.begin(), mArticulations.end(),
-                                        [](auto &a) { return a->isBeingDestroyed(); }),
-                         mArticulations.end());
-    mKinematicArticulations.erase(std::remove_if(mKinematicArticulations.begin(),
-                                                 mKinematicArticulations.end(),
-                                                 [](auto &a) { return a->isBeingDestroyed(); }),
-                                  mKinematicArticulations.end());
+    mRemovedActors.clear();
+    mRemovedArticulations.clear();
+    mRemovedKinematicArticulations.clear();
+    mStepSubscribersDirty = true;
+    mStateBufferLayoutDirty = true;
+    mRenderId2VisualNameDirty = true;
   }
 }
 
@@ -241,6 +330,7 @@ void SScene::removeActor(SActorBase *actor) {
     return;
   }
   mRequiresRemoveCleanUp = true;
+  eraseFromActorPool(actor);
   // predestroy event
   EventActorPreDestroy e;
   e.actor = actor;
@@ -248,28 +338,8 @@ void SScene::removeActor(SActorBase *actor) {
 
   mActorId2Actor.erase(actor->getId());
 
-  // remove drives
-  for (auto it = mDrives.begin(); it != mDrives.end();) {
-    if ((*it)->getActor1() == actor || (*it)->getActor2() == actor) {
-      wakeUpActor((*it)->getActor1());
-      wakeUpActor((*it)->getActor2());
-      (*it)->getPxJoint()->release();
-      it = mDrives.erase(it);
-    } else {
-      ++it;
-    }
-  }
-
-  for (auto it = mGears.begin(); it != mGears.end();) {
-    if ((*it)->getActor1() == actor || (*it)->getActor2() == actor) {
-      wakeUpActor((*it)->getActor1());
-      wakeUpActor((*it)->getActor2());
-      (*it)->getGearJoint()->release();
-      it = mGears.erase(it);
-    } else {
-      ++it;
-    }
-  }
+  // remove drives and gears
+  removeJointsOf(actor);
 
   // remove camera
   removeCameraByParent(actor);
@@ -285,6 +355,7 @@ void SScene::removeActor(SActorBase *actor) {
   }
 
   actor->markDestroyed();
+  mRemovedActors.push_back(actor);
 }
 
 void SScene::removeArticulation(SArticulation *articulation) {
@@ -303,27 +374,8 @@ void SScene::removeArticulation(SArticulation *articulation) {
     e.actor = link;
     link->EventEmitter<EventActorPreDestroy>::emit(e);
 
-    // remove drives
-    for (auto it = mDrives.begin(); it != mDrives.end();) {
-      if ((*it)->getActor1() == link || (*it)->getActor2() == link) {
-        wakeUpActor((*it)->getActor1());
-        wakeUpActor((*it)->getActor2());
-        (*it)->getPxJoint()->release();
-        it = mDrives.erase(it);
-      } else {
-        ++it;
-      }
-    }
-    for (auto it = mGears.begin(); it != mGears.end();) {
-      if ((*it)->getActor1() == link || (*it)->getActor2() == link) {
-        wakeUpActor((*it)->getActor1());
-        wakeUpActor((*it)->getActor2());
-        (*it)->getGearJoint()->release();
-        it = mGears.erase(it);
-      } else {
-        ++it;
-      }
-    }
+    // remove drives and gears
+    removeJointsOf(link);
 
     // remove camera
     removeCameraByParent(link);
@@ -344,6 +396,7 @@ void SScene::removeArticulation(SArticulation *articulation) {
 
   // mark removed
   articulation->markDestroyed();
+  mRemovedArticulations.push_back(articulation);
 }
 
 void SScene::removeKinematicArticulation(SKArticulation *articulation) {
@@ -362,28 +415,8 @@ void SScene::removeKinematicArticulation(SKArticulation *articulation) {
     e.actor = link;
     link->EventEmitter<EventActorPreDestroy>::emit(e);
 
-    // remove drives
-    for (auto it = mDrives.begin(); it != mDrives.end();) {
-      if ((*it)->getActor1() == link || (*it)->getActor2() == link) {
-        wakeUpActor((*it)->getActor1());
-        wakeUpActor((*it)->getActor2());
-        (*it)->getPxJoint()->release();
-        it = mDrives.erase(it);
-      } else {
-        ++it;
-      }
-    }
-
-    for (auto it = mGears.begin(); it != mGears.end();) {
-      if ((*it)->getActor1() == link || (*it)->getActor2() == link) {
-        wakeUpActor((*it)->getActor1());
-        wakeUpActor((*it)->getActor2());
-        (*it)->getGearJoint()->release();
-        it = mGears.erase(it);
-      } else {
-        ++it;
-      }
-    }
+    // remove drives and gears
+    removeJointsOf(link);
 
     // remove camera
     removeCameraByParent(link);
@@ -405,6 +438,7 @@ void SScene::removeKinematicArticulation(SKArticulation *articulation) {
   }
 
   articulation->markDestroyed();
+  mRemovedKinematicArticulations.push_back(articulation);
 }
 
 void SScene::removeDrive(SDrive *drive) {
@@ -412,36 +446,233 @@ void SScene::removeDrive(SDrive *drive) {
     spdlog::get("SAPIEN")->error("Failed to remove drive: drive is not in this scene.");
   }
 
-  wakeUpActor(drive->getActor1());
-  wakeUpActor(drive->getActor2());
-  drive->getPxJoint()->release();
-  std::erase_if(mDrives, [drive](auto &d) { return d.get() == drive; });
+  eraseDrive(drive);
 }
 
 void SScene::removeGear(SGear *gear) {
   if (gear->mScene != this) {
     spdlog::get("SAPIEN")->error("Failed to remove gear: gear is not in this scene.");
   }
+  eraseGear(gear);
+}
+
+void SScene::removeJointsOf(SActorBase *actor) {
+  if (auto it = mActorDrives.find(actor); it != mActorDrives.end()) {
+    auto drives = std::move(it->second);
+    mActorDrives.erase(it);
+    for (auto drive : drives) {
+      eraseDrive(drive);
+    }
+  }
+  if (auto it = mActorGears.find(actor); it != mActorGears.end()) {
+    auto gears = std::move(it->second);
+    mActorGears.erase(it);
+    for (auto gear : gears) {
+      eraseGear(gear);
+    }
+  }
+}
+
+void SScene::eraseDrive(SDrive *drive) {
+  wakeUpActor(drive->getActor1());
+  wakeUpActor(drive->getActor2());
+  drive->getPxJoint()->release();
+  eraseAdjacency(mActorDrives, drive->getActor1(), drive);
+  eraseAdjacency(mActorDrives, drive->getActor2(), drive);
+  swapAndPop(mDrives, mDriveIndex, drive);
+}
+
+void SScene::eraseGear(SGear *gear) {
   wakeUpActor(gear->getActor1());
   wakeUpActor(gear->getActor2());
   gear->getGearJoint()->release();
-  std::erase_if(mGears, [=](auto const &g) { return g.get() == gear; });
+  eraseAdjacency(mActorGears, gear->getActor1(), gear);
+  eraseAdjacency(mActorGears, gear->getActor2(), gear);
+  swapAndPop(mGears, mGearIndex, gear);
 }
 
-SActorBase *SScene::findActorById(physx_id_t id) const {
-  auto it = mActorId2Actor.find(id);
-  if (it == mActorId2Actor.end()) {
-    return nullptr;
+/************************************************
+ * Object pools
+ ***********************************************/
+/** move item from one list to another, the source slot is filled by swap-and-pop */
+template <typename T>
+static void moveBetween(std::vector<std::unique_ptr<T>> &from,
+                        std::unordered_map<T *, uint32_t> &fromIndex,
+                        std::vector<std::unique_ptr<T>> &to,
+                        std::unordered_map<T *, uint32_t> &toIndex, T *item) {
+  uint32_t i = fromIndex.at(item);
+  toIndex[item] = to.size();
+  to.push_back(std::move(from[i]));
+  fromIndex.erase(item);
+  if (i + 1 != from.size()) {
+    from[i] = std::move(from.back());
+    fromIndex[from[i].get()] = i;
+  }
+  from.pop_back();
+}
+
+void SScene::hideForPool(SActorBase *actor) {
+  removeJointsOf(actor);
+  mContactBuffer.removeIf([actor](SContact const &contact) {
+    return contact.actors[0] == actor || contact.actors[1] == actor;
+  });
+  for (auto body : actor->getRenderBodies()) {
+    body->setVisible(false);
+  }
+  for (auto body : actor->getCollisionBodies()) {
+    body->setVisible(false);
   }
-  return it->second;
 }
 
-SLinkBase *SScene::findArticulationLinkById(physx_id_t id) const {
-  auto it = mActorId2Link.find(id);
-  if (it == mActorId2Link.end()) {
+void SScene::unhideFromPool(SActorBase *actor) {
+  if (!actor->isHidingVisual()) {
+    actor->renderCollisionBodies(actor->isRenderingCollision());
+  }
+}
+
+void SScene::deactivateActor(SActorBase *actor) {
+  if (mStepping) {
+    throw std::runtime_error("failed to deactivate actor: scene is stepping");
+  }
+  if (!mActorIndex.contains(actor) || actor->isBeingDestroyed()) {
+    throw std::runtime_error("failed to deactivate actor: actor is not active in this scene");
+  }
+  hideForPool(actor);
+  mPxScene->removeActor(*actor->getPxActor());
+  mActorId2Actor.erase(actor->getId());
+  moveBetween(mActors, mActorIndex, mInactiveActors, mInactiveActorIndex, actor);
+  if (auto builder = actor->getBuilder()) {
+    mActorPool[{builder.get(), actor->getBuilderRevision(), actor->getType()}].push_back(actor);
+  }
+  mStepSubscribersDirty = true;
+  mStateBufferLayoutDirty = true;
+  mRenderId2VisualNameDirty = true;
+}
+
+void SScene::activateActor(SActorBase *actor, PxTransform const &pose) {
+  if (mStepping) {
+    throw std::runtime_error("failed to activate actor: scene is stepping");
+  }
+  if (!mInactiveActorIndex.contains(actor) || actor->isBeingDestroyed()) {
+    throw std::runtime_error("failed to activate actor: actor is not deactivated in this scene");
+  }
+  auto px = actor->getPxActor();
+  px->setGlobalPose(pose);
+  if (auto body = px->is<PxRigidDynamic>()) {
+    if (!body->getRigidBodyFlags().isSet(PxRigidBodyFlag::eKINEMATIC)) {
+      body->setLinearVelocity({0, 0, 0});
+      body->setAngularVelocity({0, 0, 0});
+    }
+  }
+  mPxScene->addActor(*px);
+  mActorId2Actor.set(actor->getId(), actor);
+  actor->updateRender(pose);
+  unhideFromPool(actor);
+  eraseFromActorPool(actor);
+  moveBetween(mInactiveActors, mInactiveActorIndex, mActors, mActorIndex, actor);
+  mStepSubscribersDirty = true;
+  mStateBufferLayoutDirty = true;
+  mRenderId2VisualNameDirty = true;
+}
+
+void SScene::deactivateArticulation(SArticulation *articulation) {
+  if (mStepping) {
+    throw std::runtime_error("failed to deactivate articulation: scene is stepping");
+  }
+  if (!mArticulationIndex.contains(articulation) || articulation->isBeingDestroyed()) {
+    throw std::runtime_error(
+        "failed to deactivate articulation: articulation is not active in this scene");
+  }
+  for (auto link : articulation->getBaseLinks()) {
+    hideForPool(link);
+    mActorId2Link.erase(link->getId());
+  }
+  mPxScene->removeArticulation(*articulation->getPxArticulation());
+  moveBetween(mArticulations, mArticulationIndex, mInactiveArticulations,
+              mInactiveArticulationIndex, articulation);
+  mStepSubscribersDirty = true;
+  mStateBufferLayoutDirty = true;
+  mRenderId2VisualNameDirty = true;
+}
+
+void SScene::activateArticulation(SArticulation *articulation, PxTransform const &rootPose) {
+  if (mStepping) {
+    throw std::runtime_error("failed to activate articulation: scene is stepping");
+  }
+  if (!mInactiveArticulationIndex.contains(articulation) || articulation->isBeingDestroyed()) {
+    throw std::runtime_error(
+        "failed to activate articulation: articulation is not deactivated in this scene");
+  }
+  // the articulation cache only works on articulations in a scene
+  mPxScene->addArticulation(*articulation->getPxArticulation());
+  articulation->setRootPose(rootPose);
+  articulation->setRootVelocity({0, 0, 0});
+  articulation->setRootAngularVelocity({0, 0, 0});
+  articulation->setQvel(std::vector<PxReal>(articulation->dof(), 0.f));
+  for (auto link : articulation->getBaseLinks()) {
+    mActorId2Link.set(link->getId(), link);
+    link->updateRender(link->getPxActor()->getGlobalPose());
+    unhideFromPool(link);
+  }
+  moveBetween(mInactiveArticulations, mInactiveArticulationIndex, mArticulations,
+              mArticulationIndex, articulation);
+  mStepSubscribersDirty = true;
+  mStateBufferLayoutDirty = true;
+  mRenderId2VisualNameDirty = true;
+}
+
+bool SScene::isActive(SActorBase *actor) const { return !mInactiveActorIndex.contains(actor); }
+
+bool SScene::isActive(SArticulation *articulation) const {
+  return !mInactiveArticulationIndex.contains(articulation);
+}
+
+void SScene::clearInactiveObjects() {
+  for (auto &actor : mInactiveActors) {
+    removeActor(actor.get());
+  }
+  for (auto &articulation : mInactiveArticulations) {
+    removeArticulation(articulation.get());
+  }
+}
+
+SActorBase *SScene::reuseActor(ActorBuilder const *builder, uint64_t revision, EActorType type) {
+  auto it = mActorPool.find({builder, revision, type});
+  if (it == mActorPool.end()) {
     return nullptr;
   }
-  return it->second;
+  // removed actors leave the pool immediately, so every pooled actor can be reused
+  auto actor = it->second.back();
+  actor->resetForReuse(mActorIdGenerator.next());
+  activateActor(actor, PxTransform(PxIdentity));
+  return actor;
+}
+
+void SScene::eraseFromActorPool(SActorBase *actor) {
+  auto builder = actor->getBuilder();
+  if (!builder) {
+    return;
+  }
+  auto it = mActorPool.find({builder.get(), actor->getBuilderRevision(), actor->getType()});
+  if (it == mActorPool.end()) {
+    return;
+  }
+  auto &pool = it->second;
+  // reuse takes the last actor, search from the back
+  auto pos = std::find(pool.rbegin(), pool.rend(), actor);
+  if (pos != pool.rend()) {
+    *pos = pool.back();
+    pool.pop_back();
+  }
+  if (pool.empty()) {
+    mActorPool.erase(it);
+  }
+}
+
+SActorBase *SScene::findActorById(physx_id_t id) const { return mActorId2Actor.get(id); }
+
+SLinkBase *SScene::findArticulationLinkById(physx_id_t id) const {
+  return mActorId2Link.get(id);
 }
 
 void SScene::wakeUpActor(SActorBase *actor) {
@@ -488,17 +719,77 @@ void SScene::removeCamera(SCamera *cam) {
                  mCameras.end());
 }
 
-void SScene::step() {
-  EASY_BLOCK("Pre-step processing", profiler::colors::Blue);
-
+void SScene::updateStepSubscribers() {
+  mStepSubscribersDirty = false;
+  mStepSubscribedActors.clear();
+  mStepSubscribedArticulations.clear();
+  auto addActor = [this](SActorBase *actor) {
+    if (actor->EventEmitter<EventActorStep>::hasSubscribers()) {
+      mStepSubscribedActors.push_back(actor);
+    }
+  };
+  auto addArticulation = [&](SArticulationBase *articulation) {
+    if (articulation->EventEmitter<EventArticulationStep>::hasSubscribers()) {
+      mStepSubscribedArticulations.push_back(articulation);
+    }
+    for (auto link : articulation->getBaseLinks()) {
+      addActor(link);
+    }
+  };
   for (auto &a : mActors) {
-    if (!a->isBeingDestroyed())
-      a->prestep();
+    addActor(a.get());
   }
   for (auto &a : mArticulations) {
-    if (!a->isBeingDestroyed())
+    addArticulation(a.get());
+  }
+  for (auto &a : mKinematicArticulations) {
+    addArticulation(a.get());
+  }
+}
+
+void SScene::prestep() {
+  if (mStepSubscribersDirty) {
+    updateStepSubscribers();
+  }
+
+  // step events are dispatched from the subscriber lists, passive objects cost nothing here
+  PxReal time = getTimestep();
+  for (auto a : mStepSubscribedArticulations) {
+    if (!a->isBeingDestroyed()) {
+      EventArticulationStep s;
+      s.articulation = a;
+      s.time = time;
+      a->EventEmitter<EventArticulationStep>::emit(s);
+    }
+  }
+  for (auto a : mStepSubscribedActors) {
+    if (!a->isBeingDestroyed()) {
+      EventActorStep s;
+      s.actor = a;
+      s.time = time;
+      a->EventEmitter<EventActorStep>::emit(s);
+    }
+  }
+
+  PxU32 count;
+  PxActor **active = mPxScene->getActiveActors(count);
+  auto &actors = mVelocityChangedActors;
+  for (PxU32 i = 0; i < count; ++i) {
+    auto actor = static_cast<SActorBase *>(active[i]->userData);
+    if (actor && actor->getType() == EActorType::DYNAMIC) {
+      actors.push_back(actor);
+    }
+  }
+  std::sort(actors.begin(), actors.end());
+  actors.erase(std::unique(actors.begin(), actors.end()), actors.end());
+  for (auto a : actors) {
+    // marked actors may have been deactivated or released since
+    if (mActorIndex.contains(a) && !a->isBeingDestroyed()) {
       a->prestep();
+    }
   }
+  actors.clear();
+
   for (auto &a : mKinematicArticulations) {
     if (!a->isBeingDestroyed())
       a->prestep();
@@ -506,40 +797,171 @@ void SScene::step() {
 
   // confirm removal of marked objects
   removeCleanUp();
+}
 
-  EASY_END_BLOCK;
-  EASY_BLOCK("PhysX scene Step", profiler::colors::Red);
+void SScene::waitForResults() {
+  // a worker waiting on its own job system must keep running jobs,
+  // otherwise the tasks of this simulation step may never be scheduled
+  auto &jobs = *mCpuDispatcher->getJobSystem();
+  if (jobs.isWorkerThread()) {
+    while (!mPxScene->checkResults(false)) {
+      if (!jobs.runPendingJob()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+  // contacts are collected during fetch and their events are emitted once the buffer is final
+  // the callbacks may remove objects, which are not actually removed in this step
+  mContactBuffer.beginStep();
+  if (!mPxScene->fetchResults(true)) {
+    spdlog::get("SAPIEN")->error("Failed to fetch simulation results");
+  }
+  ++mStepCount;
+  collectActiveActors();
+  for (auto &contact : mContactBuffer.endStep()) {
+    EventActorContact event;
+    event.contact = &contact;
+    if (contact.actors[0]->EventEmitter<EventActorContact>::hasSubscribers()) {
+      event.self = contact.actors[0];
+      event.other = contact.actors[1];
+      contact.actors[0]->EventEmitter<EventActorContact>::emit(event);
+    }
+    if (contact.actors[1]->EventEmitter<EventActorContact>::hasSubscribers()) {
+      event.self = contact.actors[1];
+      event.other = contact.actors[0];
+      contact.actors[1]->EventEmitter<EventActorContact>::emit(event);
+    }
+  }
+  if (mStateBufferEnabled) {
+    updateStateBuffer();
+  }
+}
 
-  mPxScene->simulate(mTimestep);
-  while (!mPxScene->fetchResults(true)) {
-    // contact callback can happen here
-    // the callbacks may remove objects, which are not actually removed in this step
+void SScene::setContactReportLevel(ContactReportLevel level) {
+  if (mStepping) {
+    throw std::runtime_error("failed to change contact report level: scene is stepping");
   }
+  mConfig.contactReportLevel = level;
+  mContactReportFilter.sceneLevel = static_cast<uint32_t>(level);
+  updateContactReportFilter();
+}
 
-  EASY_END_BLOCK;
+ContactReportLevel SScene::getContactReportLevel() const {
+  return static_cast<ContactReportLevel>(mContactReportFilter.sceneLevel);
+}
+
+void SScene::setGroupContactReportLevel(uint32_t group, std::optional<ContactReportLevel> level) {
+  if (group < 1 || group > 32) {
+    throw std::runtime_error("contact report group must be between 1 and 32");
+  }
+  if (mStepping) {
+    throw std::runtime_error("failed to change contact report level: scene is stepping");
+  }
+  mContactReportFilter.groupLevels[group - 1] = level ? static_cast<uint32_t>(*level) + 1 : 0;
+  updateContactReportFilter();
+}
+
+std::optional<ContactReportLevel> SScene::getGroupContactReportLevel(uint32_t group) const {
+  if (group < 1 || group > 32) {
+    throw std::runtime_error("contact report group must be between 1 and 32");
+  }
+  uint32_t level = mContactReportFilter.groupLevels[group - 1];
+  if (!level) {
+    return {};
+  }
+  return static_cast<ContactReportLevel>(level - 1);
+}
+
+void SScene::updateContactReportFilter() {
+  mPxScene->setFilterShaderData(&mContactReportFilter, sizeof(mContactReportFilter));
 
+  // refiltered pairs are recreated and report touch found again
+  mContactBuffer.removeIf([](SContact const &) { return true; });
+  for (auto &actor : mActors) {
+    mPxScene->resetFiltering(*actor->getPxActor());
+  }
+  for (auto &articulation : mArticulations) {
+    for (auto link : articulation->getBaseLinks()) {
+      mPxScene->resetFiltering(*link->getPxActor());
+    }
+  }
+  for (auto &articulation : mKinematicArticulations) {
+    for (auto link : articulation->getBaseLinks()) {
+      mPxScene->resetFiltering(*link->getPxActor());
+    }
+  }
+}
+
+void SScene::emitStepEvent() {
   EventSceneStep event;
   event.scene = this;
   event.timeStep = getTimestep();
   emit(event);
 }
 
+void SScene::cachePoses() {
+  for (auto &a : mActors) {
+    if (!a->isBeingDestroyed())
+      a->cachePose();
+  }
+  for (auto &a : mArticulations) {
+    if (!a->isBeingDestroyed())
+      for (auto l : a->getBaseLinks())
+        l->cachePose();
+  }
+  for (auto &a : mKinematicArticulations) {
+    if (!a->isBeingDestroyed())
+      for (auto l : a->getBaseLinks())
+        l->cachePose();
+  }
+}
+
+void SScene::beginStep() {
+  if (mStepping) {
+    throw std::runtime_error("failed to begin step: the previous step has not ended");
+  }
+  EASY_BLOCK("Pre-step processing", profiler::colors::Blue);
+  prestep();
+  cachePoses();
+  EASY_END_BLOCK;
+
+  mStepping = true;
+  mPxScene->simulate(mTimestep);
+}
+
+void SScene::endStep() {
+  if (!mStepping) {
+    throw std::runtime_error("failed to end step: no step has begun");
+  }
+  EASY_BLOCK("PhysX scene fetch", profiler::colors::Red);
+  // contact callbacks during fetch read the live state
+  mStepping = false;
+  waitForResults();
+  EASY_END_BLOCK;
+
+  emitStepEvent();
+}
+
+void SScene::step() {
+  if (mStepping) {
+    throw std::runtime_error("failed to step: a step begun by beginStep has not ended");
+  }
+  EASY_BLOCK("Pre-step processing", profiler::colors::Blue);
+  prestep();
+  EASY_END_BLOCK;
+
+  EASY_BLOCK("PhysX scene Step", profiler::colors::Red);
+  mPxScene->simulate(mTimestep);
+  waitForResults();
+  EASY_END_BLOCK;
+
+  emitStepEvent();
+}
+
 std::future<void> SScene::stepAsync() {
   return getThread().submit([this]() {
     EASY_BLOCK("Scene preprocess")
-    for (auto &a : mActors) {
-      if (!a->isBeingDestroyed())
-        a->prestep();
-    }
-    for (auto &a : mArticulations) {
-      if (!a->isBeingDestroyed())
-        a->prestep();
-    }
-    for (auto &a : mKinematicArticulations) {
-      if (!a->isBeingDestroyed())
-        a->prestep();
-    }
-    removeCleanUp();
+    prestep();
     EASY_END_BLOCK
 
     EASY_BLOCK("PhysX scene simulate", profiler::colors::Red);
@@ -547,17 +969,11 @@ std::future<void> SScene::stepAsync() {
     EASY_END_BLOCK
 
     EASY_BLOCK("PhysX scene fetch", profiler::colors::Red);
-    while (!mPxScene->fetchResults(true)) {
-    }
+    waitForResults();
     EASY_END_BLOCK
 
     EASY_BLOCK("Scene postprocess");
-    // removeCleanUp2();
-
-    EventSceneStep event;
-    event.scene = this;
-    event.timeStep = getTimestep();
-    emit(event);
+    emitStepEvent();
     EASY_END_BLOCK
   });
 }
@@ -577,19 +993,7 @@ std::future<void> SScene::multistepAsync(int steps, SceneMultistepCallback *call
 
       {
         EASY_BLOCK("Scene preprocess")
-        for (auto &a : mActors) {
-          if (!a->isBeingDestroyed())
-            a->prestep();
-        }
-        for (auto &a : mArticulations) {
-          if (!a->isBeingDestroyed())
-            a->prestep();
-        }
-        for (auto &a : mKinematicArticulations) {
-          if (!a->isBeingDestroyed())
-            a->prestep();
-        }
-        removeCleanUp();
+        prestep();
       }
 
       {
@@ -599,8 +1003,7 @@ std::future<void> SScene::multistepAsync(int steps, SceneMultistepCallback *call
 
       {
         EASY_BLOCK("PhysX scene fetch", profiler::colors::Red);
-        while (!mPxScene->fetchResults(true)) {
-        }
+        waitForResults();
       }
 
       {
@@ -613,10 +1016,7 @@ std::future<void> SScene::multistepAsync(int steps, SceneMultistepCallback *call
       callback->afterMultistep();
     }
 
-    EventSceneStep event;
-    event.scene = this;
-    event.timeStep = getTimestep();
-    emit(event);
+    emitStepEvent();
     EASY_END_BLOCK
   });
 }
@@ -627,24 +1027,69 @@ std::future<void> SScene::multistepAsync(int steps, SceneMultistepCallback *call
 //   mStep.get();
 // }
 
-void SScene::updateRender() {
-  EASY_FUNCTION("Update Render", profiler::colors::Magenta);
-  std::lock_guard lock(mUpdateRenderMutex);
+void SScene::markRenderDirty(SActorBase *actor) {
+  std::lock_guard lock(mRenderDirtyMutex);
+  if (!actor->isRenderQueued()) {
+    actor->setRenderQueued(true);
+    mRenderDirtyActors.push_back(actor);
+  }
+}
 
-  if (!mRendererScene) {
-    spdlog::get("SAPIEN")->error("Failed to update render: renderer is not added.");
+void SScene::markRenderDirty(SArticulationBase *articulation) {
+  for (auto link : articulation->getBaseLinks()) {
+    markRenderDirty(link);
+  }
+}
+
+void SScene::markAllRenderDirty() {
+  std::lock_guard lock(mRenderDirtyMutex);
+  mRenderAllDirty = true;
+}
+
+void SScene::collectActiveActors() {
+  PxU32 count;
+  PxActor **actors = mPxScene->getActiveActors(count);
+  std::lock_guard lock(mRenderDirtyMutex);
+  for (PxU32 i = 0; i < count; ++i) {
+    auto actor = static_cast<SActorBase *>(actors[i]->userData);
+    if (actor && !actor->isRenderQueued()) {
+      actor->setRenderQueued(true);
+      mRenderDirtyActors.push_back(actor);
+    }
+  }
+}
+
+void SScene::syncRenderPoses() {
+  std::vector<SActorBase *> dirty;
+  bool all;
+  {
+    std::lock_guard lock(mRenderDirtyMutex);
+    dirty.swap(mRenderDirtyActors);
+    all = std::exchange(mRenderAllDirty, false);
+    for (auto actor : dirty) {
+      actor->setRenderQueued(false);
+    }
+  }
+
+  if (!all) {
+    for (auto actor : dirty) {
+      if (!actor->isBeingDestroyed()) {
+        actor->updateRender(actor->getPose());
+      }
+    }
     return;
   }
+
   for (auto &actor : mActors) {
     if (!actor->isBeingDestroyed()) {
-      actor->updateRender(actor->getPxActor()->getGlobalPose());
+      actor->updateRender(actor->getPose());
     }
   }
 
   for (auto &articulation : mArticulations) {
     for (auto &link : articulation->getBaseLinks()) {
       if (!articulation->isBeingDestroyed()) {
-        link->updateRender(link->getPxActor()->getGlobalPose());
+        link->updateRender(link->getPose());
       }
     }
   }
@@ -652,10 +1097,21 @@ void SScene::updateRender() {
   for (auto &articulation : mKinematicArticulations) {
     for (auto &link : articulation->getBaseLinks()) {
       if (!articulation->isBeingDestroyed()) {
-        link->updateRender(link->getPxActor()->getGlobalPose());
+        link->updateRender(link->getPose());
       }
     }
   }
+}
+
+void SScene::updateRender() {
+  EASY_FUNCTION("Update Render", profiler::colors::Magenta);
+  std::lock_guard lock(mUpdateRenderMutex);
+
+  if (!mRendererScene) {
+    spdlog::get("SAPIEN")->error("Failed to update render: renderer is not added.");
+    return;
+  }
+  syncRenderPoses();
 
   for (auto &cam : mCameras) {
     cam->update();
@@ -675,27 +1131,7 @@ void SScene::updateRenderAndTakePictures(std::vector<SCamera *> const &cameras)
     spdlog::get("SAPIEN")->error("Failed to update render: renderer is not added.");
     return;
   }
-  for (auto &actor : mActors) {
-    if (!actor->isBeingDestroyed()) {
-      actor->updateRender(actor->getPxActor()->getGlobalPose());
-    }
-  }
-
-  for (auto &articulation : mArticulations) {
-    for (auto &link : articulation->getBaseLinks()) {
-      if (!articulation->isBeingDestroyed()) {
-        link->updateRender(link->getPxActor()->getGlobalPose());
-      }
-    }
-  }
-
-  for (auto &articulation : mKinematicArticulations) {
-    for (auto &link : articulation->getBaseLinks()) {
-      if (!articulation->isBeingDestroyed()) {
-        link->updateRender(link->getPxActor()->getGlobalPose());
-      }
-    }
-  }
+  syncRenderPoses();
 
   for (auto &cam : mCameras) {
     cam->update();
@@ -720,36 +1156,6 @@ SActorStatic *SScene::addGround(PxReal altitude, bool render,
                                            "ground");
 }
 
-void SScene::updateContact(std::unique_ptr<SContact> contact) {
-  auto pair = std::make_pair(contact->collisionShapes[0]->getPxShape(),
-                             contact->collisionShapes[1]->getPxShape());
-  if (contact->starts) {
-    // NOTE: contact actually can start twice
-    mContacts[pair] = std::move(contact);
-  } else if (contact->persists) {
-    auto it = mContacts.find(pair);
-    if (it == mContacts.end()) {
-      spdlog::get("SAPIEN")->error("Error updating contact pair: it has not started");
-    }
-    it->second = std::move(contact);
-  } else if (contact->ends) {
-    auto it = mContacts.find(pair);
-    if (it == mContacts.end()) {
-      spdlog::get("SAPIEN")->error("Error ending contact pair: it has not started");
-      return;
-    }
-    mContacts.erase(it);
-  }
-}
-
-std::vector<SContact *> SScene::getContacts() const {
-  std::vector<SContact *> contacts{};
-  for (auto &it : mContacts) {
-    contacts.push_back(it.second.get());
-  }
-  return contacts;
-}
-
 std::vector<SActorBase *> SScene::getAllActors() const {
   std::vector<SActorBase *> output;
   for (auto &actor : mActors) {
@@ -768,6 +1174,59 @@ std::vector<SArticulationBase *> SScene::getAllArticulations() const {
   return output;
 }
 
+static uint32_t getMaxDof(std::vector<SArticulation *> const &articulations) {
+  uint32_t maxDof = 0;
+  for (auto articulation : articulations) {
+    maxDof = std::max(maxDof, articulation->dof());
+  }
+  return maxDof;
+}
+
+void SScene::getArticulationStates(std::vector<SArticulation *> const &articulations,
+                                   uint32_t fields, PxReal *out, uint32_t stride) const {
+  stride = stride ? stride : getMaxDof(articulations);
+  uint32_t rowSize = ArticulationStateField::count(fields) * stride;
+  std::fill(out, out + articulations.size() * rowSize, 0.f);
+  for (uint32_t i = 0; i < articulations.size(); ++i) {
+    if (articulations[i]->dof() > stride) {
+      throw std::runtime_error("failed to get articulation states: dof exceeds stride");
+    }
+    articulations[i]->getState(fields, out + i * rowSize, stride);
+  }
+}
+
+void SScene::setArticulationStates(std::vector<SArticulation *> const &articulations,
+                                   uint32_t fields, PxReal const *data, uint32_t stride) {
+  stride = stride ? stride : getMaxDof(articulations);
+  uint32_t rowSize = ArticulationStateField::count(fields) * stride;
+  for (uint32_t i = 0; i < articulations.size(); ++i) {
+    if (articulations[i]->dof() > stride) {
+      throw std::runtime_error("failed to set articulation states: dof exceeds stride");
+    }
+    articulations[i]->setState(fields, data + i * rowSize, stride);
+  }
+}
+
+void SScene::applyDriveCommands(std::vector<SArticulation *> const &articulations,
+                                SDriveCommand const &command, uint32_t stride) {
+  stride = stride ? stride : getMaxDof(articulations);
+  auto offset = [stride](PxReal const *data, uint32_t row) {
+    return data ? data + row * stride : nullptr;
+  };
+  for (uint32_t i = 0; i < articulations.size(); ++i) {
+    if (articulations[i]->dof() > stride) {
+      throw std::runtime_error("failed to apply drive commands: dof exceeds stride");
+    }
+    SDriveCommand row;
+    row.target = offset(command.target, i);
+    row.velocityTarget = offset(command.velocityTarget, i);
+    row.stiffness = offset(command.stiffness, i);
+    row.damping = offset(command.damping, i);
+    row.forceLimit = offset(command.forceLimit, i);
+    articulations[i]->applyDriveCommand(row);
+  }
+}
+
 std::vector<SLight *> SScene::getAllLights() const {
   std::vector<SLight *> output;
   for (auto &light : mLights) {
@@ -776,28 +1235,35 @@ std::vector<SLight *> SScene::getAllLights() const {
   return output;
 }
 
-std::map<physx_id_t, std::string> SScene::findRenderId2VisualName() const {
-  std::map<physx_id_t, std::string> result;
-  for (auto &actor : mActors) {
+std::vector<std::string> const &SScene::findRenderId2VisualName() {
+  if (!mRenderId2VisualNameDirty) {
+    return mRenderId2VisualName;
+  }
+  mRenderId2VisualName.clear();
+  auto add = [this](SActorBase *actor) {
     for (auto &v : actor->getRenderBodies()) {
-      result[v->getUniqueId()] = v->getName();
+      auto id = v->getUniqueId();
+      if (id >= mRenderId2VisualName.size()) {
+        mRenderId2VisualName.resize(id + 1);
+      }
+      mRenderId2VisualName[id] = v->getName();
     }
+  };
+  for (auto &actor : mActors) {
+    add(actor.get());
   }
   for (auto &articulation : mArticulations) {
     for (auto &actor : articulation->getBaseLinks()) {
-      for (auto &v : actor->getRenderBodies()) {
-        result[v->getUniqueId()] = v->getName();
-      }
+      add(actor);
     }
   }
   for (auto &articulation : mKinematicArticulations) {
     for (auto &actor : articulation->getBaseLinks()) {
-      for (auto &v : actor->getRenderBodies()) {
-        result[v->getUniqueId()] = v->getName();
-      }
+      add(actor);
     }
   }
-  return result;
+  mRenderId2VisualNameDirty = false;
+  return mRenderId2VisualName;
 }
 
 SceneData SScene::packScene() {
@@ -848,6 +1314,299 @@ void SScene::unpackScene(SceneData const &data) {
   }
 }
 
+void SScene::saveSnapshot(std::vector<uint8_t> &buffer) {
+  if (mStepping) {
+    throw std::runtime_error("failed to save snapshot: scene is stepping");
+  }
+
+  // the kinematic articulation links are stored as actors
+  uint32_t actorCount = mActors.size();
+  for (auto &articulation : mKinematicArticulations) {
+    actorCount += articulation->getBaseLinks().size();
+  }
+  uint32_t articulationCount = mArticulations.size();
+
+  uint64_t dataOffset =
+      sizeof(SnapshotHeader) + sizeof(SnapshotEntry) * (actorCount + articulationCount);
+  uint64_t valueCount = 0;
+  for (auto &actor : mActors) {
+    valueCount += actor->getPackedSize();
+  }
+  for (auto &articulation : mKinematicArticulations) {
+    for (auto link : articulation->getBaseLinks()) {
+      valueCount += link->getPackedSize();
+    }
+  }
+  for (auto &articulation : mArticulations) {
+    valueCount += articulation->getPackedSize() + articulation->getPackedDriveSize();
+  }
+  uint64_t size = dataOffset + valueCount * sizeof(PxReal);
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("failed to save snapshot: scene is too large");
+  }
+  buffer.resize(size);
+
+  auto header = reinterpret_cast<SnapshotHeader *>(buffer.data());
+  header->magic = kSnapshotMagic;
+  header->version = kSnapshotVersion;
+  header->actorCount = actorCount;
+  header->articulationCount = articulationCount;
+  header->size = size;
+
+  auto entry = reinterpret_cast<SnapshotEntry *>(buffer.data() + sizeof(SnapshotHeader));
+  uint32_t offset = dataOffset;
+  auto writeActor = [&](SActorBase *actor) {
+    entry->id = actor->getId();
+    entry->offset = offset;
+    entry->count = actor->getPackedSize();
+    entry->driveCount = 0;
+    actor->packData(reinterpret_cast<PxReal *>(buffer.data() + offset));
+    offset += entry->count * sizeof(PxReal);
+    ++entry;
+  };
+  for (auto &actor : mActors) {
+    writeActor(actor.get());
+  }
+  for (auto &articulation : mKinematicArticulations) {
+    for (auto link : articulation->getBaseLinks()) {
+      writeActor(link);
+    }
+  }
+  for (auto &articulation : mArticulations) {
+    entry->id = articulation->getRootLink()->getId();
+    entry->offset = offset;
+    entry->count = articulation->getPackedSize();
+    entry->driveCount = articulation->getPackedDriveSize();
+    auto data = reinterpret_cast<PxReal *>(buffer.data() + offset);
+    articulation->packData(data);
+    articulation->packDrive(data + entry->count);
+    offset += (entry->count + entry->driveCount) * sizeof(PxReal);
+    ++entry;
+  }
+}
+
+std::vector<uint8_t> SScene::saveSnapshot() {
+  std::vector<uint8_t> buffer;
+  saveSnapshot(buffer);
+  return buffer;
+}
+
+void SScene::restoreSnapshot(uint8_t const *data, size_t size) {
+  if (mStepping) {
+    throw std::runtime_error("failed to restore snapshot: scene is stepping");
+  }
+  if (size < sizeof(SnapshotHeader)) {
+    throw std::runtime_error("failed to restore snapshot: buffer is too small");
+  }
+  auto header = reinterpret_cast<SnapshotHeader const *>(data);
+  if (header->magic != kSnapshotMagic) {
+    throw std::runtime_error("failed to restore snapshot: invalid snapshot");
+  }
+  if (header->version != kSnapshotVersion) {
+    throw std::runtime_error("failed to restore snapshot: unsupported version " +
+                             std::to_string(header->version));
+  }
+  uint64_t entryCount = uint64_t(header->actorCount) + header->articulationCount;
+  if (header->size != size ||
+      sizeof(SnapshotHeader) + sizeof(SnapshotEntry) * entryCount > size) {
+    throw std::runtime_error("failed to restore snapshot: size mismatch");
+  }
+  auto actorEntries = reinterpret_cast<SnapshotEntry const *>(data + sizeof(SnapshotHeader));
+  auto articulationEntries = actorEntries + header->actorCount;
+
+  auto values = [&](SnapshotEntry const &entry, uint32_t expected) {
+    if (entry.count != expected ||
+        entry.offset + uint64_t(entry.count + entry.driveCount) * sizeof(PxReal) > size) {
+      throw std::runtime_error("failed to restore snapshot: invalid data for entity " +
+                               std::to_string(entry.id));
+    }
+    return reinterpret_cast<PxReal const *>(data + entry.offset);
+  };
+
+  // entries are usually in scene order, fall back to an id lookup if not
+  std::unordered_map<physx_id_t, SnapshotEntry const *> actorIndex;
+  uint32_t actorCursor = 0;
+  auto findActor = [&](physx_id_t id) -> SnapshotEntry const * {
+    if (actorCursor < header->actorCount && actorEntries[actorCursor].id == id) {
+      return &actorEntries[actorCursor++];
+    }
+    if (actorIndex.empty()) {
+      for (uint32_t i = 0; i < header->actorCount; ++i) {
+        actorIndex[actorEntries[i].id] = &actorEntries[i];
+      }
+    }
+    auto it = actorIndex.find(id);
+    return it == actorIndex.end() ? nullptr : it->second;
+  };
+  auto restoreActor = [&](SActorBase *actor) {
+    if (auto entry = findActor(actor->getId())) {
+      actor->unpackData(values(*entry, actor->getPackedSize()));
+    }
+  };
+  for (auto &actor : mActors) {
+    restoreActor(actor.get());
+  }
+  for (auto &articulation : mKinematicArticulations) {
+    for (auto link : articulation->getBaseLinks()) {
+      restoreActor(link);
+    }
+  }
+
+  std::unordered_map<physx_id_t, SnapshotEntry const *> articulationIndex;
+  uint32_t articulationCursor = 0;
+  for (auto &articulation : mArticulations) {
+    physx_id_t id = articulation->getRootLink()->getId();
+    SnapshotEntry const *entry = nullptr;
+    if (articulationCursor < header->articulationCount &&
+        articulationEntries[articulationCursor].id == id) {
+      entry = &articulationEntries[articulationCursor++];
+    } else {
+      if (articulationIndex.empty()) {
+        for (uint32_t i = 0; i < header->articulationCount; ++i) {
+          articulationIndex[articulationEntries[i].id] = &articulationEntries[i];
+        }
+      }
+      auto it = articulationIndex.find(id);
+      entry = it == articulationIndex.end() ? nullptr : it->second;
+    }
+    if (!entry) {
+      continue;
+    }
+    if (entry->driveCount != articulation->getPackedDriveSize()) {
+      throw std::runtime_error("failed to restore snapshot: invalid data for entity " +
+                               std::to_string(id));
+    }
+    auto state = values(*entry, articulation->getPackedSize());
+    articulation->unpackData(state);
+    articulation->unpackDrive(state + entry->count);
+  }
+  markAllRenderDirty();
+  if (mStateBufferEnabled) {
+    updateStateBuffer();
+  }
+}
+
+void SScene::setSnapshotHistoryCapacity(uint32_t capacity) {
+  mSnapshotHistory.setCapacity(capacity);
+}
+
+void SScene::pushSnapshot() {
+  if (mStepping) {
+    throw std::runtime_error("failed to save snapshot: scene is stepping");
+  }
+  saveSnapshot(mSnapshotHistory.push());
+}
+
+void SScene::rollback(uint32_t steps) {
+  auto &snapshot = mSnapshotHistory.get(steps);
+  restoreSnapshot(snapshot);
+  mSnapshotHistory.pop(steps);
+}
+
+void SScene::enableStateBuffer(bool enable) {
+  mStateBufferEnabled = enable;
+  if (enable) {
+    updateStateBuffer();
+  }
+}
+
+std::shared_ptr<SceneStateBuffer> SScene::getStateBuffer() {
+  if (!mStateBuffer || mStateBufferLayoutDirty) {
+    updateStateBuffer();
+  }
+  return mStateBuffer;
+}
+
+void SScene::rebuildStateBufferLayout() {
+  mStateBufferActors.clear();
+  mStateBufferArticulations.clear();
+  for (auto &actor : mActors) {
+    mStateBufferActors.push_back(actor.get());
+  }
+  for (auto &articulation : mArticulations) {
+    for (auto link : articulation->getBaseLinks()) {
+      mStateBufferActors.push_back(link);
+    }
+    mStateBufferArticulations.push_back(articulation.get());
+  }
+  for (auto &articulation : mKinematicArticulations) {
+    for (auto link : articulation->getBaseLinks()) {
+      mStateBufferActors.push_back(link);
+    }
+  }
+
+  // views handed out earlier keep the old buffer alive
+  auto buffer = std::make_shared<SceneStateBuffer>();
+  buffer->actorCount = mStateBufferActors.size();
+  buffer->articulationCount = mStateBufferArticulations.size();
+  for (auto articulation : mStateBufferArticulations) {
+    buffer->maxDof = std::max(buffer->maxDof, articulation->dof());
+  }
+
+  buffer->actorIds.reserve(buffer->actorCount);
+  for (auto actor : mStateBufferActors) {
+    buffer->actorIds.push_back(actor->getId());
+  }
+  buffer->actorPoses.resize(buffer->actorCount * 7);
+  buffer->actorVelocities.resize(buffer->actorCount * 6);
+
+  for (auto articulation : mStateBufferArticulations) {
+    buffer->articulationIds.push_back(articulation->getRootLink()->getId());
+    buffer->articulationDofs.push_back(articulation->dof());
+  }
+  uint32_t size = buffer->articulationCount * buffer->maxDof;
+  buffer->qpos.resize(size);
+  buffer->qvel.resize(size);
+  buffer->driveTargets.resize(size);
+  buffer->driveVelocityTargets.resize(size);
+
+  mStateBuffer = buffer;
+  mStateBufferLayoutDirty = false;
+}
+
+void SScene::updateStateBuffer() {
+  EASY_FUNCTION("Update State Buffer");
+  if (mStepping) {
+    throw std::runtime_error("failed to update state buffer: scene is stepping");
+  }
+  if (!mStateBuffer || mStateBufferLayoutDirty) {
+    rebuildStateBufferLayout();
+  }
+  auto &buffer = *mStateBuffer;
+
+  for (uint32_t i = 0; i < buffer.actorCount; ++i) {
+    auto actor = mStateBufferActors[i]->getPxActor();
+    auto pose = actor->getGlobalPose();
+    PxReal *p = &buffer.actorPoses[7 * i];
+    p[0] = pose.p.x;
+    p[1] = pose.p.y;
+    p[2] = pose.p.z;
+    p[3] = pose.q.w;
+    p[4] = pose.q.x;
+    p[5] = pose.q.y;
+    p[6] = pose.q.z;
+
+    PxReal *v = &buffer.actorVelocities[6 * i];
+    if (auto body = actor->is<PxRigidBody>()) {
+      auto lv = body->getLinearVelocity();
+      auto av = body->getAngularVelocity();
+      v[0] = lv.x;
+      v[1] = lv.y;
+      v[2] = lv.z;
+      v[3] = av.x;
+      v[4] = av.y;
+      v[5] = av.z;
+    }
+  }
+
+  for (uint32_t i = 0; i < buffer.articulationCount; ++i) {
+    uint32_t offset = i * buffer.maxDof;
+    mStateBufferArticulations[i]->exportState(
+        &buffer.qpos[offset], &buffer.qvel[offset], &buffer.driveTargets[offset],
+        &buffer.driveVelocityTargets[offset]);
+  }
+}
+
 void SScene::setAmbientLight(PxVec3 const &color) {
   mRendererScene->setAmbientLight({color.x, color.y, color.z});
 }
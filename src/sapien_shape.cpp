@@ -1,4 +1,5 @@
 #include "sapien/sapien_shape.h"
+#include "sapien/filter_shader.h"
 #include "sapien/sapien_material.h"
 #include <array>
 #include <stdexcept>
@@ -18,12 +19,34 @@ SCollisionShape::~SCollisionShape() { mPxShape->release(); }
 
 void SCollisionShape::setCollisionGroups(uint32_t group0, uint32_t group1, uint32_t group2,
                                          uint32_t group3) {
-  mPxShape->setSimulationFilterData(PxFilterData(group0, group1, group2, group3));
+  // the contact report bits of group3 are not part of the collision groups, keep them
+  uint32_t report = mPxShape->getSimulationFilterData().word3 & kContactReportMask;
+  mPxShape->setSimulationFilterData(
+      PxFilterData(group0, group1, group2, (group3 & ~kContactReportMask) | report));
 }
 
 std::array<uint32_t, 4> SCollisionShape::getCollisionGroups() const {
   auto data = mPxShape->getSimulationFilterData();
-  return {data.word0, data.word1, data.word2, data.word3};
+  return {data.word0, data.word1, data.word2, data.word3 & ~kContactReportMask};
+}
+
+void SCollisionShape::setContactReportLevel(std::optional<ContactReportLevel> level) {
+  auto data = mPxShape->getSimulationFilterData();
+  data.word3 &= ~kContactReportMask;
+  if (level) {
+    data.word3 |= (static_cast<uint32_t>(*level) + 1) << kContactReportShift;
+  }
+  // changing the filter data makes PhysX filter the pairs of this shape again
+  mPxShape->setSimulationFilterData(data);
+}
+
+std::optional<ContactReportLevel> SCollisionShape::getContactReportLevel() const {
+  uint32_t level =
+      (mPxShape->getSimulationFilterData().word3 & kContactReportMask) >> kContactReportShift;
+  if (!level) {
+    return {};
+  }
+  return static_cast<ContactReportLevel>(level - 1);
 }
 
 void SCollisionShape::setRestOffset(PxReal offset) { mPxShape->setRestOffset(offset); }
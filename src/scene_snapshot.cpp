@@ -0,0 +1,55 @@
+#include "sapien/scene_snapshot.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace sapien {
+
+SnapshotHistory::SnapshotHistory(uint32_t capacity) : mBuffers(capacity) {}
+
+void SnapshotHistory::setCapacity(uint32_t capacity) {
+  uint32_t keep = std::min(capacity, mSize);
+  std::vector<std::vector<uint8_t>> buffers(capacity);
+  // move kept snapshots so that the oldest one lands in slot 0
+  for (uint32_t i = 0; i < keep; ++i) {
+    buffers[keep - 1 - i] = std::move(
+        mBuffers[(mNext + mBuffers.size() - 1 - i) % mBuffers.size()]);
+  }
+  mBuffers = std::move(buffers);
+  mSize = keep;
+  mNext = capacity ? keep % capacity : 0;
+}
+
+std::vector<uint8_t> &SnapshotHistory::push() {
+  if (mBuffers.empty()) {
+    throw std::runtime_error("failed to push snapshot: history capacity is 0");
+  }
+  auto &buffer = mBuffers[mNext];
+  mNext = (mNext + 1) % mBuffers.size();
+  mSize = std::min<uint32_t>(mSize + 1, mBuffers.size());
+  return buffer;
+}
+
+std::vector<uint8_t> const &SnapshotHistory::get(uint32_t index) const {
+  if (index >= mSize) {
+    throw std::out_of_range("snapshot index " + std::to_string(index) +
+                            " is out of range, history holds " + std::to_string(mSize));
+  }
+  return mBuffers[(mNext + mBuffers.size() - 1 - index) % mBuffers.size()];
+}
+
+void SnapshotHistory::pop(uint32_t count) {
+  count = std::min(count, mSize);
+  if (count == 0) {
+    return;
+  }
+  mNext = (mNext + mBuffers.size() - count) % mBuffers.size();
+  mSize -= count;
+}
+
+void SnapshotHistory::clear() {
+  mNext = 0;
+  mSize = 0;
+}
+
+} // namespace sapien
@@ -8,6 +8,7 @@
 #include "sapien/simulation.h"
 
 #include <easy/profiler.h>
+#include <unordered_set>
 
 namespace sapien {
 static PxDefaultAllocator gDefaultAllocatorCallback;
@@ -83,9 +84,7 @@ Simulation::Simulation(uint32_t nthread, PxReal toleranceLength, PxReal toleranc
 }
 
 Simulation::~Simulation() {
-  if (mCpuDispatcher) {
-    mCpuDispatcher->release();
-  }
+  mSharedJobSystem.reset();
   mCooking->release();
   PxCloseExtensions();
   mPhysicsSDK->release();
@@ -107,6 +106,34 @@ std::unique_ptr<SScene> Simulation::createScene(SceneConfig const &config) {
   return std::make_unique<SScene>(this->shared_from_this(), config);
 }
 
+void Simulation::stepScenes(std::vector<SScene *> const &scenes) {
+  EASY_FUNCTION("Step Scenes", profiler::colors::Red);
+  std::unordered_set<SScene *> unique;
+  for (auto scene : scenes) {
+    if (scene->getSimulation().get() != this) {
+      throw std::runtime_error("failed to step scenes: scene is created by another engine");
+    }
+    // PhysX cannot simulate one scene twice at the same time
+    if (!unique.insert(scene).second) {
+      throw std::runtime_error("failed to step scenes: scene is listed more than once");
+    }
+    if (scene->isStepping()) {
+      throw std::runtime_error("failed to step scenes: a step begun by beginStep has not ended");
+    }
+  }
+
+  getSharedJobSystem()->parallelFor(scenes.size(), [&](uint32_t i) {
+    auto scene = scenes[i];
+    scene->prestep();
+    scene->getPxScene()->simulate(scene->getTimestep());
+    scene->waitForResults();
+  });
+
+  for (auto scene : scenes) {
+    scene->emitStepEvent();
+  }
+}
+
 std::shared_ptr<SPhysicalMaterial> Simulation::createPhysicalMaterial(PxReal staticFriction,
                                                                       PxReal dynamicFriction,
                                                                       PxReal restitution) const {
@@ -149,6 +176,24 @@ void Simulation::setRenderer(std::shared_ptr<Renderer::IPxrRenderer> renderer) {
   mRenderer = renderer;
 }
 
+void Simulation::setThreadAffinityMask(uint64_t mask) {
+  std::lock_guard lock(mSharedJobSystemMutex);
+  if (mSharedJobSystem) {
+    spdlog::get("SAPIEN")->warn(
+        "Thread affinity is ignored: the shared worker pool has already been created.");
+    return;
+  }
+  mThreadAffinityMask = mask;
+}
+
+std::shared_ptr<JobSystem> Simulation::getSharedJobSystem() {
+  std::lock_guard lock(mSharedJobSystemMutex);
+  if (!mSharedJobSystem) {
+    mSharedJobSystem = std::make_shared<JobSystem>(mThreadCount, mThreadAffinityMask);
+  }
+  return mSharedJobSystem;
+}
+
 void Simulation::setLogLevel(std::string const &level) {
   if (level == "debug") {
     spdlog::get("SAPIEN")->set_level(spdlog::level::debug);
@@ -15,32 +15,13 @@ void DefaultEventCallback::onContact(const PxContactPairHeader &pairHeader,
     if (!a0 || !a1) {
       continue;
     }
-
-    std::unique_ptr<SContact> contact = std::make_unique<SContact>();
-    contact->actors[0] = static_cast<SActorBase *>(a0);
-    contact->actors[1] = static_cast<SActorBase *>(a1);
-    contact->collisionShapes[0] = static_cast<SCollisionShape *>(pairs[i].shapes[0]->userData);
-    contact->collisionShapes[1] = static_cast<SCollisionShape *>(pairs[i].shapes[1]->userData);
-
-    contact->starts = pairs[i].events & PxPairFlag::eNOTIFY_TOUCH_FOUND;
-    contact->ends = pairs[i].events & PxPairFlag::eNOTIFY_TOUCH_LOST;
-    contact->persists = pairs[i].events & PxPairFlag::eNOTIFY_TOUCH_PERSISTS;
-
-    std::vector<PxContactPairPoint> points(pairs[i].contactCount);
-    pairs[i].extractContacts(points.data(), pairs[i].contactCount);
-
-    for (auto &p : points) {
-      contact->points.push_back({p.position, p.normal, p.impulse, p.separation});
+    // shapes of destroyed actors, their contacts are cleared when the actor is removed
+    if (pairs[i].flags &
+        (PxContactPairFlag::eREMOVED_SHAPE_0 | PxContactPairFlag::eREMOVED_SHAPE_1)) {
+      continue;
     }
-    EventActorContact event;
-    event.self = contact->actors[0];
-    event.other = contact->actors[1];
-    event.contact = contact.get();
-    contact->actors[0]->EventEmitter<EventActorContact>::emit(event);
-    event.self = contact->actors[1];
-    event.other = contact->actors[0];
-    contact->actors[1]->EventEmitter<EventActorContact>::emit(event);
-    mScene->updateContact(std::move(contact));
+
+    mScene->getContactBuffer().addContact(pairHeader, pairs[i]);
   }
 }
 
@@ -59,6 +59,189 @@ class TestArticulation(unittest.TestCase):
         for j, v in zip(robot.get_active_joints(), q):
             self.assertTrue(np.allclose(j.get_drive_target(), v))
 
+    def test_batched_state(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        loader = scene.create_urdf_loader()
+        path = os.path.join(os.path.dirname(__file__), "movo_simple.urdf")
+        robots = [loader.load(path) for _ in range(3)]
+
+        for i, robot in enumerate(robots):
+            robot.set_qpos(np.full(robot.dof, 0.1 * i))
+            robot.set_qvel(np.full(robot.dof, 0.2 * i))
+
+        state = robots[2].get_state(["qvel", "qpos"])
+        self.assertEqual(state.shape, (2, robots[2].dof))
+        self.assertTrue(np.allclose(state[0], robots[2].get_qpos()))
+        self.assertTrue(np.allclose(state[1], robots[2].get_qvel()))
+
+        states = scene.get_articulation_states(robots, ["qpos", "qvel"])
+        self.assertEqual(states.shape, (3, 2, robots[0].dof))
+        for robot, s in zip(robots, states):
+            self.assertTrue(np.allclose(s[0], robot.get_qpos()))
+            self.assertTrue(np.allclose(s[1], robot.get_qvel()))
+
+        out = np.zeros_like(states)
+        scene.set_articulation_states(robots, ["qpos", "qvel"], states[::-1].copy())
+        scene.get_articulation_states(robots, ["qpos", "qvel"], out=out)
+        self.assertTrue(np.allclose(out, states[::-1]))
+
+        # out is written in place, arrays that would need a copy are rejected
+        with self.assertRaises(RuntimeError):
+            scene.get_articulation_states(robots, ["qpos", "qvel"], out=out.astype(np.float64))
+        with self.assertRaises(RuntimeError):
+            strided = np.zeros((1, 2 * robots[0].dof), np.float32)[:, ::2]
+            robots[0].get_state(["qpos"], out=strided)
+        with self.assertRaises(RuntimeError):
+            robots[0].get_state(["qpos"], out=np.zeros((1, robots[0].dof), np.float64))
+
+    def test_drive_command(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        loader = scene.create_urdf_loader()
+        path = os.path.join(os.path.dirname(__file__), "movo_simple.urdf")
+        robots = [loader.load(path) for _ in range(2)]
+        dof = robots[0].dof
+
+        target = np.linspace(-0.5, 0.5, 2 * dof).reshape(2, dof)
+        velocity = -target
+        scene.set_drive_commands(
+            robots, target=target, velocity_target=velocity, stiffness=np.full((2, dof), 100)
+        )
+        for robot, t, v in zip(robots, target, velocity):
+            self.assertTrue(np.allclose(robot.get_drive_target(), t))
+            self.assertTrue(np.allclose(robot.get_drive_velocity_target(), v))
+            for joint in robot.get_active_joints():
+                self.assertAlmostEqual(joint.stiffness, 100)
+
+        robots[0].set_drive_command(target=np.zeros(dof))
+        self.assertTrue(np.allclose(robots[0].get_drive_target(), 0))
+        self.assertTrue(np.allclose(robots[0].get_drive_velocity_target(), velocity[0]))
+        with self.assertRaises(RuntimeError):
+            robots[0].set_drive_command(target=np.zeros(dof + 1))
+
+    def test_kinematics_bundle(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        loader = scene.create_urdf_loader()
+        robot = loader.load(os.path.join(os.path.dirname(__file__), "movo_simple.urdf"))
+        robot.set_qpos(np.full(robot.dof, 0.1))
+
+        jacobian, mass, passive = robot.get_kinematics_bundle()
+        self.assertTrue(np.allclose(jacobian, robot.compute_world_cartesian_jacobian()))
+        self.assertTrue(np.allclose(mass, robot.compute_manipulator_inertia_matrix()))
+        self.assertTrue(np.allclose(passive, robot.compute_passive_force(external=False)))
+        self.assertFalse(jacobian.flags.writeable)
+
+        old_mass = mass.copy()
+        robot.set_qpos(np.full(robot.dof, 0.5))
+        self.assertFalse(np.allclose(robot.compute_manipulator_inertia_matrix(), old_mass))
+        robot.get_kinematics_bundle()
+        self.assertTrue(np.allclose(mass, robot.compute_manipulator_inertia_matrix()))
+
+        robot.mark_kinematics_dirty()
+        jacobian, mass, passive = robot.get_kinematics_bundle()
+        self.assertTrue(np.allclose(mass, robot.compute_manipulator_inertia_matrix()))
+
+    def test_pinocchio_batch(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        loader = scene.create_urdf_loader()
+        robot = loader.load(os.path.join(os.path.dirname(__file__), "movo_simple.urdf"))
+        model = robot.create_pinocchio_model()
+        model.batch_thread_count = 2
+
+        limits = np.clip(robot.get_qlimits(), -np.pi, np.pi)
+        qpos = np.random.uniform(limits[:, 0], limits[:, 1], (5, robot.dof))
+        poses = model.compute_forward_kinematics_batch(qpos)
+        jacobians = model.compute_link_jacobian_batch(qpos, 3)
+        tau = model.compute_inverse_dynamics_batch(qpos, np.zeros_like(qpos), np.zeros_like(qpos))
+        self.assertEqual(poses.shape, (5, len(robot.get_links()), 7))
+        self.assertEqual(jacobians.shape, (5, 6, robot.dof))
+
+        for i, q in enumerate(qpos):
+            model.compute_forward_kinematics(q)
+            pose = model.get_link_pose(3)
+            self.assertTrue(np.allclose(poses[i, 3, :3], pose.p))
+            self.assertTrue(np.allclose(np.abs(poses[i, 3, 3:] @ pose.q), 1))
+            model.compute_full_jacobian(q)
+            self.assertTrue(np.allclose(jacobians[i], model.get_link_jacobian(3)))
+            zero = np.zeros(robot.dof)
+            self.assertTrue(np.allclose(tau[i], model.compute_inverse_dynamics(q, zero, zero)))
+
+    def test_pinocchio_derivatives(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        loader = scene.create_urdf_loader()
+        robot = loader.load(os.path.join(os.path.dirname(__file__), "movo_simple.urdf"))
+        model = robot.create_pinocchio_model()
+
+        limits = np.clip(robot.get_qlimits(), -np.pi, np.pi)
+        qpos = np.random.uniform(limits[:, 0], limits[:, 1], (3, robot.dof))
+        qvel = np.random.randn(3, robot.dof)
+        qacc = np.random.randn(3, robot.dof)
+
+        dq, dv, da = model.compute_inverse_dynamics_derivatives(qpos[0], qvel[0], qacc[0])
+        self.assertTrue(np.allclose(da, model.compute_generalized_mass_matrix(qpos[0])))
+        eps = 1e-6
+        for j in range(robot.dof):
+            delta = np.zeros(robot.dof)
+            delta[j] = eps
+            tau1 = model.compute_inverse_dynamics(qpos[0] + delta, qvel[0], qacc[0])
+            tau0 = model.compute_inverse_dynamics(qpos[0] - delta, qvel[0], qacc[0])
+            self.assertTrue(np.allclose((tau1 - tau0) / (2 * eps), dq[:, j], atol=1e-4))
+            tau1 = model.compute_inverse_dynamics(qpos[0], qvel[0] + delta, qacc[0])
+            tau0 = model.compute_inverse_dynamics(qpos[0], qvel[0] - delta, qacc[0])
+            self.assertTrue(np.allclose((tau1 - tau0) / (2 * eps), dv[:, j], atol=1e-4))
+
+        _, dv_dqvel = model.compute_link_velocity_derivatives(qpos[0], qvel[0], 3)
+        model.compute_full_jacobian(qpos[0])
+        self.assertTrue(np.allclose(dv_dqvel, model.get_link_jacobian(3)))
+
+        qf = model.compute_inverse_dynamics_batch(qpos, qvel, qacc)
+        batch = model.compute_forward_dynamics_derivatives_batch(qpos, qvel, qf)
+        self.assertEqual(batch[0].shape, (3, robot.dof, robot.dof))
+        for i in range(3):
+            single = model.compute_forward_dynamics_derivatives(qpos[i], qvel[i], qf[i])
+            for b, s in zip(batch, single):
+                self.assertTrue(np.allclose(b[i], s))
+        batch = model.compute_inverse_dynamics_derivatives_batch(qpos, qvel, qacc)
+        self.assertTrue(np.allclose(batch[0][0], dq))
+
+    def test_pinocchio_multi_seed_ik(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        loader = scene.create_urdf_loader()
+        robot = loader.load(os.path.join(os.path.dirname(__file__), "movo_simple.urdf"))
+        model = robot.create_pinocchio_model()
+        model.batch_thread_count = 2
+
+        qlimits = robot.get_qlimits()
+        limits = np.clip(qlimits, -np.pi, np.pi)
+        sources = np.random.uniform(limits[:, 0], limits[:, 1], (4, robot.dof))
+        targets = []
+        for q in sources:
+            model.compute_forward_kinematics(q)
+            targets.append(model.get_link_pose(3))
+
+        # the first seed of every target is the configuration of the first target
+        qpos, success, error = model.compute_inverse_kinematics_multi_seed(
+            3, targets, 8, initial_qpos=sources[0]
+        )
+        self.assertEqual(qpos.shape, (4, robot.dof))
+        self.assertEqual(error.shape, (4, 6))
+        self.assertTrue(success[0])
+        self.assertGreaterEqual(success.sum(), 3)
+        self.assertTrue(np.all(qpos >= qlimits[:, 0] - 1e-6))
+        self.assertTrue(np.all(qpos <= qlimits[:, 1] + 1e-6))
+        for i, q in enumerate(qpos):
+            if not success[i]:
+                continue
+            self.assertLess(np.linalg.norm(error[i]), 1e-4)
+            model.compute_forward_kinematics(q)
+            pose = model.get_link_pose(3)
+            self.assertTrue(np.allclose(pose.p, targets[i].p, atol=1e-3))
+            self.assertTrue(np.allclose(np.abs(pose.q @ targets[i].q), 1, atol=1e-3))
 
     def test_urdf_loader(self):
         engine = sapien.Engine()
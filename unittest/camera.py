@@ -159,3 +159,72 @@ class TestCamera(unittest.TestCase):
         self.assertTrue(np.allclose(model, gt_model))
         self.assertTrue(np.allclose(proj, gt_proj))
         self.assertTrue(np.allclose(extrinsic, gt_extrinsic))
+
+    def test_render_sync(self):
+        engine = sapien.Engine()
+        renderer = sapien.SapienRenderer(True)
+        engine.set_renderer(renderer)
+        config = sapien.SceneConfig()
+        config.gravity = [0, 0, 0]
+        scene = engine.create_scene(config)
+        scene.set_timestep(0.01)
+
+        cam = scene.add_camera("", 32, 32, 1.0, 0.01, 10)
+
+        def visible(actor):
+            scene.update_render()
+            cam.take_picture()
+            seg = cam.get_uint32_texture("Segmentation")[..., 1]
+            return np.any(seg == actor.id)
+
+        b = scene.create_actor_builder()
+        b.add_box_collision(half_size=[0.1, 0.1, 0.1])
+        b.add_box_visual(half_size=[0.1, 0.1, 0.1])
+        teleported = b.build_kinematic()
+        teleported.set_pose(sapien.Pose([-2, 0, 0]))
+        moving = b.build()
+        moving.set_pose(sapien.Pose([1, -0.3, 1.3]))
+        self.assertFalse(visible(teleported))
+        self.assertFalse(visible(moving))
+
+        # teleported bodies are synchronized without a step
+        teleported.set_pose(sapien.Pose([1, 0, 0.3]))
+        self.assertTrue(visible(teleported))
+
+        # simulated bodies are synchronized after the step
+        moving.set_velocity([0, 0, -100])
+        scene.step()
+        self.assertTrue(visible(moving))
+        self.assertTrue(visible(teleported))
+
+
+    def test_null_renderer(self):
+        engine = sapien.Engine()
+        renderer = sapien.NullRenderer()
+        engine.set_renderer(renderer)
+        scene = engine.create_scene()
+        scene.set_timestep(0.01)
+
+        width, height = 40, 30
+        cam = scene.add_camera("", width, height, 1.0, 0.1, 10)
+        self.assertTrue(np.allclose(cam.fovy, 1.0))
+        self.assertTrue(np.allclose(cam.cx, width / 2))
+        self.assertTrue(np.allclose(cam.cy, height / 2))
+
+        b = scene.create_actor_builder()
+        b.add_box_collision(half_size=[0.1, 0.1, 0.1])
+        b.add_box_visual(half_size=[0.1, 0.1, 0.1], color=[1, 0, 0])
+        box = b.build()
+        box.set_pose(sapien.Pose([0, 0, 1]))
+        self.assertEqual(len(box.get_visual_bodies()), 1)
+
+        scene.step()
+        scene.update_render()
+        cam.take_picture()
+
+        color = cam.get_float_texture("Color")
+        self.assertEqual(color.shape, (height, width, 4))
+        self.assertEqual(color.dtype, np.float32)
+        seg = cam.get_uint32_texture("Segmentation")
+        self.assertEqual(seg.shape, (height, width, 4))
+        self.assertEqual(seg.dtype, np.uint32)
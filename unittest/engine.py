@@ -1,3 +1,7 @@
+import os
+import shutil
+import tempfile
+import threading
 import unittest
 import sapien.core as sapien
 
@@ -21,3 +25,82 @@ class TestEngine(unittest.TestCase):
         self.assertAlmostEqual(mat.dynamic_friction, 0.14)
         self.assertAlmostEqual(mat.restitution, 0.45)
         # TODO: invalid value validation?
+
+    def _load_convex(self, filename):
+        # a new engine starts with an empty mesh registry and reads the cooked cache from disk
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        builder = scene.create_actor_builder()
+        builder.add_convex_collision_from_file(filename)
+        return len(builder.build().get_collision_shapes())
+
+    def test_cooked_mesh_cache(self):
+        assets = os.path.join(os.path.dirname(__file__), "assets")
+        with tempfile.TemporaryDirectory() as d:
+            filename = os.path.join(d, "mesh.stl")
+            shutil.copy(os.path.join(assets, "cone.stl"), filename)
+            cache = filename + ".convex.pxc"
+
+            self.assertEqual(self._load_convex(filename), 1)
+            self.assertTrue(os.path.isfile(cache))
+            # no temporary files are left behind
+            self.assertEqual([f for f in os.listdir(d) if f.startswith("mesh.stl.convex.pxc")],
+                             ["mesh.stl.convex.pxc"])
+
+            # a valid cache is read, not written again
+            inode = os.stat(cache).st_ino
+            self.assertEqual(self._load_convex(filename), 1)
+            self.assertEqual(os.stat(cache).st_ino, inode)
+
+            # a changed source file makes the cache stale
+            shutil.copy(os.path.join(assets, "torus.stl"), filename)
+            self.assertEqual(self._load_convex(filename), 1)
+            self.assertNotEqual(os.stat(cache).st_ino, inode)
+
+            # a corrupted payload fails the checksum and the mesh is cooked again
+            inode = os.stat(cache).st_ino
+            with open(cache, "r+b") as f:
+                f.seek(-1, os.SEEK_END)
+                last = f.read(1)
+                f.seek(-1, os.SEEK_END)
+                f.write(bytes([last[0] ^ 0xFF]))
+            self.assertEqual(self._load_convex(filename), 1)
+            self.assertNotEqual(os.stat(cache).st_ino, inode)
+            self.assertEqual(self._load_convex(filename), 1)
+
+            # a truncated cache is cooked again
+            inode = os.stat(cache).st_ino
+            with open(cache, "r+b") as f:
+                f.truncate(os.path.getsize(cache) // 2)
+            self.assertEqual(self._load_convex(filename), 1)
+            self.assertNotEqual(os.stat(cache).st_ino, inode)
+
+    def test_concurrent_preload(self):
+        assets = os.path.join(os.path.dirname(__file__), "assets")
+        with tempfile.TemporaryDirectory() as d:
+            filename = os.path.join(d, "mesh.stl")
+            shutil.copy(os.path.join(assets, "cone.stl"), filename)
+
+            engine = sapien.Engine()
+            engine.cooked_mesh_cache_enabled = False
+            engine.mesh_loader_thread_count = 4
+            threads = [
+                threading.Thread(target=engine.preload_meshes, args=([filename] * 4,))
+                for _ in range(4)
+            ]
+            for t in threads:
+                t.start()
+            for t in threads:
+                t.join()
+            self.assertEqual(engine.loaded_mesh_count, 1)
+
+            # a build looks the mesh up instead of loading it again
+            builder = engine.create_scene().create_actor_builder()
+            builder.add_convex_collision_from_file(filename)
+            builder.build()
+            self.assertEqual(engine.loaded_mesh_count, 1)
+
+            engine.preload_meshes([filename], "nonconvex")
+            self.assertEqual(engine.loaded_mesh_count, 2)
+            with self.assertRaises(RuntimeError):
+                engine.preload_meshes([filename], "unknown")
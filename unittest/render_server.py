@@ -0,0 +1,199 @@
+import mmap
+import os
+import struct
+import sys
+import unittest
+
+import numpy as np
+import sapien.core as sapien
+
+
+@unittest.skipUnless(sys.platform.startswith("linux"), "shared memory ring needs /dev/shm")
+class TestSharedFrameRing(unittest.TestCase):
+    def setUp(self):
+        self.name = "/sapien_test_ring_{}".format(os.getpid())
+        self.producer = sapien._SharedFrameRing.create(self.name, 1024)
+        self.consumer = sapien._SharedFrameRing.open(self.name)
+
+    def tearDown(self):
+        self.producer.unlink()
+
+    def test_producer_consumer(self):
+        self.assertIsNone(self.consumer.pop(timeout=0.001))
+
+        poses = np.arange(14, dtype=np.float32).reshape(2, 7)
+        self.assertTrue(self.producer.push(1, poses))
+        self.assertTrue(self.producer.push(2, poses[1:] + 1, body_indices=[1]))
+
+        frame, full, body_poses, body_indices = self.consumer.pop()
+        self.assertEqual(frame, 1)
+        self.assertTrue(full)
+        self.assertTrue(np.array_equal(body_poses, poses))
+        self.consumer.release()
+        self.assertTrue(self.producer.wait_ack(1))
+
+        frame, full, body_poses, body_indices = self.consumer.pop()
+        self.assertEqual(frame, 2)
+        self.assertFalse(full)
+        self.assertEqual(body_indices.tolist(), [1])
+        self.assertTrue(np.array_equal(body_poses, poses[1:] + 1))
+        self.consumer.release()
+        self.assertTrue(self.producer.wait_ack(2))
+
+    def test_wrap_around(self):
+        # frames of different sizes wrap the ring many times
+        for frame in range(1, 200):
+            poses = np.full((frame % 5 + 1, 7), frame, dtype=np.float32)
+            self.assertTrue(self.producer.push(frame, poses))
+            result = self.consumer.pop()
+            self.assertEqual(result[0], frame)
+            self.assertTrue(np.array_equal(result[2], poses))
+            self.consumer.release()
+            self.assertTrue(self.producer.wait_ack(frame))
+
+    def test_full_ring(self):
+        poses = np.zeros((3, 7), dtype=np.float32)
+        # a frame larger than the ring never fits
+        self.assertFalse(self.producer.push(1, np.zeros((100, 7), dtype=np.float32)))
+
+        count = 0
+        with self.assertRaises(RuntimeError):
+            while True:
+                self.producer.push(count + 1, poses, timeout=0.001)
+                count += 1
+        self.assertGreater(count, 0)
+
+        # freeing one frame makes room for the next
+        self.assertEqual(self.consumer.pop()[0], 1)
+        self.consumer.release()
+        self.assertTrue(self.producer.push(count + 1, poses, timeout=0.001))
+        for frame in range(2, count + 2):
+            self.assertEqual(self.consumer.pop()[0], frame)
+            self.consumer.release()
+
+    def test_corrupt_record(self):
+        poses = np.zeros((2, 7), dtype=np.float32)
+        self.assertTrue(self.producer.push(1, poses))
+
+        # claim more bodies than the record holds
+        with open("/dev/shm" + self.name, "r+b") as f:
+            data = mmap.mmap(f.fileno(), 0)
+            struct.pack_into("I", data, sapien._SharedFrameRing.data_offset + 24, 1 << 20)
+            data.close()
+
+        with self.assertRaises(RuntimeError):
+            self.consumer.pop()
+        self.assertTrue(self.consumer.closed)
+        with self.assertRaises(RuntimeError):
+            self.producer.wait_ack(1)
+
+    def test_delta_round_trip(self):
+        # the server applies every frame to its copy of the poses and ends up with the client's
+        rng = np.random.default_rng(0)
+        client = rng.standard_normal((20, 7)).astype(np.float32)
+        sent = np.zeros((0, 7), dtype=np.float32)
+        server = None
+        for frame in range(1, 30):
+            if frame == 15:
+                client = np.concatenate([client, client[:3]])
+            else:
+                moved = rng.choice(len(client), frame % 4, replace=False)
+                client[moved] += 1
+            full, poses, indices = sapien._encode_body_poses(client, sent)
+            self.assertTrue(self.producer.push(frame, poses, None if full else indices))
+
+            frame_id, full, poses, indices = self.consumer.pop()
+            self.assertEqual(frame_id, frame)
+            body_count = len(client) if server is None or full else len(server)
+            self.assertEqual(
+                sapien._check_body_poses(body_count, poses, None if full else indices), ""
+            )
+            if full:
+                server = poses.copy()
+            else:
+                server[indices] = poses
+            self.consumer.release()
+            self.assertTrue(self.producer.wait_ack(frame))
+            self.assertTrue(np.array_equal(server, client))
+            sent = client.copy()
+
+
+class TestDeltaFrame(unittest.TestCase):
+    def test_encode(self):
+        poses = np.arange(21, dtype=np.float32).reshape(3, 7)
+
+        # the first frame and frames after the body count changes are full
+        full, body_poses, body_indices = sapien._encode_body_poses(poses, np.zeros((0, 7)))
+        self.assertTrue(full)
+        self.assertTrue(np.array_equal(body_poses, poses))
+        self.assertEqual(len(body_indices), 0)
+        full, _, _ = sapien._encode_body_poses(poses, poses[:2])
+        self.assertTrue(full)
+
+        # unchanged poses are not sent
+        full, body_poses, body_indices = sapien._encode_body_poses(poses, poses)
+        self.assertFalse(full)
+        self.assertEqual(len(body_poses), 0)
+        self.assertEqual(len(body_indices), 0)
+
+        moved = poses.copy()
+        moved[2, 6] = -1
+        full, body_poses, body_indices = sapien._encode_body_poses(moved, poses)
+        self.assertFalse(full)
+        self.assertEqual(body_indices.tolist(), [2])
+        self.assertTrue(np.array_equal(body_poses, moved[2:]))
+
+    def test_check(self):
+        poses = np.zeros((2, 7), dtype=np.float32)
+        self.assertEqual(sapien._check_body_poses(2, poses), "")
+        self.assertEqual(sapien._check_body_poses(5, poses, [0, 4]), "")
+        self.assertNotEqual(sapien._check_body_poses(3, poses), "")
+        self.assertNotEqual(sapien._check_body_poses(5, poses, [0]), "")
+        self.assertNotEqual(sapien._check_body_poses(4, poses, [0, 4]), "")
+
+
+class TestRenderClient(unittest.TestCase):
+    def setUp(self):
+        self.address = "localhost:{}".format(20000 + os.getpid() % 10000)
+        try:
+            self.server = sapien.RenderServer()
+        except RuntimeError as e:
+            self.skipTest("render server unavailable: {}".format(e))
+        self.server.start(self.address)
+
+    def tearDown(self):
+        self.server.stop()
+
+    def test_scene_batches(self):
+        engine = sapien.Engine()
+        engine.set_renderer(
+            sapien.RenderClient(self.address, 0, shared_memory=False, max_frames_in_flight=2)
+        )
+        scene = engine.create_scene()
+        camera = scene.add_camera("camera", 32, 32, 1.0, 0.01, 10)
+
+        # more calls than one batch holds, so the scene is built over several batches
+        actors = []
+        for i in range(200):
+            builder = scene.create_actor_builder()
+            material = engine.renderer.create_material()
+            material.base_color = [i / 200, 0, 0, 1]
+            builder.add_box_visual(half_size=[0.1, 0.1, 0.1], material=material)
+            actor = builder.build_kinematic()
+            actor.set_pose(sapien.Pose([i, 0, 0]))
+            actors.append(actor)
+        # reading server state flushes the queued calls first
+        for actor in actors[::50]:
+            self.assertEqual(len(actor.get_visual_bodies()[0].get_render_shapes()), 1)
+
+        for actor in actors[::3]:
+            scene.remove_actor(actor)
+        for frame in range(5):
+            for actor in actors[1::3]:
+                actor.set_pose(sapien.Pose([frame, 1, 0]))
+            scene.step()
+            scene._update_render_and_take_pictures([camera])
+        engine.renderer.synchronize()
+        self.server.wait_all()
+        for actor in actors[1::50]:
+            self.assertEqual(len(actor.get_visual_bodies()[0].get_render_shapes()), 1)
@@ -1,3 +1,4 @@
+import os
 import unittest
 import sapien.core as sapien
 from common import *
@@ -28,6 +29,10 @@ class TestScene(unittest.TestCase):
         config.enable_friction_every_iteration = False
         config.enable_adaptive_force = True
         config.disable_collision_visual = True
+        config.thread_count = 2
+        config.share_thread_pool = False
+        # CPUs above 31 must fit in the mask
+        config.thread_affinity_mask = (1 << 40) | 1
         scene = engine.create_scene(config)
         config1 = scene.get_config()
 
@@ -47,6 +52,367 @@ class TestScene(unittest.TestCase):
         self.assertEqual(config.enable_friction_every_iteration, False)
         self.assertEqual(config.enable_adaptive_force, True)
         self.assertEqual(config.disable_collision_visual, True)
+        self.assertEqual(config.thread_count, 2)
+        self.assertEqual(config.share_thread_pool, False)
+        self.assertEqual(config.thread_affinity_mask, (1 << 40) | 1)
+
+    def test_shared_thread_pool(self):
+        engine = sapien.Engine(thread_count=2)
+        config = sapien.SceneConfig()
+        config.share_thread_pool = True
+        scene0 = engine.create_scene(config)
+        scene1 = engine.create_scene(config)
+        scene0.step()
+        scene1.step()
+
+    def test_step_scenes(self):
+        # with the default thread count the scenes would be stepped on this thread only
+        engine = sapien.Engine(thread_count=4)
+        scenes = [engine.create_scene() for _ in range(4)]
+        actors = []
+        step_counts = [0] * len(scenes)
+        contact_counts = [0] * len(scenes)
+
+        def on_step(i):
+            def callback(actor, time):
+                step_counts[i] += 1
+
+            return callback
+
+        def on_contact(i):
+            def callback(actor, other, contact):
+                contact_counts[i] += 1
+
+            return callback
+
+        for i, scene in enumerate(scenes):
+            scene.add_ground(0, render=False)
+            builder = scene.create_actor_builder()
+            builder.add_box_collision(half_size=[0.1, 0.1, 0.1])
+            actor = builder.build()
+            actor.set_pose(sapien.Pose([0, 0, 1]))
+            actor.on_step(on_step(i))
+            actors.append(actor)
+
+        for _ in range(10):
+            engine.step_scenes(scenes)
+        for actor in actors:
+            self.assertLess(actor.pose.p[2], 1)
+            self.assertAlmostEqual(actor.pose.p[2], actors[0].pose.p[2])
+        self.assertEqual(step_counts, [10] * len(scenes))
+
+        # let the boxes land, then every scene reports the same contacts
+        for i, actor in enumerate(actors):
+            actor.set_pose(sapien.Pose([0, 0, 0.1]))
+            actor.on_contact(on_contact(i))
+        for _ in range(5):
+            engine.step_scenes(scenes)
+        self.assertGreater(contact_counts[0], 0)
+        self.assertEqual(contact_counts, [contact_counts[0]] * len(scenes))
+
+        with self.assertRaises(RuntimeError):
+            engine.step_scenes([scenes[0], scenes[1], scenes[0]])
+        scenes[1].begin_step()
+        with self.assertRaises(RuntimeError):
+            engine.step_scenes(scenes)
+        scenes[1].end_step()
+        engine.step_scenes(scenes)
+
+    def test_begin_end_step(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        builder = scene.create_actor_builder()
+        builder.add_box_collision(half_size=[0.1, 0.1, 0.1])
+        actor = builder.build()
+        actor.set_pose(sapien.Pose([0, 0, 1]))
+
+        scene.begin_step()
+        self.assertTrue(scene.is_stepping)
+        self.assertAlmostEqual(actor.pose.p[2], 1)
+        with self.assertRaises(RuntimeError):
+            scene.step()
+        scene.end_step()
+        self.assertFalse(scene.is_stepping)
+        self.assertLess(actor.pose.p[2], 1)
+
+    def test_state_buffer(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        builder = scene.create_actor_builder()
+        builder.add_box_collision(half_size=[0.1, 0.1, 0.1])
+        actor = builder.build()
+        actor.set_pose(sapien.Pose([0, 0, 1]))
+
+        scene.enable_state_buffer()
+        buffer = scene.get_state_buffer()
+        self.assertEqual(buffer.actor_count, 1)
+        self.assertEqual(buffer.actor_ids[0], actor.get_id())
+        poses = buffer.actor_poses
+        self.assertEqual(poses.shape, (1, 7))
+        self.assertAlmostEqual(poses[0, 2], 1)
+
+        scene.step()
+        self.assertAlmostEqual(poses[0, 2], actor.pose.p[2])
+        self.assertLess(buffer.actor_velocities[0, 2], 0)
+
+        builder.build()
+        buffer2 = scene.get_state_buffer()
+        self.assertEqual(buffer2.actor_count, 2)
+        self.assertEqual(buffer.actor_count, 1)
+
+    def test_snapshot(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        builder = scene.create_actor_builder()
+        builder.add_box_collision(half_size=[0.1, 0.1, 0.1])
+        actor = builder.build()
+        actor.set_pose(sapien.Pose([0, 0, 1]))
+
+        snapshot = scene.save_snapshot()
+        for _ in range(10):
+            scene.step()
+        self.assertLess(actor.pose.p[2], 1)
+        scene.restore_snapshot(snapshot)
+        self.assertAlmostEqual(actor.pose.p[2], 1)
+        self.assertAlmostEqual(actor.velocity[2], 0)
+
+        with self.assertRaises(RuntimeError):
+            scene.restore_snapshot(b"not a snapshot" * 4)
+        data = np.frombuffer(snapshot, dtype=np.uint8)
+        with self.assertRaises(RuntimeError):
+            scene.restore_snapshot(np.stack([data, data], 1)[:, 0])
+
+        # the state buffer follows a restore without waiting for the next step
+        scene.enable_state_buffer()
+        poses = scene.get_state_buffer().actor_poses
+        scene.step()
+        self.assertLess(poses[0, 2], 1)
+        scene.restore_snapshot(data)
+        self.assertAlmostEqual(poses[0, 2], 1)
+        scene.enable_state_buffer(False)
+
+        scene.snapshot_history_capacity = 4
+        heights = []
+        for _ in range(6):
+            scene.push_snapshot()
+            heights.append(actor.pose.p[2])
+            scene.step()
+        self.assertEqual(scene.snapshot_history_size, 4)
+        scene.rollback(2)
+        self.assertAlmostEqual(actor.pose.p[2], heights[-3])
+        self.assertEqual(scene.snapshot_history_size, 2)
+
+    def test_contacts(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        scene.add_ground(0, render=False)
+        builder = scene.create_actor_builder()
+        builder.add_box_collision(half_size=[0.1, 0.1, 0.1])
+        actor = builder.build()
+        actor.set_pose(sapien.Pose([0, 0, 0.1]))
+
+        for _ in range(5):
+            scene.step()
+        contacts = scene.get_contacts()
+        self.assertGreater(len(contacts), 0)
+        pairs, points = scene.get_contact_arrays()
+        self.assertEqual(len(pairs), len(contacts))
+        self.assertIn(actor.get_id(), (pairs[0]["actor0"], pairs[0]["actor1"]))
+        self.assertEqual(pairs["point_count"].sum(), len(points))
+        self.assertEqual(len(contacts[0].points), pairs[0]["point_count"])
+
+        # returned contacts are copies and outlive the step that reported them
+        positions = [p.position for p in contacts[0].points]
+        scene.remove_actor(actor)
+        scene.step()
+        self.assertEqual(len(scene.get_contacts()), 0)
+        self.assertEqual(len(contacts[0].points), len(positions))
+        for p, q in zip(contacts[0].points, positions):
+            self.assertTrue(np.array_equal(p.position, q))
+
+    def test_contact_report_level(self):
+        engine = sapien.Engine()
+        config = sapien.SceneConfig()
+        config.contact_report_level = "none"
+        scene = engine.create_scene(config)
+        self.assertEqual(scene.contact_report_level, "none")
+        scene.add_ground(0, render=False)
+        builder = scene.create_actor_builder()
+        builder.add_box_collision(half_size=[0.1, 0.1, 0.1])
+        actor = builder.build()
+        actor.set_pose(sapien.Pose([0, 0, 0.1]))
+
+        for _ in range(5):
+            scene.step()
+        self.assertEqual(len(scene.get_contacts()), 0)
+
+        actor.contact_report_level = "touch"
+        self.assertEqual(actor.contact_report_level, "touch")
+        for _ in range(5):
+            scene.step()
+        contacts = scene.get_contacts()
+        self.assertGreater(len(contacts), 0)
+        self.assertEqual(len(contacts[0].points), 0)
+
+        actor.contact_report_level = None
+        scene.set_group_contact_report_level(1, "points")
+        self.assertEqual(scene.get_group_contact_report_level(1), "points")
+        for _ in range(5):
+            scene.step()
+        self.assertGreater(len(scene.get_contacts()[0].points), 0)
+        with self.assertRaises(RuntimeError):
+            scene.set_group_contact_report_level(33, "touch")
+
+    def test_remove_actors(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        builder = scene.create_actor_builder()
+        builder.add_box_collision(half_size=[0.1, 0.1, 0.1])
+        actors = [builder.build() for _ in range(6)]
+        drives = [
+            scene.create_drive(actors[i], sapien.Pose(), actors[i + 1], sapien.Pose())
+            for i in range(5)
+        ]
+        scene.step()
+
+        scene.remove_actor(actors[1])
+        scene.remove_drive(drives[3])
+        scene.step()
+        remaining = set(a.get_id() for a in scene.get_all_actors())
+        self.assertEqual(remaining, set(a.get_id() for i, a in enumerate(actors) if i != 1))
+
+        # the drives of the removed actor are gone, the other drives still work
+        drives[4].set_x_properties(100, 10)
+        scene.remove_actor(actors[5])
+        scene.remove_actor(actors[0])
+        scene.step()
+        self.assertEqual(len(scene.get_all_actors()), 3)
+
+    def test_id_lookup(self):
+        engine = sapien.Engine()
+        engine.set_renderer(sapien.NullRenderer())
+        scene = engine.create_scene()
+        scene.add_ground(0, render=False)
+        builder = scene.create_actor_builder()
+        builder.add_box_collision(half_size=[0.1, 0.1, 0.1])
+        actors = []
+        for i in range(50):
+            builder.add_box_visual(half_size=[0.1, 0.1, 0.1], name=f"visual{i}")
+            actor = builder.build()
+            actor.set_pose(sapien.Pose([i, 0, 0.1]))
+            actors.append(actor)
+        loader = scene.create_urdf_loader()
+        robot = loader.load(os.path.join(os.path.dirname(__file__), "movo_simple.urdf"))
+        for _ in range(5):
+            scene.step()
+        self.assertGreater(len(scene.get_contacts()), 0)
+
+        for a in actors:
+            self.assertEqual(scene.find_actor_by_id(a.get_id()).get_id(), a.get_id())
+        for link in robot.get_links():
+            self.assertEqual(scene.find_articulation_link_by_link_id(link.get_id()).get_id(),
+                             link.get_id())
+        self.assertIsNone(scene.find_actor_by_id(max(a.get_id() for a in actors) + 1000))
+        names = scene.render_id_to_visual_name
+        visual = actors[7].get_visual_bodies()[-1]
+        self.assertEqual(names[visual.get_visual_id()], visual.get_name())
+
+        # removed actors leave the id tables, their contacts and the visual names
+        removed = actors[::2]
+        removed_ids = [a.get_id() for a in removed]
+        removed_visuals = [a.get_visual_bodies()[-1].get_visual_id() for a in removed]
+        for a in removed:
+            scene.remove_actor(a)
+        scene.step()
+        for i in removed_ids:
+            self.assertIsNone(scene.find_actor_by_id(i))
+        for a in actors[1::2]:
+            self.assertIsNotNone(scene.find_actor_by_id(a.get_id()))
+        names = scene.render_id_to_visual_name
+        for v in removed_visuals:
+            self.assertNotIn(v, names)
+        for c in scene.get_contacts():
+            self.assertNotIn(c.actor0.get_id(), removed_ids)
+            self.assertNotIn(c.actor1.get_id(), removed_ids)
+
+    def test_object_pool(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        builder = scene.create_actor_builder()
+        builder.add_box_collision(half_size=[0.1, 0.1, 0.1])
+        actor = builder.build()
+        actor.set_pose(sapien.Pose([0, 0, 1]))
+        other = builder.build()
+        scene.create_drive(actor, sapien.Pose(), other, sapien.Pose())
+
+        # a spinning actor waits for its gyroscopic torque, deactivating it drops that work
+        actor.set_angular_velocity([0, 0, 1])
+        scene.deactivate_actor(actor)
+        self.assertFalse(scene.is_active(actor))
+        self.assertEqual(scene.inactive_actor_count, 1)
+        self.assertNotIn(actor.get_id(), [a.get_id() for a in scene.get_all_actors()])
+        self.assertIsNone(scene.find_actor_by_id(actor.get_id()))
+        scene.step()
+
+        # reuse is opt-in
+        fresh = builder.build()
+        self.assertEqual(scene.inactive_actor_count, 1)
+
+        old_id = actor.get_id()
+        steps = []
+        actor.on_step(lambda a, t: steps.append(t))
+        reused = builder.build(name="reused", reuse=True)
+        self.assertEqual(reused.get_name(), "reused")
+        self.assertGreater(reused.get_id(), fresh.get_id())
+        self.assertIsNone(scene.find_actor_by_id(old_id))
+        self.assertEqual(scene.find_actor_by_id(reused.get_id()).get_name(), "reused")
+        self.assertTrue(scene.is_active(actor))
+        self.assertEqual(scene.inactive_actor_count, 0)
+        self.assertAlmostEqual(actor.pose.p[2], 0)
+        scene.step()
+        self.assertEqual(steps, [])
+
+        scene.deactivate_actor(actor)
+        scene.activate_actor(actor, sapien.Pose([0, 0, 2]))
+        self.assertAlmostEqual(actor.pose.p[2], 2)
+        scene.step()
+        self.assertLess(actor.pose.p[2], 2)
+
+        # a modified builder does not reuse stale actors
+        scene.deactivate_actor(actor)
+        builder.add_sphere_collision(radius=0.1)
+        self.assertEqual(scene.inactive_actor_count, 1)
+        builder.build(reuse=True)
+        self.assertEqual(scene.inactive_actor_count, 1)
+        scene.clear_inactive_objects()
+        scene.step()
+        self.assertEqual(scene.inactive_actor_count, 0)
+
+    def test_step_callbacks(self):
+        engine = sapien.Engine()
+        scene = engine.create_scene()
+        scene.add_ground(0, render=False)
+        builder = scene.create_actor_builder()
+        builder.add_box_collision(half_size=[0.1, 0.1, 0.1])
+        passive = [builder.build() for _ in range(10)]
+        actor = builder.build()
+        actor.set_pose(sapien.Pose([0, 0, 0.1]))
+
+        steps = []
+        contacts = []
+        actor.on_step(lambda a, t: steps.append((a.get_id(), t)))
+        actor.on_contact(lambda a, other, c: contacts.append(other.get_id()))
+        for _ in range(3):
+            scene.step()
+        self.assertEqual(len(steps), 3)
+        self.assertEqual(steps[0][0], actor.get_id())
+        self.assertAlmostEqual(steps[0][1], scene.get_timestep())
+        self.assertGreater(len(contacts), 0)
+
+        scene.remove_actor(actor)
+        scene.step()
+        scene.step()
+        self.assertEqual(len(steps), 3)
 
     def test_actor_builder(self):
         engine = sapien.Engine()